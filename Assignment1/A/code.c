@@ -1,6 +1,16 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <math.h>
+#include <string.h>
+
+#include "../../common/arena.h"
+#include "../../common/bw_profile.h"
+#include "../../common/perf_counters.h"
+#include "../../common/tile_order.h"
+
+#define NUM_METHODS 7
 
 // --- Access Patterns ---
 
@@ -56,70 +66,156 @@ void add_blocked(double *a, double *b, double *c, int n) {
     }
 }
 
-int main() {
+// 6. Blocked, with tiles visited along a curve (Hilbert / Morton) instead of row by row
+void add_blocked_curve(double *a, double *b, double *c, int n, const int *order) {
+    int BLOCK = 64;
+    int tiles = (n + BLOCK - 1) / BLOCK;
+    for (int t = 0; t < tiles * tiles; t++) {
+        int ii = (order[t] / tiles) * BLOCK;
+        int jj = (order[t] % tiles) * BLOCK;
+        for (int i = ii; i < ii + BLOCK && i < n; i++) {
+            for (int j = jj; j < jj + BLOCK && j < n; j++) {
+                int idx = i * n + j;
+                c[idx] = a[idx] + b[idx];
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
     int sizes[] = {256, 512, 1024, 2048};
     int num_sizes = 4;
 
+    // --hugepages: back a, b, c with huge pages to separate TLB pressure from cache misses
+    int use_huge = (argc > 1 && strcmp(argv[1], "--hugepages") == 0);
+    const char *csv_name = use_huge ? "results_hugepages.csv" : "results.csv";
+
+    // Achievable 'add' bandwidth for this machine (from Assignment1/Bandwidth)
+    static BwProfile profile;
+    int have_profile = (bw_profile_load_default(&profile) == 0);
+    if (!have_profile)
+        printf("No bandwidth profile found; run Assignment1/Bandwidth/stream for %%-of-peak columns.\n");
+
+    PerfCounter dtlb, llc;
+    if (perf_counter_open(&dtlb, PERF_DTLB_MISSES) != 0)
+        printf("dTLB miss counter unavailable; dTLB columns will be -1.\n");
+    if (perf_counter_open(&llc, PERF_LLC_MISSES) != 0)
+        printf("LLC miss counter unavailable; LLC columns will be -1.\n");
+
     // Open CSV file
-    FILE *fp = fopen("results.csv", "w");
+    FILE *fp = fopen(csv_name, "w");
     if (fp == NULL) {
         printf("Error opening file for writing!\n");
         return 1;
     }
 
     // Write CSV Header
-    fprintf(fp, "Size,RowMajor,ColMajor,1DFlat,Pointer,Blocked\n");
+    fprintf(fp, "Size,RowMajor,ColMajor,1DFlat,Pointer,Blocked,BlockedHilbert,BlockedMorton,Peak_GBps,"
+                "RowMajor_Pct,ColMajor_Pct,1DFlat_Pct,Pointer_Pct,Blocked_Pct,BlockedHilbert_Pct,BlockedMorton_Pct,"
+                "Pages,PageSize_KB,RowMajor_dTLB,ColMajor_dTLB,1DFlat_dTLB,Pointer_dTLB,Blocked_dTLB,"
+                "BlockedHilbert_dTLB,BlockedMorton_dTLB,RowMajor_LLC,ColMajor_LLC,1DFlat_LLC,Pointer_LLC,Blocked_LLC,"
+                "BlockedHilbert_LLC,BlockedMorton_LLC,Kernel_MinFlt,Kernel_MajFlt\n");
+
+    // One arena for the largest size; each slice is faulted in by this thread before anything is timed
+    size_t max_bytes = (size_t)sizes[num_sizes - 1] * sizes[num_sizes - 1] * sizeof(double);
+    Arena arena;
+    if (arena_init(&arena, max_bytes, 3, 1, use_huge) != 0) {
+        printf("Error reserving %zu MB!\n", (3 * max_bytes) >> 20);
+        return 1;
+    }
+    printf("Pages: %s (%zu KB)\n", page_kind_name(arena.mem.kind), arena.mem.page_size >> 10);
 
     // Print Console Table Header
-    printf("\nMatrix Addition Benchmark\n");
-    printf("+------------+--------------+--------------+--------------+--------------+--------------+\n");
-    printf("| %-10s | %-12s | %-12s | %-12s | %-12s | %-12s |\n", 
-           "Size (NxN)", "RowMaj (s)", "ColMaj (s)", "1D Flat (s)", "Pointer (s)", "Blocked (s)");
-    printf("+------------+--------------+--------------+--------------+--------------+--------------+\n");
+    printf("\nMatrix Addition Benchmark (%s)\n", use_huge ? "huge pages requested" : "4 KB pages");
+    printf("+------------+--------------+--------------+--------------+--------------+--------------+--------------+--------------+\n");
+    printf("| %-10s | %-12s | %-12s | %-12s | %-12s | %-12s | %-12s | %-12s |\n", 
+           "Size (NxN)", "RowMaj (s)", "ColMaj (s)", "1D Flat (s)", "Pointer (s)", "Blocked (s)", "Hilbert (s)", "Morton (s)");
+    printf("+------------+--------------+--------------+--------------+--------------+--------------+--------------+--------------+\n");
 
+    long long llc_rows[num_sizes][NUM_METHODS];
     for (int s = 0; s < num_sizes; s++) {
         int n = sizes[s];
         size_t bytes = n * n * sizeof(double);
         
-        double *a = (double*)malloc(bytes);
-        double *b = (double*)malloc(bytes);
-        double *c = (double*)malloc(bytes);
+        arena_reset(&arena);
+        double *a = (double*)arena_alloc(&arena, n, n * sizeof(double));
+        double *b = (double*)arena_alloc(&arena, n, n * sizeof(double));
+        double *c = (double*)arena_alloc(&arena, n, n * sizeof(double));
 
         // Initialize arrays
         for(int k=0; k<n*n; k++) { a[k] = 1.0; b[k] = 2.0; }
 
-        clock_t start, end;
-        double t_row, t_col, t_1d, t_ptr, t_blk;
+        int tiles = (n + 63) / 64;
+        int *order_hilbert = (int*)malloc(tiles * tiles * sizeof(int));
+        int *order_morton = (int*)malloc(tiles * tiles * sizeof(int));
+        tile_order_build(TILE_HILBERT, tiles, tiles, order_hilbert);
+        tile_order_build(TILE_MORTON, tiles, tiles, order_morton);
 
-        // Run Benchmarks
-        start = clock(); add_row_major(a, b, c, n); end = clock();
-        t_row = ((double)(end - start)) / CLOCKS_PER_SEC;
-
-        start = clock(); add_col_major(a, b, c, n); end = clock();
-        t_col = ((double)(end - start)) / CLOCKS_PER_SEC;
-
-        start = clock(); add_1d_flat(a, b, c, n); end = clock();
-        t_1d = ((double)(end - start)) / CLOCKS_PER_SEC;
-
-        start = clock(); add_pointer(a, b, c, n); end = clock();
-        t_ptr = ((double)(end - start)) / CLOCKS_PER_SEC;
-
-        start = clock(); add_blocked(a, b, c, n); end = clock();
-        t_blk = ((double)(end - start)) / CLOCKS_PER_SEC;
+        clock_t start, end;
+        double times[NUM_METHODS];
+        long long tlb[NUM_METHODS];
+        long long *llc_misses = llc_rows[s];
+
+        // Run Benchmarks (faults are counted around the whole set, outside every timer)
+        FaultCount faults_before = fault_snapshot();
+        for (int m = 0; m < NUM_METHODS; m++) {
+            perf_counter_start(&dtlb);
+            perf_counter_start(&llc);
+            start = clock();
+            switch (m) {
+            case 0: add_row_major(a, b, c, n); break;
+            case 1: add_col_major(a, b, c, n); break;
+            case 2: add_1d_flat(a, b, c, n); break;
+            case 3: add_pointer(a, b, c, n); break;
+            case 4: add_blocked(a, b, c, n); break;
+            case 5: add_blocked_curve(a, b, c, n, order_hilbert); break;
+            case 6: add_blocked_curve(a, b, c, n, order_morton); break;
+            }
+            end = clock();
+            llc_misses[m] = perf_counter_stop(&llc);
+            tlb[m] = perf_counter_stop(&dtlb);
+            times[m] = ((double)(end - start)) / CLOCKS_PER_SEC;
+        }
+        FaultCount faults = fault_delta(faults_before, fault_snapshot());
 
         // 1. Print formatted row to Console
-        printf("| %-10d | %12.6f | %12.6f | %12.6f | %12.6f | %12.6f |\n", 
-               n, t_row, t_col, t_1d, t_ptr, t_blk);
-
-        // 2. Write raw data to CSV
-        fprintf(fp, "%d,%.6f,%.6f,%.6f,%.6f,%.6f\n", n, t_row, t_col, t_1d, t_ptr, t_blk);
-
-        free(a); free(b); free(c);
+        printf("| %-10d |", n);
+        for (int m = 0; m < NUM_METHODS; m++) printf(" %12.6f |", times[m]);
+        printf("\n");
+
+        // 2. Write raw data to CSV, plus each time as a % of the measured peak
+        //    (a, b read + c written = 3 arrays of traffic per call), then the
+        //    page size obtained, dTLB load misses and LLC read misses per method
+        double peak = have_profile ? bw_profile_peak(&profile, "add", 3 * (long long)bytes, 1) : 0.0;
+        double gb = 3.0 * bytes / 1e9;
+        fprintf(fp, "%d", n);
+        for (int m = 0; m < NUM_METHODS; m++) fprintf(fp, ",%.6f", times[m]);
+        fprintf(fp, ",%.3f", peak);
+        for (int m = 0; m < NUM_METHODS; m++)
+            fprintf(fp, ",%.2f", (peak > 0.0 && times[m] > 0.0) ? gb / times[m] / peak * 100.0 : NAN);
+        fprintf(fp, ",%s,%zu", page_kind_name(arena.mem.kind), arena.mem.page_size >> 10);
+        for (int m = 0; m < NUM_METHODS; m++) fprintf(fp, ",%lld", tlb[m]);
+        for (int m = 0; m < NUM_METHODS; m++) fprintf(fp, ",%lld", llc_misses[m]);
+        fprintf(fp, ",%ld,%ld\n", faults.minflt, faults.majflt);
+
+        free(order_hilbert); free(order_morton);
     }
 
-    printf("+------------+--------------+--------------+--------------+--------------+--------------+\n");
-    printf("Data saved to 'results.csv'. \n\n");
+    printf("+------------+--------------+--------------+--------------+--------------+--------------+--------------+--------------+\n");
+    // Tile order vs cache misses: row-major sweep, tiles row by row, tiles along the curves
+    printf("\nLLC read misses (-1: counter unavailable)\n");
+    printf("| %-10s | %-14s | %-14s | %-14s | %-14s |\n", "Size (NxN)", "RowMaj", "Blocked", "Hilbert", "Morton");
+    for (int s = 0; s < num_sizes; s++) {
+        printf("| %-10d | %14lld | %14lld | %14lld | %14lld |\n",
+               sizes[s], llc_rows[s][0], llc_rows[s][4], llc_rows[s][5], llc_rows[s][6]);
+    }
+    printf("Pre-fault (outside every timer): %ld minor / %ld major faults in %.4f s\n",
+           arena.prefault.minflt, arena.prefault.majflt, arena.prefault_sec);
+    printf("Data saved to '%s'. \n\n", csv_name);
 
     fclose(fp);
+    perf_counter_close(&dtlb);
+    perf_counter_close(&llc);
+    arena_destroy(&arena);
     return 0;
-}
\ No newline at end of file
+}
@@ -1,11 +1,25 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <time.h>
 #include <pthread.h>
+#include <math.h>
+#include <string.h>
+
+#include "../../common/arena.h"
+#include "../../common/bw_profile.h"
+#include "../../common/perf_counters.h"
+#include "../../common/tile_order.h"
 
 #define TILE_SIZE 64 
 
+static BwProfile profile;
+static int have_profile = 0;
+static PerfCounter llc, dtlb;
+static const char *pages = "4k";    // Page kind actually obtained for A, B, C
+static FaultCount faults_before;
+
 double get_time() {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
@@ -32,6 +46,7 @@ typedef struct {
     int N;
     double *A, *B, *C;
     int s_row, s_col;
+    const int *order;   // Tile order for the curve-ordered workers
 } ThreadData;
 
 void* worker_row_major(void* arg) {
@@ -60,6 +75,13 @@ void add_row_major_pthread(double *A, double *B, double *C, int N, int num_threa
     for (int t = 0; t < num_threads; t++) pthread_join(threads[t], NULL);
 }
 
+// Byte offsets of the row chunks add_row_major_pthread() gives each thread, for the arena's first touch
+void row_chunk_split(size_t *split, int N, int num_threads) {
+    int chunk = N / num_threads;
+    for (int t = 0; t < num_threads; t++) split[t] = (size_t)t * chunk * N * sizeof(double);
+    split[num_threads] = (size_t)N * N * sizeof(double);
+}
+
 void* worker_col_major(void* arg) {
     ThreadData* data = (ThreadData*)arg;
     for (int j = data->start; j < data->end; j++) {
@@ -190,61 +212,173 @@ void add_tiled_pthread(double *A, double *B, double *C, int N, int num_threads)
     }
 }
 
-int main() {
+// Starts the fault, LLC and dTLB counters and returns the start time
+double bench_start() {
+    faults_before = fault_snapshot();
+    perf_counter_start(&llc);
+    perf_counter_start(&dtlb);
+    return get_time();
+}
+
+// Stops the counters started by bench_start() and writes one CSV row
+void write_row(FILE *fp, int N, const char *method, int threads, double t) {
+    long long llc_misses = perf_counter_stop(&llc);
+    long long dtlb_misses = perf_counter_stop(&dtlb);
+    FaultCount faults = fault_delta(faults_before, fault_snapshot());
+    // Each add reads A, B and writes C: 3 matrices of traffic per call
+    long long bytes = 3LL * N * N * sizeof(double);
+    double gbps = bytes / t / 1e9;
+    double peak = have_profile ? bw_profile_peak(&profile, "add", bytes, threads) : 0.0;
+    fprintf(fp, "%d,%s,%d,%f,%.3f,%.2f,%lld,%s,%lld,%ld\n", N, method, threads, t, gbps,
+            peak > 0.0 ? gbps / peak * 100.0 : NAN, llc_misses, pages, dtlb_misses, faults.minflt);
+}
+
+// Same tile body as worker_tiled, but [start, end) is a segment of a tile curve
+void* worker_tiled_curve(void* arg) {
+    ThreadData* data = (ThreadData*)arg;
+    int tiles = (data->N + TILE_SIZE - 1) / TILE_SIZE;
+    for (int p = data->start; p < data->end; p++) {
+        int ii = (data->order[p] / tiles) * TILE_SIZE;
+        int jj = (data->order[p] % tiles) * TILE_SIZE;
+        for (int i = ii; i < ii + TILE_SIZE && i < data->N; i++) {
+            for (int j = jj; j < jj + TILE_SIZE && j < data->N; j++) {
+                int idx = i * data->N + j;
+                data->C[idx] = data->A[idx] + data->B[idx];
+            }
+        }
+    }
+    return NULL;
+}
+
+void add_tiled_curve_pthread(double *A, double *B, double *C, int N, const int *order, int num_threads) {
+    pthread_t threads[num_threads];
+    ThreadData thread_data[num_threads];
+    int tiles = (N + TILE_SIZE - 1) / TILE_SIZE;
+
+    for (int t = 0; t < num_threads; t++) {
+        tile_order_segment(tiles * tiles, t, num_threads, &thread_data[t].start, &thread_data[t].end);
+        thread_data[t].N = N;
+        thread_data[t].A = A; thread_data[t].B = B; thread_data[t].C = C;
+        thread_data[t].order = order;
+
+        if (thread_data[t].start < thread_data[t].end) {
+             pthread_create(&threads[t], NULL, worker_tiled_curve, &thread_data[t]);
+        } else {
+             threads[t] = 0;
+        }
+    }
+
+    for (int t = 0; t < num_threads; t++) {
+        if (threads[t] != 0) pthread_join(threads[t], NULL);
+    }
+}
+
+int main(int argc, char **argv) {
     int sizes[] = {256, 512, 1024, 2048}; 
     int num_sizes = 4;
     int max_threads = 200; 
 
-    FILE *fp = fopen("results_full_scaling.csv", "w");
+    // --hugepages: back A, B, C with huge pages to separate TLB pressure from cache misses
+    int use_huge = (argc > 1 && strcmp(argv[1], "--hugepages") == 0);
+    const char *csv_name = use_huge ? "results_full_scaling_hugepages.csv" : "results_full_scaling.csv";
+
+    FILE *fp = fopen(csv_name, "w");
     if (!fp) { perror("File open failed"); return 1; }
     
-    fprintf(fp, "Size,Method,Threads,Time_Sec\n");
+    have_profile = (bw_profile_load_default(&profile) == 0);
+    if (!have_profile)
+        printf("No bandwidth profile found; run Assignment1/Bandwidth/stream for %%-of-peak columns.\n");
+
+    if (perf_counter_open(&llc, PERF_LLC_MISSES) != 0)
+        printf("LLC miss counter unavailable; LLC_Misses will be -1.\n");
+    if (perf_counter_open(&dtlb, PERF_DTLB_MISSES) != 0)
+        printf("dTLB miss counter unavailable; dTLB_Misses will be -1.\n");
+
+    fprintf(fp, "Size,Method,Threads,Time_Sec,GBps,Pct_Peak,LLC_Misses,Pages,dTLB_Misses,MinFlt\n");
+
+    // One arena for the largest size; each slice is first touched by ncpu pinned threads
+    // over the row chunks the kernels use, before anything is timed
+    size_t max_bytes = (size_t)sizes[num_sizes - 1] * sizes[num_sizes - 1] * sizeof(double);
+    int ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu < 1) ncpu = 1;
+    Arena arena;
+    if (arena_init(&arena, max_bytes, 3, ncpu, use_huge) != 0) {
+        perror("Arena reservation failed");
+        return 1;
+    }
+    pages = page_kind_name(arena.mem.kind);
+    printf("Pages: %s (%zu KB)\n", pages, arena.mem.page_size >> 10);
     printf("Starting Pthread Benchmark (1 to %d threads)...\n", max_threads);
 
     for (int s = 0; s < num_sizes; s++) {
         int N = sizes[s];
         printf("Processing Size: %dx%d\n", N, N);
 
-        double *A = (double*)malloc(N * N * sizeof(double));
-        double *B = (double*)malloc(N * N * sizeof(double));
-        double *C = (double*)malloc(N * N * sizeof(double));
+        size_t bytes = (size_t)N * N * sizeof(double);
+        size_t split[ncpu + 1];
+        row_chunk_split(split, N, ncpu);
+        arena_reset(&arena);
+        double *A = (double*)arena_alloc_split(&arena, bytes, split);
+        double *B = (double*)arena_alloc_split(&arena, bytes, split);
+        double *C = (double*)arena_alloc_split(&arena, bytes, split);
         
         for(int i=0; i<N*N; i++) { A[i] = 1.0; B[i] = 2.0; }
 
+        int tiles = (N + TILE_SIZE - 1) / TILE_SIZE;
+        int *order_hilbert = (int*)malloc(tiles * tiles * sizeof(int));
+        int *order_morton = (int*)malloc(tiles * tiles * sizeof(int));
+        tile_order_build(TILE_HILBERT, tiles, tiles, order_hilbert);
+        tile_order_build(TILE_MORTON, tiles, tiles, order_morton);
+
         for (int th = 1; th <= max_threads; th++) {
             double start, end;
             if (th % 50 == 0) printf("  ... Thread %d\n", th);
 
-            start = get_time();
+            start = bench_start();
             add_row_major_pthread(A, B, C, N, th);
             end = get_time();
-            fprintf(fp, "%d,RowMajor,%d,%f\n", N, th, end - start);
+            write_row(fp, N, "RowMajor", th, end - start);
 
-            start = get_time();
+            start = bench_start();
             add_col_major_pthread(A, B, C, N, th);
             end = get_time();
-            fprintf(fp, "%d,ColMajor,%d,%f\n", N, th, end - start);
+            write_row(fp, N, "ColMajor", th, end - start);
 
-            start = get_time();
+            start = bench_start();
             add_numpy_pthread(A, B, C, N, N, 1, th);
             end = get_time();
-            fprintf(fp, "%d,NumpyStrided,%d,%f\n", N, th, end - start);
+            write_row(fp, N, "NumpyStrided", th, end - start);
 
-            start = get_time();
+            start = bench_start();
             add_morton_pthread(A, B, C, N, th);
             end = get_time();
-            fprintf(fp, "%d,Morton,%d,%f\n", N, th, end - start);
+            write_row(fp, N, "Morton", th, end - start);
 
-            start = get_time();
+            start = bench_start();
             add_tiled_pthread(A, B, C, N, th);
             end = get_time();
-            fprintf(fp, "%d,Tiled,%d,%f\n", N, th, end - start);
+            write_row(fp, N, "Tiled", th, end - start);
+
+            start = bench_start();
+            add_tiled_curve_pthread(A, B, C, N, order_hilbert, th);
+            end = get_time();
+            write_row(fp, N, "TiledHilbert", th, end - start);
+
+            start = bench_start();
+            add_tiled_curve_pthread(A, B, C, N, order_morton, th);
+            end = get_time();
+            write_row(fp, N, "TiledMorton", th, end - start);
         }
 
-        free(A); free(B); free(C);
+        free(order_hilbert); free(order_morton);
     }
 
+    printf("Pre-fault (outside every timer): %ld minor / %ld major faults in %.4f s\n",
+           arena.prefault.minflt, arena.prefault.majflt, arena.prefault_sec);
     fclose(fp);
-    printf("Benchmark Complete. Data saved to results_full_scaling.csv\n");
+    perf_counter_close(&llc);
+    perf_counter_close(&dtlb);
+    arena_destroy(&arena);
+    printf("Benchmark Complete. Data saved to %s\n", csv_name);
     return 0;
 }
@@ -0,0 +1,234 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "../../common/bw_profile.h"
+
+#define NTIMES 10                 // Best of NTIMES, as in STREAM
+#define MIN_BYTES_PER_TRIAL (64LL << 20)
+#define MIN_WS (8LL << 10)        // Smallest aggregate working set (8 KB)
+#define DEFAULT_MAX_WS (512LL << 20)
+
+// --- Kernels (STREAM names, plus read-only and write-only) ---
+enum { K_COPY, K_SCALE, K_ADD, K_TRIAD, K_READ, K_WRITE, NUM_KERNELS };
+
+static const char *kernel_names[NUM_KERNELS] = {"copy", "scale", "add", "triad", "read", "write"};
+static const int kernel_arrays[NUM_KERNELS]  = {2, 2, 3, 3, 1, 1};   // Arrays touched per element
+
+double get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// --- Cache Topology (from sysfs) ---
+long long cache_l1 = 32 << 10, cache_l2 = 1 << 20, cache_l3 = 8 << 20;
+
+long long read_cache_size(int index) {
+    char path[128], buf[32];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    long long kb = -1;
+    if (fgets(buf, sizeof(buf), fp)) kb = atoll(buf);
+    fclose(fp);
+    return kb * 1024;
+}
+
+void detect_caches() {
+    for (int idx = 0; idx < 8; idx++) {
+        char path[128], type[32] = {0};
+        int level = 0;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", idx);
+        FILE *fp = fopen(path, "r");
+        if (!fp) break;
+        if (fscanf(fp, "%d", &level) != 1) level = 0;
+        fclose(fp);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", idx);
+        fp = fopen(path, "r");
+        if (fp) { if (fscanf(fp, "%31s", type) != 1) type[0] = 0; fclose(fp); }
+        if (strcmp(type, "Instruction") == 0) continue;
+
+        long long size = read_cache_size(idx);
+        if (size <= 0) continue;
+        if (level == 1) cache_l1 = size;
+        else if (level == 2) cache_l2 = size;
+        else if (level == 3) cache_l3 = size;
+    }
+}
+
+// L1/L2 are private, so compare each thread's share against them; L3 is shared
+const char* level_name(long long ws, int threads) {
+    long long per_thread = ws / threads;
+    if (per_thread <= cache_l1) return "L1";
+    if (per_thread <= cache_l2) return "L2";
+    if (ws <= cache_l3) return "L3";
+    return "DRAM";
+}
+
+// --- Thread Data ---
+typedef struct {
+    int tid, threads, cpu;
+    long long start, end;     // Element range owned by this thread
+    int inner;                // Kernel passes per timed trial
+    double *a, *b, *c;
+    double sink;              // Keeps the read-only kernel alive
+    pthread_barrier_t *barrier;
+    double *times;            // [NUM_KERNELS][NTIMES], written by tid 0
+} ThreadData;
+
+void run_kernel(int k, ThreadData *d) {
+    double *a = d->a, *b = d->b, *c = d->c;
+    const double s = 3.0;
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;   // Independent chains, or read is latency-bound
+
+    for (int rep = 0; rep < d->inner; rep++) {
+        switch (k) {
+        case K_COPY:  for (long long i = d->start; i < d->end; i++) c[i] = a[i]; break;
+        case K_SCALE: for (long long i = d->start; i < d->end; i++) b[i] = s * c[i]; break;
+        case K_ADD:   for (long long i = d->start; i < d->end; i++) c[i] = a[i] + b[i]; break;
+        case K_TRIAD: for (long long i = d->start; i < d->end; i++) a[i] = b[i] + s * c[i]; break;
+        case K_READ: {
+            long long i = d->start;
+            for (; i + 4 <= d->end; i += 4) { s0 += a[i]; s1 += a[i+1]; s2 += a[i+2]; s3 += a[i+3]; }
+            for (; i < d->end; i++) s0 += a[i];
+            break;
+        }
+        case K_WRITE: for (long long i = d->start; i < d->end; i++) c[i] = s; break;
+        }
+    }
+    d->sink += s0 + s1 + s2 + s3;
+}
+
+void* worker(void* arg) {
+    ThreadData *d = (ThreadData*)arg;
+
+    // First touch from the pinned thread, so pages land next to the core that uses them
+    for (long long i = d->start; i < d->end; i++) {
+        d->a[i] = 1.0; d->b[i] = 2.0; d->c[i] = 0.0;
+    }
+
+    for (int k = 0; k < NUM_KERNELS; k++) {
+        for (int t = 0; t < NTIMES; t++) {
+            pthread_barrier_wait(d->barrier);
+            double start = get_time();
+            run_kernel(k, d);
+            pthread_barrier_wait(d->barrier);
+            if (d->tid == 0) d->times[k * NTIMES + t] = get_time() - start;
+        }
+    }
+    return NULL;
+}
+
+// Runs every kernel over `ws` bytes (aggregate, 3 arrays) and fills gbps[NUM_KERNELS]
+void measure(double *a, double *b, double *c, long long ws, int threads, int ncpu, double *gbps) {
+    long long n = ws / (3 * (long long)sizeof(double));
+    int inner = (int)(MIN_BYTES_PER_TRIAL / ws);
+    if (inner < 1) inner = 1;
+
+    pthread_t th[threads];
+    ThreadData td[threads];
+    double times[NUM_KERNELS * NTIMES];
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, threads);
+
+    for (int t = 0; t < threads; t++) {
+        td[t].tid = t;
+        td[t].threads = threads;
+        td[t].cpu = t % ncpu;
+        td[t].start = n * t / threads;
+        td[t].end = n * (t + 1) / threads;
+        td[t].inner = inner;
+        td[t].a = a; td[t].b = b; td[t].c = c;
+        td[t].sink = 0.0;
+        td[t].barrier = &barrier;
+        td[t].times = times;
+
+        pthread_attr_t attr;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(td[t].cpu, &set);
+        pthread_attr_init(&attr);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        pthread_create(&th[t], &attr, worker, &td[t]);
+        pthread_attr_destroy(&attr);
+    }
+    for (int t = 0; t < threads; t++) pthread_join(th[t], NULL);
+    pthread_barrier_destroy(&barrier);
+
+    for (int k = 0; k < NUM_KERNELS; k++) {
+        double best = 1e30;
+        for (int t = 1; t < NTIMES; t++)        // First trial is warm-up
+            if (times[k * NTIMES + t] < best) best = times[k * NTIMES + t];
+        double bytes = (double)kernel_arrays[k] * n * sizeof(double) * inner;
+        gbps[k] = bytes / best / 1e9;
+    }
+}
+
+int main(int argc, char **argv) {
+    long long max_ws = (argc > 1) ? atoll(argv[1]) << 20 : DEFAULT_MAX_WS;
+    int ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu < 1) ncpu = 1;
+    detect_caches();
+
+    int thread_counts[32], num_threads = 0;
+    for (int t = 1; t < ncpu; t *= 2) thread_counts[num_threads++] = t;
+    thread_counts[num_threads++] = ncpu;
+
+    printf("STREAM-style Bandwidth Suite\n");
+    printf("CPUs: %d | L1d: %lld KB | L2: %lld KB | L3: %lld KB | Max working set: %lld MB\n",
+           ncpu, cache_l1 >> 10, cache_l2 >> 10, cache_l3 >> 10, max_ws >> 20);
+
+    long long max_n = max_ws / (3 * (long long)sizeof(double));
+    double *a = (double*)aligned_alloc(64, ((max_n * sizeof(double) + 63) / 64) * 64);
+    double *b = (double*)aligned_alloc(64, ((max_n * sizeof(double) + 63) / 64) * 64);
+    double *c = (double*)aligned_alloc(64, ((max_n * sizeof(double) + 63) / 64) * 64);
+    if (!a || !b || !c) { printf("Error: could not allocate %lld MB\n", max_ws >> 20); return 1; }
+
+    FILE *fp = fopen("results.csv", "w");
+    if (!fp) { perror("File open failed"); return 1; }
+    fprintf(fp, "Level,Bytes,Kernel,Threads,GBps\n");
+
+    static BwProfile profile;
+    bw_profile_init(&profile);
+
+    printf("+-------+------------+---------+----------+----------+----------+----------+----------+----------+\n");
+    printf("| %-5s | %-10s | %-7s | %-8s | %-8s | %-8s | %-8s | %-8s | %-8s |\n",
+           "Level", "WS (KB)", "Threads", "copy", "scale", "add", "triad", "read", "write");
+    printf("+-------+------------+---------+----------+----------+----------+----------+----------+----------+\n");
+
+    for (long long ws = MIN_WS; ws <= max_ws; ws *= 4) {
+        for (int ti = 0; ti < num_threads; ti++) {
+            int threads = thread_counts[ti];
+            if (ws / (3 * (long long)sizeof(double)) < threads * 8) continue;
+
+            double gbps[NUM_KERNELS];
+            measure(a, b, c, ws, threads, ncpu, gbps);
+            const char *level = level_name(ws, threads);
+
+            printf("| %-5s | %10lld | %7d |", level, ws >> 10, threads);
+            for (int k = 0; k < NUM_KERNELS; k++) {
+                printf(" %8.2f |", gbps[k]);
+                fprintf(fp, "%s,%lld,%s,%d,%.3f\n", level, ws, kernel_names[k], threads, gbps[k]);
+                bw_profile_add(&profile, level, kernel_names[k], ws, threads, gbps[k]);
+            }
+            printf("\n");
+        }
+    }
+    printf("+-------+------------+---------+----------+----------+----------+----------+----------+----------+\n");
+
+    fclose(fp);
+    if (bw_profile_save(BW_PROFILE_FILE, &profile) != 0) {
+        perror("Profile write failed");
+        return 1;
+    }
+    printf("GB/s saved to 'results.csv', machine profile saved to '%s'.\n", BW_PROFILE_FILE);
+
+    free(a); free(b); free(c);
+    return 0;
+}
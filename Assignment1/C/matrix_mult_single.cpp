@@ -9,6 +9,10 @@
 #include <functional>
 #include <string>
 
+#include "../../common/counter_rng.h"
+#include "../../common/perf_counters.h"
+#include "../../common/tile_order.h"
+
 using namespace std;
 using namespace std::chrono;
 
@@ -51,15 +55,12 @@ public:
         }
     }
 
-    // Initialize with random values
-    void initialize()
+    // Initialize with random values in [0, 10): element (i, j) is draw i * size + j of `key`
+    void initialize(uint64_t key)
     {
         for (int i = 0; i < size; i++)
         {
-            for (int j = 0; j < size; j++)
-            {
-                data[i][j] = static_cast<double>(rand()) / RAND_MAX * 10.0;
-            }
+            rng_fill_double(data[i], size, key, (uint64_t)i * size, 0.0, 10.0, 1);
         }
     }
 
@@ -211,6 +212,44 @@ void pattern4_blocked(const Matrix &A, const Matrix &B, Matrix &C, int blockSize
     }
 }
 
+// Blocked, with the (ii, jj) tiles of C visited along a Hilbert / Morton curve
+// so consecutive tiles share a row panel of A or a column panel of B
+void pattern4_blocked_curve(const Matrix &A, const Matrix &B, Matrix &C, int blockSize, TileOrderKind kind)
+{
+    int n = A.getSize();
+    C.clear();
+
+    blockSize = min(blockSize, n);
+    int tiles = (n + blockSize - 1) / blockSize;
+    vector<int> order(tiles * tiles);
+    tile_order_build(kind, tiles, tiles, order.data());
+
+    for (int t = 0; t < tiles * tiles; t++)
+    {
+        int ii = (order[t] / tiles) * blockSize;
+        int jj = (order[t] % tiles) * blockSize;
+
+        for (int kk = 0; kk < n; kk += blockSize)
+        {
+            int i_end = min(ii + blockSize, n);
+            int j_end = min(jj + blockSize, n);
+            int k_end = min(kk + blockSize, n);
+
+            for (int i = ii; i < i_end; i++)
+            {
+                for (int k = kk; k < k_end; k++)
+                {
+                    double aik = A(i, k);
+                    for (int j = jj; j < j_end; j++)
+                    {
+                        C(i, j) += aik * B(k, j);
+                    }
+                }
+            }
+        }
+    }
+}
+
 // Manual loop unrolling for better instruction-level parallelism
 void pattern5_simd(const Matrix &A, const Matrix &B, Matrix &C)
 {
@@ -364,12 +403,16 @@ double measure_time_blocked(function<void(const Matrix &, const Matrix &, Matrix
 
 int main()
 {
-    srand(42);
+    const uint64_t seed = 42;
 
     vector<int> dimensions = {256, 512, 1024, 2048};
     vector<int> blockSizes = {16, 32, 64, 128, 256};
 
-    vector<vector<double>> timingResults(6, vector<double>(dimensions.size(), 0.0));
+    vector<vector<double>> timingResults(8, vector<double>(dimensions.size(), 0.0));
+
+    PerfCounter llc;
+    if (perf_counter_open(&llc, PERF_LLC_MISSES) != 0)
+        cout << "LLC miss counter unavailable; misses reported as -1." << endl;
 
     cout << "=================================================================" << endl;
     cout << "      SINGLE-THREADED MATRIX MULTIPLICATION BENCHMARK" << endl;
@@ -381,6 +424,8 @@ int main()
     cout << "  4. Blocked/Tiled (Cache-aware)" << endl;
     cout << "  5. SIMD Optimized with Loop Unrolling" << endl;
     cout << "  6. Register Blocking" << endl;
+    cout << "  7. Blocked, Hilbert tile order" << endl;
+    cout << "  8. Blocked, Morton tile order" << endl;
     cout << "=================================================================" << endl;
 
     // Test each matrix dimension
@@ -393,8 +438,8 @@ int main()
         cout << "===============================================" << endl;
 
         Matrix A(n), B(n), C_ref(n), C_test(n);
-        A.initialize();
-        B.initialize();
+        A.initialize(rng_key(seed, 2 * n));
+        B.initialize(rng_key(seed, 2 * n + 1));
 
         cout << "\nInitializing matrices..." << endl;
         cout << "Memory usage per matrix: "
@@ -465,6 +510,24 @@ int main()
         cout << "  → Optimal block size: " << best_block_size
              << " (Time: " << best_time_blocked << "s)" << endl;
 
+        // Patterns 7/8: same kernel at the best block size, tiles in curve order
+        cout << "\n--- Pattern 4 Tile Order (block size " << best_block_size << ") ---" << endl;
+        TileOrderKind orders[] = {TILE_ROW_MAJOR, TILE_HILBERT, TILE_MORTON};
+        for (int o = 0; o < 3; o++)
+        {
+            TileOrderKind kind = orders[o];
+            perf_counter_start(&llc);
+            double time = measure_time_blocked(
+                [kind](const Matrix &A, const Matrix &B, Matrix &C, int bs) { pattern4_blocked_curve(A, B, C, bs, kind); },
+                A, B, C_test, best_block_size, 2);
+            long long misses = perf_counter_stop(&llc);
+            cout << "  " << setw(8) << left << tile_order_name(kind) << right << ": "
+                 << fixed << setprecision(4) << time << " seconds, LLC misses: " << misses
+                 << (C_test.equals(C_ref) ? " ✓" : " ✗ (Verification failed)") << endl;
+            if (kind != TILE_ROW_MAJOR)
+                timingResults[kind == TILE_HILBERT ? 6 : 7][dim_idx] = time;
+        }
+
         // Pattern 5: SIMD Optimized
         cout << "\n--- Pattern 5: SIMD Optimized ---" << endl;
         timingResults[4][dim_idx] = measure_time(pattern5_simd, A, B, C_test, 2);
@@ -503,17 +566,22 @@ int main()
              << timingResults[0][dim_idx] / timingResults[4][dim_idx] << "x speedup)" << endl;
         cout << "Pattern 6 (Register Blocking):   " << timingResults[5][dim_idx] << "s  ("
              << timingResults[0][dim_idx] / timingResults[5][dim_idx] << "x speedup)" << endl;
+        cout << "Pattern 7 (Blocked, Hilbert):    " << timingResults[6][dim_idx] << "s  ("
+             << timingResults[0][dim_idx] / timingResults[6][dim_idx] << "x speedup)" << endl;
+        cout << "Pattern 8 (Blocked, Morton):     " << timingResults[7][dim_idx] << "s  ("
+             << timingResults[0][dim_idx] / timingResults[7][dim_idx] << "x speedup)" << endl;
     }
 
     // Generate CSV file for plotting
     ofstream csv_file("matrix_mult_single_thread_results.csv");
     csv_file << "MatrixSize,Pattern1_ijk,Pattern2_ikj,Pattern3_jik,"
-             << "Pattern4_Blocked,Pattern5_SIMD,Pattern6_RegBlock" << endl;
+             << "Pattern4_Blocked,Pattern5_SIMD,Pattern6_RegBlock,"
+             << "Pattern7_Hilbert,Pattern8_Morton" << endl;
 
     for (int i = 0; i < dimensions.size(); i++)
     {
         csv_file << dimensions[i];
-        for (int j = 0; j < 6; j++)
+        for (int j = 0; j < 8; j++)
         {
             csv_file << "," << fixed << setprecision(6) << timingResults[j][i];
         }
@@ -530,13 +598,15 @@ int main()
          << setw(12) << "Pattern3"
          << setw(12) << "Pattern4"
          << setw(12) << "Pattern5"
-         << setw(12) << "Pattern6" << endl;
+         << setw(12) << "Pattern6"
+         << setw(12) << "Pattern7"
+         << setw(12) << "Pattern8" << endl;
     cout << "-----------------------------------------------------------------" << endl;
 
     for (int i = 0; i < dimensions.size(); i++)
     {
         cout << setw(10) << dimensions[i] << "x" << dimensions[i];
-        for (int j = 0; j < 6; j++)
+        for (int j = 0; j < 8; j++)
         {
             cout << setw(12) << fixed << setprecision(4) << timingResults[j][i];
         }
@@ -547,5 +617,6 @@ int main()
     cout << "Use the Python script to generate performance plots." << endl;
     cout << "=================================================================" << endl;
 
+    perf_counter_close(&llc);
     return 0;
 }
\ No newline at end of file
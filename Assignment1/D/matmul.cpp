@@ -1,6 +1,11 @@
 #include <bits/stdc++.h>
 #include <pthread.h>
 #include <cblas.h>
+
+#include "../../common/arena.h"
+#include "../../common/counter_rng.h"
+#include "../../common/perf_counters.h"
+#include "../../common/tile_order.h"
 using namespace std;
 
 static const int MAXN = 2048;
@@ -23,12 +28,17 @@ struct ThreadData {
 /* ================= MASTER MATRIX ================= */
 vector<double> MASTER;
 
+/* ================= TILE ORDERS (rebuilt per N) ================= */
+vector<int> ORDER_HILBERT, ORDER_MORTON;
+
+/* ================= LLC / dTLB MISS COUNTERS ================= */
+PerfCounter LLC, DTLB;
+string PAGES = "4k";   // Page kind actually obtained for the matrices
+
 /* ================= UTIL ================= */
 void init_master() {
     MASTER.resize(MAXN * MAXN);
-    srand(0);
-    for (auto &x : MASTER)
-        x = rand() / (double)RAND_MAX;
+    rng_fill_double(MASTER.data(), MASTER.size(), rng_key(0, 0), 0, 0.0, 1.0, thread::hardware_concurrency());
 }
 
 void extract_submatrix(double *dst, int N) {
@@ -177,6 +187,41 @@ void* mm_2d_tiled_parallel(void *arg) {
     return nullptr;
 }
 
+/* =====================================================
+   7/8. 2D Tiled Parallel, curve order
+   Each thread takes one contiguous segment of a Hilbert (or
+   Morton) walk over the C tiles, so its tiles - and the A row
+   panels / B column panels they read - stay close together.
+   ===================================================== */
+static void mm_2d_tiled_curve(ThreadData *d, const vector<int> &order) {
+    int tiles = (d->N + BS - 1) / BS;
+    int begin, end;
+    tile_order_segment(tiles*tiles, d->tid, d->threads, &begin, &end);
+
+    for (int p = begin; p < end; p++) {
+        int ii = (order[p] / tiles) * BS;
+        int jj = (order[p] % tiles) * BS;
+
+        for (int kk = 0; kk < d->N; kk += BS)
+            for (int i = ii; i < min(ii+BS, d->N); i++)
+                for (int k = kk; k < min(kk+BS, d->N); k++) {
+                    double aik = d->A[i*d->N+k];
+                    for (int j = jj; j < min(jj+BS, d->N); j++)
+                        d->C[i*d->N+j] += aik * d->B[k*d->N+j];
+                }
+    }
+}
+
+void* mm_2d_tiled_hilbert(void *arg) {
+    mm_2d_tiled_curve((ThreadData*)arg, ORDER_HILBERT);
+    return nullptr;
+}
+
+void* mm_2d_tiled_morton(void *arg) {
+    mm_2d_tiled_curve((ThreadData*)arg, ORDER_MORTON);
+    return nullptr;
+}
+
 /* ================= RUNNER ================= */
 void run(const string &name, void* (*fn)(void*),
          double *A, double *B, double *BT,
@@ -187,6 +232,9 @@ void run(const string &name, void* (*fn)(void*),
     vector<ThreadData> td(threads);
     zero(C, N);
 
+    FaultCount faults_before = fault_snapshot();
+    perf_counter_start(&LLC);
+    perf_counter_start(&DTLB);
     double t0 = now();
     for (int i = 0; i < threads; i++) {
         td[i] = {i, threads, N, A, B, BT, C};
@@ -194,35 +242,65 @@ void run(const string &name, void* (*fn)(void*),
     }
     for (auto &t : th) pthread_join(t, nullptr);
     double t1 = now();
+    long long llc_misses = perf_counter_stop(&LLC);
+    long long dtlb_misses = perf_counter_stop(&DTLB);
+    FaultCount faults = fault_delta(faults_before, fault_snapshot());
 
     double err = max_abs_diff(C, Cref, N);
     if (err > EPS)
         cout << "ERROR in " << name << " N=" << N << " err=" << err << endl;
 
-    out << name << "," << N << "," << threads << "," << (t1 - t0) << "\n";
+    out << name << "," << N << "," << threads << "," << (t1 - t0) << "," << llc_misses
+        << "," << PAGES << "," << dtlb_misses << "," << faults.minflt << "\n";
 }
 
 /* ================= MAIN ================= */
-int main() {
+int main(int argc, char **argv) {
+    // --hugepages: back every matrix with huge pages to separate TLB pressure from cache misses
+    bool use_huge = (argc > 1 && string(argv[1]) == "--hugepages");
+    string csv_name = use_huge ? "results_hugepages.csv" : "results.csv";
+
     init_master();
+    if (perf_counter_open(&LLC, PERF_LLC_MISSES) != 0)
+        cout << "LLC miss counter unavailable; llc_misses will be -1" << endl;
+    if (perf_counter_open(&DTLB, PERF_DTLB_MISSES) != 0)
+        cout << "dTLB miss counter unavailable; dtlb_misses will be -1" << endl;
 
-    ofstream out("results.csv");
-    out << "method,N,threads,time\n";
+    ofstream out(csv_name);
+    out << "method,N,threads,time,llc_misses,pages,dtlb_misses,minflt\n";
 
     vector<int> sizes   = {256, 512, 1024, 2048};
     vector<int> threads = {1, 2, 4, 8, 16};
 
+    // One arena for five matrices of the largest size; each slice is first touched by pinned
+    // threads over the same tid * N / threads row bands the kernels use, before anything is timed
+    size_t max_bytes = sizeof(double) * sizes.back() * sizes.back();
+    Arena arena;
+    if (arena_init(&arena, max_bytes, 5, thread::hardware_concurrency(), use_huge) != 0) {
+        cout << "Could not reserve " << (5 * max_bytes >> 20) << " MB" << endl;
+        return 1;
+    }
+    PAGES = page_kind_name(arena.mem.kind);
+    cout << "Pages: " << PAGES << " (" << (arena.mem.page_size >> 10) << " KB)" << endl;
+
     for (int N : sizes) {
-        double *A = new double[N*N];
-        double *B = new double[N*N];
-        double *BT = new double[N*N];
-        double *C = new double[N*N];
-        double *Cref = new double[N*N];
+        arena_reset(&arena);
+        double *A = (double*)arena_alloc(&arena, N, sizeof(double)*N);
+        double *B = (double*)arena_alloc(&arena, N, sizeof(double)*N);
+        double *BT = (double*)arena_alloc(&arena, N, sizeof(double)*N);
+        double *C = (double*)arena_alloc(&arena, N, sizeof(double)*N);
+        double *Cref = (double*)arena_alloc(&arena, N, sizeof(double)*N);
 
         extract_submatrix(A, N);
         extract_submatrix(B, N);
         transpose(B, BT, N);
 
+        int tiles = (N + BS - 1) / BS;
+        ORDER_HILBERT.resize(tiles*tiles);
+        ORDER_MORTON.resize(tiles*tiles);
+        tile_order_build(TILE_HILBERT, tiles, tiles, ORDER_HILBERT.data());
+        tile_order_build(TILE_MORTON, tiles, tiles, ORDER_MORTON.data());
+
         zero(Cref, N);
         blas_reference(A, B, Cref, N);   // correctness reference
 
@@ -245,11 +323,21 @@ int main() {
             cout<<"Matmul for size "<<N<<" Threads "<<t<<"method 2d_tiled started "<<endl;
             run("2d_tiled_parallel", mm_2d_tiled_parallel, A, B, BT, C, Cref, N, t, out);
             cout<<"Matmul for size "<<N<<" Threads "<<t<<"method 2d_tiled end "<<endl;
+            cout<<"Matmul for size "<<N<<" Threads "<<t<<"method 2d_tiled_hilbert started "<<endl;
+            run("2d_tiled_hilbert", mm_2d_tiled_hilbert, A, B, BT, C, Cref, N, t, out);
+            cout<<"Matmul for size "<<N<<" Threads "<<t<<"method 2d_tiled_hilbert end "<<endl;
+            cout<<"Matmul for size "<<N<<" Threads "<<t<<"method 2d_tiled_morton started "<<endl;
+            run("2d_tiled_morton", mm_2d_tiled_morton, A, B, BT, C, Cref, N, t, out);
+            cout<<"Matmul for size "<<N<<" Threads "<<t<<"method 2d_tiled_morton end "<<endl;
         }
 
-        delete[] A; delete[] B; delete[] BT; delete[] C; delete[] Cref;
     }
 
+    cout << "Pre-fault (outside every timer): " << arena.prefault.minflt << " minor / "
+         << arena.prefault.majflt << " major faults in " << arena.prefault_sec << " s" << endl;
     out.close();
-    cout << "DONE. Results written to results.csv\n";
+    perf_counter_close(&LLC);
+    perf_counter_close(&DTLB);
+    arena_destroy(&arena);
+    cout << "DONE. Results written to " << csv_name << "\n";
 }
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "../common/counter_rng.h"
+#include "../common/parallel_reduce.h"
+
+#define SEED 2024
+#define NUM_THREADS 8
+#define RUNS 5          // Each time is the best of RUNS, so small N is not just noise
+#define NOISE_MARGIN 0.10   // Adaptive may be this much slower than the better path before a row is flagged
+#define NOISE_FLOOR 1e-6    // ... or this many seconds (timer resolution at small N)
+
+// Min and max in one pass, per-thread results padded, joined as a tree
+typedef Fused<MinOp<int>, MaxOp<int>> MinMaxOp;
+
+double get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Returns 1 if the adaptive time is above the better of sequential and threaded by more than the noise margin;
+// clears *ok if the threaded or adaptive min / max differs from the sequential one
+int run_comparison(int N, const ReduceCrossover& crossover, int *ok) {
+    int *arr = (int*)malloc(N * sizeof(int));
+    // Same array for a given N on every run and for any number of fill threads
+    rng_fill_int32(arr, N, rng_key(SEED, N), 0, 0, 99999999, sysconf(_SC_NPROCESSORS_ONLN));
+
+    // --- SEQUENTIAL EXECUTION ---
+    int seq_min = INT_MAX, seq_max = INT_MIN;
+    double time_seq = 1e30;
+    for (int run = 0; run < RUNS; run++) {
+        seq_min = INT_MAX, seq_max = INT_MIN;
+        double start_seq = get_time();
+        for (int i = 0; i < N; i++) {
+            if (arr[i] < seq_min) seq_min = arr[i];
+            if (arr[i] > seq_max) seq_max = arr[i];
+        }
+        double end_seq = get_time();
+        if (end_seq - start_seq < time_seq) time_seq = end_seq - start_seq;
+    }
+
+    // --- MULTITHREADED EXECUTION ---
+    int thread_min = 0, thread_max = 0;
+    double time_thread = 1e30;
+    for (int run = 0; run < RUNS; run++) {
+        double start_thread = get_time();
+        MinMaxOp::result_type result = parallel_reduce<int, MinMaxOp>(arr, N, NUM_THREADS);
+        thread_min = std::get<0>(result), thread_max = std::get<1>(result);
+        double end_thread = get_time();
+        if (end_thread - start_thread < time_thread) time_thread = end_thread - start_thread;
+    }
+
+    // --- ADAPTIVE: sequential or a team, per the calibrated crossover ---
+    int team = 1;
+    MinMaxOp::result_type adaptive;
+    double time_adaptive = 1e30;
+    for (int run = 0; run < RUNS; run++) {
+        double start_adaptive = get_time();
+        adaptive = parallel_reduce_adaptive<int, MinMaxOp>(arr, N, crossover, &team);
+        double end_adaptive = get_time();
+        if (end_adaptive - start_adaptive < time_adaptive) time_adaptive = end_adaptive - start_adaptive;
+    }
+
+    char path[16];
+    if (team == 1) snprintf(path, sizeof(path), "seq");
+    else snprintf(path, sizeof(path), "%d thr", team);
+
+    double best = time_seq < time_thread ? time_seq : time_thread;
+    double allowed = best * (1.0 + NOISE_MARGIN) > best + NOISE_FLOOR ? best * (1.0 + NOISE_MARGIN) : best + NOISE_FLOOR;
+    int worse = time_adaptive > allowed;
+
+    // Output formatted for a table
+    printf("%-5d | %-5d | %-5d | %-5d | %-5d | %-10.7f | %-10.7f | %-10.7f | %-6s | %-5s\n", 
+           N, thread_min, thread_max, seq_min, seq_max, time_thread, time_seq, time_adaptive, path, worse ? "WORSE" : "ok");
+    if (thread_min != seq_min || thread_max != seq_max) {
+        printf("ERROR: threaded result differs for N = %d\n", N);
+        *ok = 0;
+    }
+    if (std::get<0>(adaptive) != seq_min || std::get<1>(adaptive) != seq_max) {
+        printf("ERROR: adaptive result differs for N = %d\n", N);
+        *ok = 0;
+    }
+
+    free(arr);
+    return worse;
+}
+
+int main() {
+    // Measured on the first run, then read back from reduce_crossover.csv
+    ReduceCrossover crossover = reduce_crossover_default(NUM_THREADS);
+    int worse_rows = 0;
+    int ok = 1;
+
+    int sizes1[] = {512, 1024, 2048, 4096, 8192};
+    int num_sizes = sizeof(sizes1) / sizeof(sizes1[0]);
+    
+    printf("For smaller N values, sequential performs better :\n\n");
+    printf("%-5s | %-5s | %-5s | %-5s | %-5s | %-10s | %-10s | %-10s | %-6s | %-5s\n", 
+           "N", "T-Min", "T-Max", "S-Min", "S-Max", "Time(Thr)", "Time(Seq)", "Time(Adp)", "Path", "Adp");
+    printf("------------------------------------------------------------------------------------------------------------\n");
+
+    for (int i = 0; i < num_sizes; i++) {
+        worse_rows += run_comparison(sizes1[i], crossover, &ok);
+    }
+
+    // -- 
+    printf("\n\n");
+
+    int sizes2[] = {5120000, 10240000, 20480000, 40960000, 81920000};
+    num_sizes = sizeof(sizes2) / sizeof(sizes2[0]);
+    
+    printf("For larger N values, threading performs better :\n\n");
+    printf("%-5s | %-5s | %-5s | %-5s | %-5s | %-10s | %-10s | %-10s | %-6s | %-5s\n", 
+           "N", "T-Min", "T-Max", "S-Min", "S-Max", "Time(Thr)", "Time(Seq)", "Time(Adp)", "Path", "Adp");
+    printf("------------------------------------------------------------------------------------------------------------\n");
+
+    for (int i = 0; i < num_sizes; i++) {
+        worse_rows += run_comparison(sizes2[i], crossover, &ok);
+    }
+
+    printf("\nAdaptive vs the better of sequential and threaded: ");
+    if (worse_rows == 0) printf("never more than %.0f%% (or %.0e s) slower at any N\n", NOISE_MARGIN * 100, NOISE_FLOOR);
+    else printf("%d row(s) flagged WORSE\n", worse_rows);
+
+    return ok ? 0 : 1;
+}
\ No newline at end of file
@@ -3,26 +3,14 @@
 #include <pthread.h>
 #include <time.h>
 #include <limits.h>
+#include <unistd.h>
 
-typedef struct {
-    int *arr;
-    int start;
-    int end;
-    int local_min;
-    int local_max;
-} ThreadData;
-
-void* find_min_max_thread(void* arg) {
-    ThreadData* data = (ThreadData*)arg;
-    int l_min = INT_MAX, l_max = INT_MIN;
-    for (int i = data->start; i < data->end; i++) {
-        if (data->arr[i] < l_min) l_min = data->arr[i];
-        if (data->arr[i] > l_max) l_max = data->arr[i];
-    }
-    data->local_min = l_min;
-    data->local_max = l_max;
-    return NULL;
-}
+#include "../common/counter_rng.h"
+#include "../common/parallel_reduce.h"
+
+#define SEED 2024
+
+typedef Fused<MinOp<int>, MaxOp<int>> MinMaxOp;
 
 double get_time() {
     struct timespec ts;
@@ -39,27 +27,12 @@ double run_bulk_experiment(int num_threads, int* sizes, int num_sizes, FILE* fil
 
     for (int i = 0; i < num_sizes; i++) {
         int N = sizes[i];
-        int *arr = malloc(N * sizeof(int));
-        for (int j = 0; j < N; j++) arr[j] = rand() % 1000000;
-
-        pthread_t threads[num_threads];
-        ThreadData t_data[num_threads];
-        int chunk = N / num_threads;
+        int *arr = (int*)malloc(N * sizeof(int));
+        rng_fill_int32(arr, N, rng_key(SEED, N), 0, 0, 999999, sysconf(_SC_NPROCESSORS_ONLN));
 
         double start = get_time();
-        for (int t = 0; t < num_threads; t++) {
-            t_data[t].arr = arr;
-            t_data[t].start = t * chunk;
-            t_data[t].end = (t == num_threads - 1) ? N : (t + 1) * chunk;
-            pthread_create(&threads[t], NULL, find_min_max_thread, &t_data[t]);
-        }
-
-        int g_min = INT_MAX, g_max = INT_MIN;
-        for (int t = 0; t < num_threads; t++) {
-            pthread_join(threads[t], NULL);
-            if (t_data[t].local_min < g_min) g_min = t_data[t].local_min;
-            if (t_data[t].local_max > g_max) g_max = t_data[t].local_max;
-        }
+        MinMaxOp::result_type result = parallel_reduce<int, MinMaxOp>(arr, N, num_threads);
+        int g_min = std::get<0>(result), g_max = std::get<1>(result);
         double end = get_time();
         double duration = end - start;
         total_time_for_config += duration;
@@ -75,6 +48,31 @@ double run_bulk_experiment(int num_threads, int* sizes, int num_sizes, FILE* fil
     return total_time_for_config;
 }
 
+// Same sizes, with the team picked per N from the calibrated crossover (sequential below it)
+double run_adaptive_experiment(const ReduceCrossover& crossover, int* sizes, int num_sizes) {
+    double total_time = 0;
+
+    printf("\n--- Results for adaptive team (up to %d Threads) ---\n", crossover.max_threads);
+    printf("%-10s | %-10s | %-10s | %-12s | %-7s\n", "N", "Min", "Max", "Time (s)", "Threads");
+
+    for (int i = 0; i < num_sizes; i++) {
+        int N = sizes[i];
+        int *arr = (int*)malloc(N * sizeof(int));
+        rng_fill_int32(arr, N, rng_key(SEED, N), 0, 0, 999999, sysconf(_SC_NPROCESSORS_ONLN));
+
+        int team = 1;
+        double start = get_time();
+        MinMaxOp::result_type result = parallel_reduce_adaptive<int, MinMaxOp>(arr, N, crossover, &team);
+        double end = get_time();
+        total_time += end - start;
+
+        printf("%-10d | %-10d | %-10d | %-12.7f | %-7d\n", N, std::get<0>(result), std::get<1>(result), end - start, team);
+
+        free(arr);
+    }
+    return total_time;
+}
+
 int main() {
     int sizes[] = {5120000, 10240000, 20480000, 40960000, 81920000};
     int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
@@ -108,7 +106,12 @@ int main() {
     printf("The best performing configuration was: %d Threads\n", best_thread_count);
     printf("==========================================================\n");
 
-    run_bulk_experiment(best_thread_count, sizes, num_sizes, stdout, 0);
+    double fixed_total = run_bulk_experiment(best_thread_count, sizes, num_sizes, stdout, 0);
+
+    // The best count is a compromise over all sizes; the crossover picks per size
+    ReduceCrossover crossover = reduce_crossover_default(best_thread_count);
+    double adaptive_total = run_adaptive_experiment(crossover, sizes, num_sizes);
+    printf("\nTotal: %.7f s with %d threads, %.7f s adaptive\n", fixed_total, best_thread_count, adaptive_total);
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <limits.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#include "../common/counter_rng.h"
+#include "../common/parallel_select.h"
+
+#define SEED 2024
+#define NUM_THREADS 8
+#define TOP_K 100
+#define SKETCH_TOLERANCE 0.5    // Rank error, % of N; about 5x the n / (2 * capacity) + sampling bound
+
+// Same arrays as prog1: top-k, median and p90/p99 instead of min and max.
+// The std:: columns run on a copy (std::nth_element reorders its input); the
+// copy is made before the clock starts.
+
+double get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Share of the array between the estimate's rank and the target rank, in percent
+double rank_error(const int* arr, int N, int estimate, size_t target) {
+    size_t below = 0, at_most = 0;
+    for (int i = 0; i < N; i++) {
+        below += arr[i] < estimate;
+        at_most += arr[i] <= estimate;
+    }
+    if (target >= below && target < at_most) return 0.0;
+    size_t off = target < below ? below - target : target - at_most + 1;
+    return 100.0 * off / N;
+}
+
+// Returns 1 if any result differs from the sorted copy, 0 otherwise
+int run_selection(int N, const std::vector<double>& qs) {
+    int *arr = (int*)malloc(N * sizeof(int));
+    rng_fill_int32(arr, N, rng_key(SEED, N), 0, 0, 99999999, sysconf(_SC_NPROCESSORS_ONLN));
+    std::vector<int> copy(arr, arr + N);
+    size_t mid = quantile_rank(0.5, N);
+
+    // --- Median ---
+    double t0 = get_time();
+    std::nth_element(copy.begin(), copy.begin() + mid, copy.end());
+    int std_median = copy[mid];
+    double time_std_median = get_time() - t0;
+
+    t0 = get_time();
+    int par_median = parallel_nth_element(arr, N, mid, NUM_THREADS);
+    double time_par_median = get_time() - t0;
+
+    // --- Quantiles: one std::nth_element each, every call narrowing the next ---
+    std::copy(arr, arr + N, copy.begin());
+    std::vector<int> std_q(qs.size());
+    t0 = get_time();
+    for (size_t j = 0; j < qs.size(); j++) {
+        size_t r = quantile_rank(qs[j], N);
+        std::nth_element(copy.begin(), copy.begin() + r, copy.end());
+        std_q[j] = copy[r];
+    }
+    double time_std_q = get_time() - t0;
+
+    t0 = get_time();
+    std::vector<int> par_q = parallel_quantiles(arr, N, qs, NUM_THREADS);
+    double time_par_q = get_time() - t0;
+
+    // --- Top-k ---
+    std::copy(arr, arr + N, copy.begin());
+    t0 = get_time();
+    std::nth_element(copy.begin(), copy.begin() + TOP_K, copy.end(), std::greater<int>());
+    std::sort(copy.begin(), copy.begin() + TOP_K, std::greater<int>());
+    double time_std_top = get_time() - t0;
+
+    t0 = get_time();
+    std::vector<int> par_top = parallel_top_k(arr, N, TOP_K, NUM_THREADS);
+    double time_par_top = get_time() - t0;
+
+    // --- Full sort, the old way of getting all of the above ---
+    std::copy(arr, arr + N, copy.begin());
+    t0 = get_time();
+    std::sort(copy.begin(), copy.end());
+    double time_sort = get_time() - t0;
+
+    printf("%-8d | %-9.5f | %-9.5f | %-9.5f | %-9.5f | %-9.5f | %-9.5f | %-9.5f\n",
+           N, time_sort, time_std_median, time_par_median, time_std_q, time_par_q, time_std_top, time_par_top);
+
+    // Verification against the sorted copy
+    int ok = 1;
+    if (std_median != copy[mid] || par_median != copy[mid]) {
+        printf("ERROR: median differs for N = %d\n", N);
+        ok = 0;
+    }
+    for (size_t j = 0; j < qs.size(); j++) {
+        int expected = copy[quantile_rank(qs[j], N)];
+        if (std_q[j] != expected || par_q[j] != expected) {
+            printf("ERROR: p%g differs for N = %d\n", qs[j] * 100, N);
+            ok = 0;
+        }
+    }
+    if (!std::equal(par_top.begin(), par_top.end(), copy.rbegin())) {
+        printf("ERROR: top-%d differs for N = %d\n", TOP_K, N);
+        ok = 0;
+    }
+
+    free(arr);
+    return ok ? 0 : 1;
+}
+
+// Returns 1 if any quantile's rank error is above SKETCH_TOLERANCE, 0 otherwise
+int run_sketch(int N, const std::vector<double>& qs) {
+    int *arr = (int*)malloc(N * sizeof(int));
+    rng_fill_int32(arr, N, rng_key(SEED, N), 0, 0, 99999999, sysconf(_SC_NPROCESSORS_ONLN));
+
+    double t0 = get_time();
+    QuantileSketch<int> sketch = parallel_sketch(arr, N, NUM_THREADS);
+    double time_sketch = get_time() - t0;
+
+    size_t items = 0;
+    for (const std::vector<int>& level : sketch.levels) items += level.size();
+    printf("%-8d | %-9.5f | %-8zu", N, time_sketch, items);
+    std::vector<double> errors;
+    for (double q : qs) {
+        errors.push_back(rank_error(arr, N, sketch.quantile(q), quantile_rank(q, N)));
+        printf(" | %-9.4f", errors.back());
+    }
+    printf("\n");
+    int ok = 1;
+    for (size_t j = 0; j < qs.size(); j++) {
+        if (errors[j] > SKETCH_TOLERANCE) {
+            printf("ERROR: p%g rank error %.4f%% above %g%% for N = %d\n", qs[j] * 100, errors[j], SKETCH_TOLERANCE, N);
+            ok = 0;
+        }
+    }
+
+    free(arr);
+    return ok ? 0 : 1;
+}
+
+int main() {
+    int sizes2[] = {5120000, 10240000, 20480000, 40960000, 81920000};
+    int num_sizes = sizeof(sizes2) / sizeof(sizes2[0]);
+    std::vector<double> qs = {0.5, 0.9, 0.99};
+    int status = 0;
+
+    printf("Exact selection, %d threads vs std:: (times in s; Q = p50, p90, p99):\n\n", NUM_THREADS);
+    printf("%-8s | %-9s | %-9s | %-9s | %-9s | %-9s | %-9s | %-9s\n",
+           "N", "Sort", "Med(std)", "Med(par)", "Q(std)", "Q(par)", "Top(std)", "Top(par)");
+    printf("----------------------------------------------------------------------------------------------\n");
+    for (int i = 0; i < num_sizes; i++) {
+        status |= run_selection(sizes2[i], qs);
+    }
+
+    printf("\n\nApproximate quantiles (QuantileSketch, capacity %d), rank error in %% of N:\n\n", SKETCH_CAPACITY);
+    printf("%-8s | %-9s | %-8s | %-9s | %-9s | %-9s\n", "N", "Time (s)", "Items", "p50 err", "p90 err", "p99 err");
+    printf("-----------------------------------------------------------------------\n");
+    for (int i = 0; i < num_sizes; i++) {
+        status |= run_sketch(sizes2[i], qs);
+    }
+
+    return status;
+}
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "../common/parallel_reduce.h"
+
+#define SIZE 50000
+#define THREADS 200
+#define RUNS 5
+
+int *array;
+
+/* ---------- Time Function ---------- */
+double get_time() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 0.000001;
+}
+
+/* Both approaches share the chunking and the per-thread loop of
+   parallel_reduce and differ only in how the partial sums are combined:
+   REDUCE_LOCKED - every thread adds its sum to one global under a mutex
+   REDUCE_TREE   - padded per-thread slots, combined along the join tree */
+
+/* ---------- MAIN ---------- */
+
+int main() {
+    array = (int*)malloc(SIZE * sizeof(int));
+
+    for (int i = 0; i < SIZE; i++)
+        array[i] = i;
+
+    printf("Expected Sum = 1249975000\n\n");
+
+    /* ===== APPROACH 1 ===== */
+    printf("Approach 1: Global sum with mutex\n");
+
+    for (int r = 1; r <= RUNS; r++) {
+        double start = get_time();
+
+        long long global_sum = parallel_reduce<int, SumOp<long long>>(array, SIZE, THREADS, REDUCE_LOCKED);
+
+        double end = get_time();
+
+        printf("Run %d | Sum = %lld | Time = %.6f sec\n",
+               r, global_sum, end - start);
+    }
+
+    /* ===== APPROACH 2 ===== */
+    printf("\nApproach 2: Thread local sum (faster)\n");
+
+    for (int r = 1; r <= RUNS; r++) {
+        double start = get_time();
+
+        long long total = parallel_reduce<int, SumOp<long long>>(array, SIZE, THREADS, REDUCE_TREE);
+
+        double end = get_time();
+
+        printf("Run %d | Sum = %lld | Time = %.6f sec\n",
+               r, total, end - start);
+    }
+
+    free(array);
+    return 0;
+}
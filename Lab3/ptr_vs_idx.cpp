@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "../common/parallel_reduce.h"
+
+#define SIZE 500000
+#define THREADS 200
+#define RUNS 5
+
+int *array;
+
+double get_time() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 0.000001;
+}
+
+/* Chunk loops for parallel_reduce_chunks: same split, slots and combine,
+   only the access pattern differs */
+
+long long sum_using_pointer(size_t start, size_t end) {
+    long long s = 0;
+
+    int *ptr = array + start;
+    for (size_t i = start; i < end; i++) {
+        s += *ptr;
+        ptr++;
+    }
+
+    return s;
+}
+
+
+
+long long sum_using_index(size_t start, size_t end) {
+    long long s = 0;
+
+    for (size_t i = start; i < end; i++) {
+        s += array[i];
+    }
+
+    return s;
+}
+
+
+int main() {
+    array = (int*)malloc(SIZE * sizeof(int));
+
+    for (int i = 0; i < SIZE; i++)
+        array[i] = i;
+
+    printf("Expected Sum = 1249975000\n\n");
+
+
+
+
+    printf("Approach 1: Pointer\n");
+
+    for (int r = 1; r <= RUNS; r++) {
+        double start = get_time();
+
+        long long total = parallel_reduce_chunks<SumOp<long long>>(SIZE, THREADS, sum_using_pointer);
+
+        double end = get_time();
+
+        printf("Run %d | Sum = %lld | Time = %.6f sec\n",
+               r, total, end - start);
+    }
+
+
+
+
+    printf("\nApproach 2: Indexing\n");
+
+    for (int r = 1; r <= RUNS; r++) {
+        double start = get_time();
+
+        long long total = parallel_reduce_chunks<SumOp<long long>>(SIZE, THREADS, sum_using_index);
+
+        double end = get_time();
+
+        printf("Run %d | Sum = %lld | Time = %.6f sec\n",
+               r, total, end - start);
+    }
+
+    free(array);
+    return 0;
+}
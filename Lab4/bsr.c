@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "sparse.h"
+#include "sched.h"
+#include "mtx.h"
+#include "bsr.h"
+
+#define BLOCK_ROWS 20000      // Generated matrix: block rows (and block columns)
+#define BLOCKS_PER_ROW 6      // Average dense blocks per block row
+#define NATURAL_B 4           // Block size of the generated matrix (degrees of freedom per node)
+#define ITERATIONS 10         // Timed y = A*x iterations per configuration
+
+enum { FMT_CSR, FMT_BSR2, FMT_BSR4, FMT_BSR8, NUM_FORMATS };
+static const char *format_names[NUM_FORMATS] = {"CSR", "BSR 2x2", "BSR 4x4", "BSR 8x8"};
+static const int format_b[NUM_FORMATS] = {1, 2, 4, 8};
+
+// FEM-like matrix: a random block pattern with every block dense b x b,
+// as produced by b unknowns per mesh node
+CSRMatrix generateBlockCSR(int block_rows, double blocks_per_row, int b, uint64_t seed, int n_threads) {
+    CSRMatrix P = generateSparseCSR(block_rows, block_rows, blocks_per_row / block_rows, seed, n_threads);
+    CSRMatrix M;
+    M.rows = M.cols = block_rows * b;
+    M.nnz = P.nnz * b * b;
+    M.row_ptr = (int*)malloc((M.rows + 1) * sizeof(int));
+    M.col_ind = (int*)malloc((size_t)M.nnz * sizeof(int));
+    M.values = (double*)malloc((size_t)M.nnz * sizeof(double));
+
+    int p = 0;
+    M.row_ptr[0] = 0;
+    for (int br = 0; br < block_rows; br++) {
+        for (int i = 0; i < b; i++) {
+            for (int k = P.row_ptr[br]; k < P.row_ptr[br+1]; k++) {
+                for (int j = 0; j < b; j++) {
+                    M.col_ind[p] = P.col_ind[k] * b + j;
+                    M.values[p] = 0.5 + rng_uniform(seed ^ STREAM_VALUES, p);
+                    p++;
+                }
+            }
+            M.row_ptr[br * b + i + 1] = p;
+        }
+    }
+    free_csr(&P);
+    return M;
+}
+
+void csr_row(int r, RowTask *task) {
+    BsrContext *c = (BsrContext*)task->ctx;
+    const CSRMatrix *A = c->csr;
+    double sum = 0.0;
+    for (int j = A->row_ptr[r]; j < A->row_ptr[r+1]; j++) {
+        sum += A->values[j] * c->x[A->col_ind[j]];
+    }
+    c->y[r] = sum;
+}
+
+double max_rel_error(const double *y, const double *ref, int n) {
+    double err = 0.0;
+    for (int i = 0; i < n; i++) {
+        double e = fabs(y[i] - ref[i]) / (fabs(ref[i]) + 1e-12);
+        if (e > err) err = e;
+    }
+    return err;
+}
+
+int main(int argc, char **argv) {
+    int gen_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (gen_threads < 1) gen_threads = 1;
+    int from_file = argc > 2 && strcmp(argv[1], "--matrix") == 0;
+    int iterations = from_file && argc > 3 ? atoi(argv[3]) : ITERATIONS;
+
+    printf("=== Block CSR (BSR) SpMV / SpGEMM Benchmark (Pthreads) ===\n");
+
+    CSRMatrix A;
+    CsrMapping mapA = {0};
+    if (from_file) {
+        if (load_matrix(argv[2], &A, &mapA, gen_threads) != 0) return 1;
+        printf("Matrix Size: %d x %d, %d nnz, %d iterations per run\n", A.rows, A.cols, A.nnz, iterations);
+    } else {
+        int block_rows = argc > 1 ? atoi(argv[1]) : BLOCK_ROWS;
+        double blocks_per_row = argc > 2 ? atof(argv[2]) : BLOCKS_PER_ROW;
+        int natural_b = argc > 3 ? atoi(argv[3]) : NATURAL_B;
+        A = generateBlockCSR(block_rows, blocks_per_row, natural_b, 42, gen_threads);
+        printf("Matrix Size: %d x %d, %d nnz (%d x %d dense blocks, ~%.0f per block row), %d iterations per run\n",
+               A.rows, A.cols, A.nnz, natural_b, natural_b, blocks_per_row, iterations);
+    }
+
+    // Block size detection from the sampled fill ratio
+    double fill[BSR_CANDIDATES];
+    double start = get_time();
+    int detected = bsr_detect_block_size(&A, fill);
+    printf("\n--- Block size detection (%.4f sec) ---\n", get_time() - start);
+    printf("| %-8s | %-10s | %-10s |\n", "Block", "Fill ratio", "Bytes/nnz");
+    printf("| %-8s | %10.3f | %10.2f |\n", "1x1 CSR", 1.0, bsr_bytes_per_nnz(1, 1.0));
+    for (int i = 0; i < BSR_CANDIDATES; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "%dx%d", bsr_candidates[i], bsr_candidates[i]);
+        printf("| %-8s | %10.3f | %10.2f |\n", name, fill[i], bsr_bytes_per_nnz(bsr_candidates[i], fill[i]));
+    }
+    printf(">> Detected block size: %d%s\n", detected, detected == 1 ? " (stay in CSR)" : "");
+
+    // Vectors padded to whole 8x8 blocks, so every format can use them as is
+    int padded = (A.rows > A.cols ? A.rows : A.cols) + 8;
+    double *x = (double*)calloc(padded, sizeof(double));
+    double *y = (double*)calloc(padded, sizeof(double));
+    double *y_ref = (double*)malloc(A.rows * sizeof(double));
+    for (int i = 0; i < A.cols; i++) x[i] = 1.0 + (i % 17) * 0.125;
+    BsrContext ref = {.csr = &A, .x = x, .y = y_ref};
+    parallel_rows(A.rows, 1, csr_row, &ref);
+
+    int thread_counts[] = {1, 2, 4, 8, 16};
+    int num_tests = 5;
+    double conversion[NUM_FORMATS], best_iter[NUM_FORMATS];
+    int best_method[NUM_FORMATS], best_threads[NUM_FORMATS];
+    int ok = 1;
+
+    // --- SpMV: CSR against each block size ---
+    for (int f = 0; f < NUM_FORMATS; f++) {
+        int b = format_b[f];
+        BSRMatrix M = {0};
+        start = get_time();
+        int units = A.rows;
+        if (b > 1) {
+            M = csr_to_bsr(&A, b, gen_threads);
+            units = M.block_rows;
+        }
+        conversion[f] = get_time() - start;
+        long long *prefix = (long long*)malloc((units + 1) * sizeof(long long));
+        for (int u = 0; u <= units; u++) prefix[u] = b > 1 ? M.row_ptr[u] : A.row_ptr[u];
+        void (*kernel)(int, RowTask*) = b > 1 ? bsr_spmv_kernel(b) : csr_row;
+
+        printf("\n--- SpMV %s | conversion %.4f sec", format_names[f], conversion[f]);
+        if (b > 1) printf(" | %d blocks, fill %.3f", M.nnzb, (double)M.nnzb * b * b / A.nnz);
+        printf(" ---\n");
+        printf("| %-25s |", "ms / iteration");
+        for (int t_idx = 0; t_idx < num_tests; t_idx++) printf(" %4d thr |", thread_counts[t_idx]);
+        printf("\n");
+
+        best_iter[f] = 1e9;
+        for (int method = 0; method < NUM_METHODS; method++) {
+            printf("| %-25s |", method_names[method]);
+            for (int t_idx = 0; t_idx < num_tests; t_idx++) {
+                int n_threads = thread_counts[t_idx];
+                BsrContext ctx = {.csr = &A, .A = &M, .x = x, .y = y};
+                RowTask tasks[n_threads];
+                for (int i = 0; i < n_threads; i++) {
+                    tasks[i] = (RowTask){.thread_id = i, .num_threads = n_threads, .rows = units, .ctx = &ctx};
+                }
+                if (method_partitions[method] != PART_NONE) {
+                    partition_rows(method_partitions[method], prefix, units, n_threads, tasks);
+                }
+
+                memset(y, 0, padded * sizeof(double));
+                run_method(method, n_threads, tasks, kernel);   // Warm-up
+                double err = max_rel_error(y, y_ref, A.rows);
+                if (err > 1e-9) {
+                    printf("\nERROR in %s / %s (%d threads): max relative error %.3e\n",
+                           format_names[f], method_names[method], n_threads, err);
+                    ok = 0;
+                }
+
+                start = get_time();
+                for (int it = 0; it < iterations; it++) run_method(method, n_threads, tasks, kernel);
+                double per_iter = (get_time() - start) / iterations;
+                printf(" %8.3f |", per_iter * 1e3);
+
+                if (per_iter < best_iter[f]) {
+                    best_iter[f] = per_iter;
+                    best_method[f] = method;
+                    best_threads[f] = n_threads;
+                }
+            }
+            printf("\n");
+        }
+        free(prefix);
+        if (b > 1) free_bsr(&M);
+    }
+
+    // --- SpGEMM: C = A * A in BSR at the detected block size ---
+    int spgemm_b = detected > 1 ? detected : 2;
+    double spgemm_best = 1e9;
+    int spgemm_method = 0, spgemm_threads = 1;
+    if (A.rows == A.cols) {
+        BSRMatrix M = csr_to_bsr(&A, spgemm_b, gen_threads);
+        start = get_time();
+        CSRMatrix C_ref = reference_spgemm(&A, &A);
+        printf("\n--- SpGEMM C = A*A, BSR %dx%d | serial CSR reference %.4f sec, %d nnz ---\n",
+               spgemm_b, spgemm_b, get_time() - start, C_ref.nnz);
+
+        // Dense block multiply-adds per block row, for the partitioned schedulers
+        long long *work = (long long*)malloc((M.block_rows + 1) * sizeof(long long));
+        work[0] = 0;
+        for (int br = 0; br < M.block_rows; br++) {
+            long long w = 0;
+            for (int k = M.row_ptr[br]; k < M.row_ptr[br+1]; k++) w += M.row_ptr[M.col_ind[k]+1] - M.row_ptr[M.col_ind[k]];
+            work[br + 1] = work[br] + w;
+        }
+        int *row_nnzb = (int*)malloc(M.block_rows * sizeof(int));
+
+        printf("| %-25s |", "Time (sec)");
+        for (int t_idx = 0; t_idx < num_tests; t_idx++) printf(" %4d thr |", thread_counts[t_idx]);
+        printf("\n");
+        for (int method = 0; method < NUM_METHODS; method++) {
+            printf("| %-25s |", method_names[method]);
+            for (int t_idx = 0; t_idx < num_tests; t_idx++) {
+                int n_threads = thread_counts[t_idx];
+                BSRMatrix C = {0};
+                C.row_ptr = (int*)malloc((M.block_rows + 1) * sizeof(int));
+                BsrWorkspace ws[n_threads];
+                BsrContext ctx[n_threads];
+                RowTask tasks[n_threads];
+                for (int i = 0; i < n_threads; i++) {
+                    ws[i] = bsr_workspace_create(M.block_cols, spgemm_b);
+                    ctx[i] = (BsrContext){.A = &M, .B = &M, .C = &C, .row_nnz = row_nnzb, .ws = &ws[i]};
+                    tasks[i] = (RowTask){.thread_id = i, .num_threads = n_threads, .rows = M.block_rows, .ctx = &ctx[i]};
+                }
+
+                start = get_time();
+                bsr_spgemm(method, n_threads, tasks, work);
+                double elapsed = get_time() - start;
+                printf(" %8.4f |", elapsed);
+
+                CSRMatrix C_csr = bsr_to_csr(&C, gen_threads);
+                if (!csr_matches(&C_csr, &C_ref)) {
+                    printf("\nERROR in SpGEMM / %s (%d threads): result differs from the reference\n",
+                           method_names[method], n_threads);
+                    ok = 0;
+                }
+                if (elapsed < spgemm_best) {
+                    spgemm_best = elapsed;
+                    spgemm_method = method;
+                    spgemm_threads = n_threads;
+                }
+
+                free_csr(&C_csr);
+                free_bsr(&C);
+                for (int i = 0; i < n_threads; i++) bsr_workspace_free(&ws[i]);
+            }
+            printf("\n");
+        }
+        free(work); free(row_nnzb);
+        free_csr(&C_ref);
+        free_bsr(&M);
+    }
+
+    printf("\n\n==============================================================================================\n");
+    printf("                                  FINAL PERFORMANCE SUMMARY                                   \n");
+    printf("==============================================================================================\n");
+    printf("| %-12s | %-10s | %-10s | %-8s | %-28s | %-12s |\n",
+           "SpMV Format", "Conversion", "Best Iter", "GFLOP/s", "Best Scheduler @ Threads", "Break-even");
+    printf("|--------------|------------|------------|----------|------------------------------|--------------|\n");
+    for (int f = 0; f < NUM_FORMATS; f++) {
+        char sched[64], even[32];
+        snprintf(sched, sizeof(sched), "%s @ %d", method_names[best_method[f]], best_threads[f]);
+        if (f == FMT_CSR) snprintf(even, sizeof(even), "-");
+        else if (best_iter[f] < best_iter[FMT_CSR])
+            snprintf(even, sizeof(even), "%.0f iters", ceil(conversion[f] / (best_iter[FMT_CSR] - best_iter[f])));
+        else snprintf(even, sizeof(even), "never");
+        printf("| %-12s | %8.4fs | %8.3fms | %8.2f | %-28s | %-12s |\n",
+               format_names[f], conversion[f], best_iter[f] * 1e3, 2.0 * A.nnz / best_iter[f] / 1e9, sched, even);
+    }
+    if (A.rows == A.cols) {
+        char name[32], sched[64];
+        snprintf(name, sizeof(name), "SpGEMM %dx%d", spgemm_b, spgemm_b);
+        snprintf(sched, sizeof(sched), "%s @ %d", method_names[spgemm_method], spgemm_threads);
+        printf("| %-12s | %-10s | %8.3fms | %-8s | %-28s | %-12s |\n",
+               name, "-", spgemm_best * 1e3, "-", sched, "-");
+    }
+    printf("==============================================================================================\n");
+
+    // Cleanup
+    csr_release(&A, &mapA);
+    free(x); free(y); free(y_ref);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,343 @@
+#ifndef LAB4_BSR_H
+#define LAB4_BSR_H
+
+/*
+ * Block CSR (BSR): CSR over b x b dense blocks. One col_ind per block
+ * instead of per value, and the inner step is a small dense block
+ * operation the compiler can unroll and vectorise.
+ *
+ *   bsr_fill_ratio()        - stored / true non-zeros for block size b, from a sample of block rows
+ *   bsr_detect_block_size() - the candidate (2, 4, 8) with the fewest bytes per non-zero, or 1 (stay CSR)
+ *   csr_to_bsr(), bsr_to_csr()
+ *   bsr_spmv_kernel(b), bsr_spgemm_numeric_kernel(b) - row kernels for the sched.h schedulers,
+ *                             one instantiation of bsr_kernels.h per block size
+ *
+ * Rows / columns that do not fill a whole block are padded with zeros, so
+ * vectors passed to the kernels need block_rows * b / block_cols * b entries.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sparse.h"
+#include "sched.h"
+
+typedef struct {
+    int b;              // Block size (b x b)
+    int rows, cols;     // Scalar dimensions
+    int block_rows, block_cols;
+    int nnzb;           // Stored blocks
+    int *row_ptr;       // Per block row
+    int *col_ind;       // Block column of each block
+    double *values;     // nnzb blocks of b*b values, row-major inside a block
+} BSRMatrix;
+
+// Per-thread scratch for conversion and SpGEMM
+typedef struct {
+    int *marker;        // Last block row that touched each block column (-1 = none)
+    int *cols;          // Block columns touched by the current block row
+    int *slot;          // Block column -> position inside the current block row
+    double *acc;        // SpGEMM: one dense block per block column
+} BsrWorkspace;
+
+typedef struct {
+    const CSRMatrix *csr;   // Conversion source / target
+    CSRMatrix *csr_out;
+    const BSRMatrix *A;
+    const BSRMatrix *B;
+    BSRMatrix *C;           // Conversion target, or SpGEMM result
+    const double *x;        // SpMV
+    double *y;
+    int *row_nnz;           // Per (block) row counts for the two-pass builds
+    BsrWorkspace *ws;       // This thread's scratch (SpGEMM), or all threads' (conversion)
+} BsrContext;
+
+#define BSR_CANDIDATES 3
+static const int bsr_candidates[BSR_CANDIDATES] __attribute__((unused)) = {2, 4, 8};
+
+static inline BsrWorkspace bsr_workspace_create(int block_cols, int b) {
+    BsrWorkspace ws;
+    ws.marker = (int*)malloc(block_cols * sizeof(int));
+    ws.cols = (int*)malloc(block_cols * sizeof(int));
+    ws.slot = (int*)malloc(block_cols * sizeof(int));
+    ws.acc = b ? (double*)malloc((size_t)block_cols * b * b * sizeof(double)) : NULL;
+    for (int i = 0; i < block_cols; i++) ws.marker[i] = -1;
+    return ws;
+}
+
+static inline void bsr_workspace_reset(BsrWorkspace *ws, int block_cols) {
+    for (int i = 0; i < block_cols; i++) ws->marker[i] = -1;
+}
+
+static inline void bsr_workspace_free(BsrWorkspace *ws) {
+    free(ws->marker); free(ws->cols); free(ws->slot); free(ws->acc);
+}
+
+static inline void free_bsr(BSRMatrix *M) {
+    free(M->row_ptr); free(M->col_ind); free(M->values);
+}
+
+// --- Block size detection ---
+
+// Stored values / true non-zeros if A were blocked with b, estimated on ~max_sample block rows
+static inline double bsr_fill_ratio(const CSRMatrix *A, int b, int max_sample) {
+    int block_rows = (A->rows + b - 1) / b, block_cols = (A->cols + b - 1) / b;
+    int stride = block_rows > max_sample ? block_rows / max_sample : 1;
+    int *marker = (int*)malloc(block_cols * sizeof(int));
+    for (int i = 0; i < block_cols; i++) marker[i] = -1;
+
+    long long blocks = 0, nnz = 0;
+    for (int br = 0; br < block_rows; br += stride) {
+        for (int r = br * b; r < (br + 1) * b && r < A->rows; r++) {
+            for (int k = A->row_ptr[r]; k < A->row_ptr[r+1]; k++) {
+                int bc = A->col_ind[k] / b;
+                if (marker[bc] != br) {
+                    marker[bc] = br;
+                    blocks++;
+                }
+                nnz++;
+            }
+        }
+    }
+    free(marker);
+    return nnz ? (double)blocks * b * b / nnz : 1.0;
+}
+
+// Bytes streamed per true non-zero: CSR pays 8 (value) + 4 (col_ind); BSR pays the fill
+static inline double bsr_bytes_per_nnz(int b, double fill) {
+    return b == 1 ? 12.0 : fill * 8.0 + fill * 4.0 / (b * b);
+}
+
+// Picks the block size with the least traffic; 1 means plain CSR is best
+static inline int bsr_detect_block_size(const CSRMatrix *A, double fill[BSR_CANDIDATES]) {
+    int best = 1;
+    double best_bytes = bsr_bytes_per_nnz(1, 1.0);
+    for (int i = 0; i < BSR_CANDIDATES; i++) {
+        fill[i] = bsr_fill_ratio(A, bsr_candidates[i], 4096);
+        double bytes = bsr_bytes_per_nnz(bsr_candidates[i], fill[i]);
+        if (bytes < best_bytes) {
+            best_bytes = bytes;
+            best = bsr_candidates[i];
+        }
+    }
+    return best;
+}
+
+// --- CSR <-> BSR ---
+static inline void csr_to_bsr_count(int br, RowTask *task) {
+    BsrContext *c = (BsrContext*)task->ctx;
+    const CSRMatrix *A = c->csr;
+    int b = c->C->b;
+    int *marker = c->ws[task->thread_id].marker;
+    int count = 0;
+    for (int r = br * b; r < (br + 1) * b && r < A->rows; r++) {
+        for (int k = A->row_ptr[r]; k < A->row_ptr[r+1]; k++) {
+            int bc = A->col_ind[k] / b;
+            if (marker[bc] != br) {
+                marker[bc] = br;
+                count++;
+            }
+        }
+    }
+    c->row_nnz[br] = count;
+}
+
+static inline void csr_to_bsr_fill(int br, RowTask *task) {
+    BsrContext *c = (BsrContext*)task->ctx;
+    const CSRMatrix *A = c->csr;
+    BSRMatrix *M = c->C;
+    int b = M->b;
+    BsrWorkspace *ws = &c->ws[task->thread_id];
+    int count = 0;
+
+    // Distinct block columns, sorted, and their slots
+    for (int r = br * b; r < (br + 1) * b && r < A->rows; r++) {
+        for (int k = A->row_ptr[r]; k < A->row_ptr[r+1]; k++) {
+            int bc = A->col_ind[k] / b;
+            if (ws->marker[bc] != br) {
+                ws->marker[bc] = br;
+                ws->cols[count++] = bc;
+            }
+        }
+    }
+    qsort(ws->cols, count, sizeof(int), compare_int);
+    int base = M->row_ptr[br];
+    for (int s = 0; s < count; s++) {
+        ws->slot[ws->cols[s]] = s;
+        M->col_ind[base + s] = ws->cols[s];
+    }
+
+    // Zero the blocks, then scatter the values
+    memset(M->values + (size_t)base * b * b, 0, (size_t)count * b * b * sizeof(double));
+    for (int r = br * b; r < (br + 1) * b && r < A->rows; r++) {
+        for (int k = A->row_ptr[r]; k < A->row_ptr[r+1]; k++) {
+            int col = A->col_ind[k];
+            size_t blk = (size_t)(base + ws->slot[col / b]) * b * b;
+            M->values[blk + (r - br * b) * b + col % b] = A->values[k];
+        }
+    }
+}
+
+static inline BSRMatrix csr_to_bsr(const CSRMatrix *A, int b, int n_threads) {
+    BSRMatrix M;
+    M.b = b;
+    M.rows = A->rows;
+    M.cols = A->cols;
+    M.block_rows = (A->rows + b - 1) / b;
+    M.block_cols = (A->cols + b - 1) / b;
+    M.row_ptr = (int*)malloc((M.block_rows + 1) * sizeof(int));
+
+    BsrWorkspace ws[n_threads];
+    for (int t = 0; t < n_threads; t++) ws[t] = bsr_workspace_create(M.block_cols, 0);
+    int *counts = (int*)malloc(M.block_rows * sizeof(int));
+    BsrContext ctx = {.csr = A, .C = &M, .row_nnz = counts, .ws = ws};
+
+    parallel_rows(M.block_rows, n_threads, csr_to_bsr_count, &ctx);
+    parallel_prefix_sum(counts, M.row_ptr, M.block_rows, n_threads);
+    M.nnzb = M.row_ptr[M.block_rows];
+    M.col_ind = (int*)malloc((size_t)M.nnzb * sizeof(int));
+    M.values = (double*)malloc((size_t)M.nnzb * b * b * sizeof(double));
+
+    for (int t = 0; t < n_threads; t++) bsr_workspace_reset(&ws[t], M.block_cols);
+    parallel_rows(M.block_rows, n_threads, csr_to_bsr_fill, &ctx);
+
+    for (int t = 0; t < n_threads; t++) bsr_workspace_free(&ws[t]);
+    free(counts);
+    return M;
+}
+
+// Non-zeros of every scalar row in block row br
+static inline void bsr_to_csr_count(int br, RowTask *task) {
+    BsrContext *c = (BsrContext*)task->ctx;
+    const BSRMatrix *M = c->A;
+    int b = M->b;
+    for (int i = 0; i < b && br * b + i < M->rows; i++) {
+        int count = 0;
+        for (int k = M->row_ptr[br]; k < M->row_ptr[br+1]; k++) {
+            const double *blk = M->values + (size_t)k * b * b + i * b;
+            for (int j = 0; j < b; j++) count += blk[j] != 0.0;
+        }
+        c->row_nnz[br * b + i] = count;
+    }
+}
+
+static inline void bsr_to_csr_fill(int br, RowTask *task) {
+    BsrContext *c = (BsrContext*)task->ctx;
+    const BSRMatrix *M = c->A;
+    CSRMatrix *out = c->csr_out;
+    int b = M->b;
+    for (int i = 0; i < b && br * b + i < M->rows; i++) {
+        int p = out->row_ptr[br * b + i];
+        for (int k = M->row_ptr[br]; k < M->row_ptr[br+1]; k++) {
+            const double *blk = M->values + (size_t)k * b * b + i * b;
+            for (int j = 0; j < b; j++) {
+                if (blk[j] != 0.0) {
+                    out->col_ind[p] = M->col_ind[k] * b + j;
+                    out->values[p++] = blk[j];
+                }
+            }
+        }
+    }
+}
+
+// Back to CSR; explicit zeros from block fill are dropped
+static inline CSRMatrix bsr_to_csr(const BSRMatrix *M, int n_threads) {
+    CSRMatrix out;
+    out.rows = M->rows;
+    out.cols = M->cols;
+    out.row_ptr = (int*)malloc((M->rows + 1) * sizeof(int));
+    int *counts = (int*)malloc(M->rows * sizeof(int));
+    BsrContext ctx = {.A = M, .csr_out = &out, .row_nnz = counts};
+
+    parallel_rows(M->block_rows, n_threads, bsr_to_csr_count, &ctx);
+    parallel_prefix_sum(counts, out.row_ptr, M->rows, n_threads);
+    out.nnz = out.row_ptr[M->rows];
+    out.col_ind = (int*)malloc((size_t)out.nnz * sizeof(int));
+    out.values = (double*)malloc((size_t)out.nnz * sizeof(double));
+    parallel_rows(M->block_rows, n_threads, bsr_to_csr_fill, &ctx);
+
+    free(counts);
+    return out;
+}
+
+// --- Kernels ---
+
+// SpGEMM symbolic phase: distinct block columns of block row br of C (block size independent)
+static inline void bsr_spgemm_symbolic_row(int br, RowTask *task) {
+    BsrContext *c = (BsrContext*)task->ctx;
+    const BSRMatrix *A = c->A, *B = c->B;
+    int *marker = c->ws->marker;
+    int count = 0;
+    for (int k = A->row_ptr[br]; k < A->row_ptr[br+1]; k++) {
+        int ka = A->col_ind[k];
+        for (int m = B->row_ptr[ka]; m < B->row_ptr[ka+1]; m++) {
+            int bc = B->col_ind[m];
+            if (marker[bc] != br) {
+                marker[bc] = br;
+                count++;
+            }
+        }
+    }
+    c->row_nnz[br] = count;
+}
+
+#define BSR_B 2
+#include "bsr_kernels.h"
+#define BSR_B 4
+#include "bsr_kernels.h"
+#define BSR_B 8
+#include "bsr_kernels.h"
+
+typedef void (*BsrRowKernel)(int, RowTask*);
+
+static inline BsrRowKernel bsr_spmv_kernel(int b) {
+    switch (b) {
+    case 2: return bsr_spmv_row_2;
+    case 4: return bsr_spmv_row_4;
+    case 8: return bsr_spmv_row_8;
+    default: return NULL;
+    }
+}
+
+static inline BsrRowKernel bsr_spgemm_numeric_kernel(int b) {
+    switch (b) {
+    case 2: return bsr_spgemm_numeric_row_2;
+    case 4: return bsr_spgemm_numeric_row_4;
+    case 8: return bsr_spgemm_numeric_row_8;
+    default: return NULL;
+    }
+}
+
+/*
+ * C = A * B in BSR under scheduler `method`: symbolic pass, prefix sum,
+ * numeric pass, as in the CSR SpGEMM. tasks[i].ctx must point at a
+ * BsrContext with A, B, C, row_nnz and this thread's ws (acc sized for b).
+ */
+static inline void bsr_spgemm(int method, int n_threads, RowTask *tasks, const long long *work_prefix) {
+    BsrContext *c0 = (BsrContext*)tasks[0].ctx;
+    const BSRMatrix *A = c0->A, *B = c0->B;
+    BSRMatrix *C = c0->C;
+    C->b = A->b;
+    C->rows = A->rows;
+    C->cols = B->cols;
+    C->block_rows = A->block_rows;
+    C->block_cols = B->block_cols;
+
+    if (method_partitions[method] != PART_NONE) {
+        partition_rows(method_partitions[method], work_prefix, A->block_rows, n_threads, tasks);
+    }
+
+    for (int t = 0; t < n_threads; t++) bsr_workspace_reset(((BsrContext*)tasks[t].ctx)->ws, B->block_cols);
+    run_method(method, n_threads, tasks, bsr_spgemm_symbolic_row);
+
+    parallel_prefix_sum(c0->row_nnz, C->row_ptr, C->block_rows, n_threads);
+    C->nnzb = C->row_ptr[C->block_rows];
+    C->col_ind = (int*)malloc((size_t)C->nnzb * sizeof(int));
+    C->values = (double*)malloc((size_t)C->nnzb * C->b * C->b * sizeof(double));
+
+    for (int t = 0; t < n_threads; t++) bsr_workspace_reset(((BsrContext*)tasks[t].ctx)->ws, B->block_cols);
+    run_method(method, n_threads, tasks, bsr_spgemm_numeric_kernel(C->b));
+}
+
+#endif
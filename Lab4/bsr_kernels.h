@@ -0,0 +1,79 @@
+/*
+ * BSR kernels for one block size, instantiated by bsr.h:
+ *
+ *     #define BSR_B 4
+ *     #include "bsr_kernels.h"      // bsr_spmv_row_4, bsr_spgemm_numeric_row_4
+ *
+ * BSR_B is a compile-time constant inside every loop below, so the compiler
+ * fully unrolls (and vectorises) the dense block operations. No include
+ * guard on purpose: the file is included once per block size.
+ */
+
+#ifndef BSR_B
+#error "define BSR_B before including bsr_kernels.h"
+#endif
+
+#define BSR_CAT_(name, b) name##_##b
+#define BSR_CAT(name, b) BSR_CAT_(name, b)
+#define BSR_FN(name) BSR_CAT(name, BSR_B)
+
+// y[block row br] = sum over its blocks of block * x[block col]
+static inline void BSR_FN(bsr_spmv_row)(int br, RowTask *task) {
+    BsrContext *c = (BsrContext*)task->ctx;
+    const BSRMatrix *A = c->A;
+    double acc[BSR_B] = {0};
+
+    for (int k = A->row_ptr[br]; k < A->row_ptr[br+1]; k++) {
+        const double *blk = A->values + (size_t)k * BSR_B * BSR_B;
+        const double *xb = c->x + (size_t)A->col_ind[k] * BSR_B;
+        for (int i = 0; i < BSR_B; i++)
+            for (int j = 0; j < BSR_B; j++) acc[i] += blk[i * BSR_B + j] * xb[j];
+    }
+    for (int i = 0; i < BSR_B; i++) c->y[(size_t)br * BSR_B + i] = acc[i];
+}
+
+// Numeric phase of C = A * B: block row br of C, accumulated in dense blocks
+static inline void BSR_FN(bsr_spgemm_numeric_row)(int br, RowTask *task) {
+    BsrContext *c = (BsrContext*)task->ctx;
+    const BSRMatrix *A = c->A, *B = c->B;
+    BSRMatrix *C = c->C;
+    int *marker = c->ws->marker;
+    int *cols = c->ws->cols;
+    double *acc = c->ws->acc;
+    int count = 0;
+
+    for (int k = A->row_ptr[br]; k < A->row_ptr[br+1]; k++) {
+        const double *a = A->values + (size_t)k * BSR_B * BSR_B;
+        int ka = A->col_ind[k];
+        for (int m = B->row_ptr[ka]; m < B->row_ptr[ka+1]; m++) {
+            const double *b = B->values + (size_t)m * BSR_B * BSR_B;
+            int bc = B->col_ind[m];
+            double *dst = acc + (size_t)bc * BSR_B * BSR_B;
+            if (marker[bc] != br) {
+                marker[bc] = br;
+                cols[count++] = bc;
+                for (int i = 0; i < BSR_B * BSR_B; i++) dst[i] = 0.0;
+            }
+            // dst += a * b, one dense BSR_B x BSR_B block product
+            for (int i = 0; i < BSR_B; i++)
+                for (int kk = 0; kk < BSR_B; kk++) {
+                    double aik = a[i * BSR_B + kk];
+                    for (int j = 0; j < BSR_B; j++) dst[i * BSR_B + j] += aik * b[kk * BSR_B + j];
+                }
+        }
+    }
+
+    qsort(cols, count, sizeof(int), compare_int);
+    int base = C->row_ptr[br];
+    for (int p = 0; p < count; p++) {
+        const double *src = acc + (size_t)cols[p] * BSR_B * BSR_B;
+        double *out = C->values + (size_t)(base + p) * BSR_B * BSR_B;
+        C->col_ind[base + p] = cols[p];
+        for (int i = 0; i < BSR_B * BSR_B; i++) out[i] = src[i];
+    }
+}
+
+#undef BSR_FN
+#undef BSR_CAT
+#undef BSR_CAT_
+#undef BSR_B
@@ -0,0 +1,437 @@
+#ifndef LAB4_HYBRID_H
+#define LAB4_HYBRID_H
+
+/*
+ * Density-adaptive hybrid SpGEMM: C = A * B with dense GEMM where the
+ * operands are dense enough to pay for it and CSR everywhere else.
+ *
+ * A is cut into row panels of HYBRID_TILE rows and each panel into
+ * HYBRID_TILE x HYBRID_TILE tiles. hybrid_plan() decides per panel:
+ *
+ *   - output: the density of the panel's rows of C is estimated from a few
+ *     sampled rows (symbolic only). Above HYBRID_OUT_DENSITY the panel is
+ *     accumulated in a dense HYBRID_TILE x cols buffer, otherwise row by row
+ *     with a sparse accumulator as in the CSR SpGEMM.
+ *   - per tile of a dense panel: dense tile x dense copy of the matching B
+ *     rows (vectorised, no indices) when that beats scattering the tile's
+ *     non-zeros through sparse B rows, i.e. when
+ *         tile_nnz * avg_B_row_nnz * HYBRID_SCATTER_COST > tile_rows * tile_cols * cols
+ *
+ * The panels are the scheduler's task indices (hybrid_panel), so every
+ * method in sched.h runs the numeric phase. Each panel writes its rows to a
+ * private buffer; a prefix sum over the row counts and a parallel copy then
+ * assemble C. A dense panel tracks its pattern in a bitmask next to the
+ * values (each dense copy of B rows carries one too), so it emits every
+ * structurally present entry, exact zeros included, as the CSR SpGEMM does.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sparse.h"
+#include "sched.h"
+
+#define HYBRID_TILE 64              // Panel height and tile width
+#define HYBRID_COL_BLOCK 512        // Columns of C / B per dense strip (stays in L1/L2)
+#define HYBRID_SAMPLE 8             // Rows per panel sampled for the output density
+#define HYBRID_OUT_DENSITY 0.10     // Dense output panel at or above this estimated density
+#define HYBRID_SCATTER_COST 8.0     // Cost of one sparse scatter-add in dense (vectorised) FMAs
+#define HYBRID_PANEL_LIMIT (64L << 20)  // Largest dense output panel, bytes
+#define HYBRID_B_LIMIT (1L << 30)   // Largest total dense copy of B, bytes
+
+typedef enum { HYBRID_AUTO = 0, HYBRID_ALL_SPARSE, HYBRID_ALL_DENSE } HybridMode;
+
+typedef struct {
+    int n_panels, n_kblocks;
+    char *dense_panel;          // Per panel: output accumulated densely
+    char *dense_tile;           // n_panels * n_kblocks: tile multiplied as dense GEMM
+    double **b_dense;           // Per k-block: dense HYBRID_TILE x cols rows of B, or NULL
+    uint64_t **b_mask;          // Per k-block: pattern of those rows, HYBRID_TILE x hybrid_words(cols) bits
+    double est_density;         // Estimated density of C
+    long long dense_panels, dense_tiles;
+} HybridPlan;
+
+typedef struct {
+    int *marker;                // Sparse accumulator, as in the CSR SpGEMM
+    double *acc;
+    int *cols;
+    int *tile_nnz;              // Planning: non-zeros per tile of the current panel
+    int *cursor;                // Per panel row: next entry of A not yet consumed
+    double *a_tile;             // Dense HYBRID_TILE x HYBRID_TILE tile of A
+    double *c_panel;            // Dense HYBRID_TILE x cols output panel (only with dense panels)
+    uint64_t *c_mask;           // Its pattern, HYBRID_TILE x hybrid_words(cols) bits
+    int *out_cols;              // Rows of the current panel, before they are copied out
+    double *out_vals;
+    long long out_cap;
+} HybridWorkspace;
+
+typedef struct {
+    const CSRMatrix *A, *B;
+    CSRMatrix *C;
+    HybridPlan *plan;
+    HybridMode mode;
+    HybridWorkspace *ws;        // One per thread, indexed by RowTask.thread_id
+    int *row_nnz;               // Per row of C
+    int **panel_cols;           // Per panel: its rows of C, back to back
+    double **panel_vals;
+    long long *est_nnz;         // Planning: estimated nnz of each panel of C
+} HybridContext;
+
+static inline int hybrid_min(int a, int b) { return a < b ? a : b; }
+
+// 64-bit words per row of a pattern bitmask
+static inline int hybrid_words(int cols) { return (cols + 63) / 64; }
+
+static inline HybridWorkspace hybrid_workspace_create(int a_cols, int cols) {
+    HybridWorkspace ws;
+    ws.marker = (int*)malloc(cols * sizeof(int));
+    ws.acc = (double*)malloc(cols * sizeof(double));
+    ws.cols = (int*)malloc(cols * sizeof(int));
+    for (int c = 0; c < cols; c++) ws.marker[c] = -1;
+    ws.tile_nnz = (int*)malloc(((a_cols + HYBRID_TILE - 1) / HYBRID_TILE) * sizeof(int));
+    ws.cursor = (int*)malloc(HYBRID_TILE * sizeof(int));
+    ws.a_tile = (double*)malloc(HYBRID_TILE * HYBRID_TILE * sizeof(double));
+    ws.c_panel = NULL;
+    ws.c_mask = NULL;
+    ws.out_cap = 1024;
+    ws.out_cols = (int*)malloc(ws.out_cap * sizeof(int));
+    ws.out_vals = (double*)malloc(ws.out_cap * sizeof(double));
+    return ws;
+}
+
+static inline void hybrid_workspace_free(HybridWorkspace *ws) {
+    free(ws->marker); free(ws->acc); free(ws->cols);
+    free(ws->tile_nnz); free(ws->cursor); free(ws->a_tile); free(ws->c_panel); free(ws->c_mask);
+    free(ws->out_cols); free(ws->out_vals);
+}
+
+static inline void hybrid_reset_markers(HybridContext *ctx, int n_threads) {
+    for (int t = 0; t < n_threads; t++)
+        for (int col = 0; col < ctx->B->cols; col++) ctx->ws[t].marker[col] = -1;
+}
+
+static inline void hybrid_out_reserve(HybridWorkspace *ws, long long need) {
+    if (need <= ws->out_cap) return;
+    while (ws->out_cap < need) ws->out_cap *= 2;
+    ws->out_cols = (int*)realloc(ws->out_cols, ws->out_cap * sizeof(int));
+    ws->out_vals = (double*)realloc(ws->out_vals, ws->out_cap * sizeof(double));
+}
+
+// --- Planning ---
+
+// Estimated nnz of panel p of C from HYBRID_SAMPLE evenly spaced rows; decides the output mode
+static inline void hybrid_plan_panel(int p, RowTask *task) {
+    HybridContext *c = (HybridContext*)task->ctx;
+    const CSRMatrix *A = c->A, *B = c->B;
+    HybridPlan *plan = c->plan;
+    HybridWorkspace *ws = &c->ws[task->thread_id];
+    int r0 = p * HYBRID_TILE, r1 = hybrid_min(r0 + HYBRID_TILE, A->rows);
+    int step = (r1 - r0 + HYBRID_SAMPLE - 1) / HYBRID_SAMPLE;
+
+    long long distinct = 0;
+    int sampled = 0;
+    for (int r = r0; r < r1; r += step, sampled++) {
+        for (int k = A->row_ptr[r]; k < A->row_ptr[r+1]; k++) {
+            int ka = A->col_ind[k];
+            for (int m = B->row_ptr[ka]; m < B->row_ptr[ka+1]; m++) {
+                int col = B->col_ind[m];
+                if (ws->marker[col] != r) {
+                    ws->marker[col] = r;
+                    distinct++;
+                }
+            }
+        }
+    }
+    c->est_nnz[p] = distinct * (r1 - r0) / sampled;
+
+    int fits = (long)HYBRID_TILE * B->cols * sizeof(double) <= HYBRID_PANEL_LIMIT;
+    double density = (double)distinct / ((double)sampled * B->cols);
+    plan->dense_panel[p] = fits && (c->mode == HYBRID_ALL_DENSE || (c->mode == HYBRID_AUTO && density >= HYBRID_OUT_DENSITY));
+    if (!plan->dense_panel[p]) return;
+
+    // Tiles of a dense panel: dense GEMM against B, or scatter through sparse B rows
+    char *tiles = plan->dense_tile + (size_t)p * plan->n_kblocks;
+    if (c->mode == HYBRID_ALL_DENSE) {
+        memset(tiles, 1, plan->n_kblocks);
+        return;
+    }
+    memset(ws->tile_nnz, 0, plan->n_kblocks * sizeof(int));
+    for (int k = A->row_ptr[r0]; k < A->row_ptr[r1]; k++) ws->tile_nnz[A->col_ind[k] / HYBRID_TILE]++;
+    for (int kb = 0; kb < plan->n_kblocks; kb++) {
+        int k0 = kb * HYBRID_TILE, k1 = hybrid_min(k0 + HYBRID_TILE, A->cols);
+        double b_row_nnz = (double)(B->row_ptr[k1] - B->row_ptr[k0]) / (k1 - k0);
+        double sparse_cost = ws->tile_nnz[kb] * b_row_nnz * HYBRID_SCATTER_COST;
+        double dense_cost = (double)(r1 - r0) * (k1 - k0) * B->cols;
+        tiles[kb] = ws->tile_nnz[kb] > 0 && sparse_cost > dense_cost;
+    }
+}
+
+// Dense copy and pattern of the B rows of k-block kb, if any dense tile needs them
+static inline void hybrid_densify_b(int kb, RowTask *task) {
+    HybridContext *c = (HybridContext*)task->ctx;
+    const CSRMatrix *B = c->B;
+    HybridPlan *plan = c->plan;
+    int used = 0;
+    for (int p = 0; p < plan->n_panels && !used; p++) used = plan->dense_tile[(size_t)p * plan->n_kblocks + kb];
+    if (!used) return;
+
+    int k0 = kb * HYBRID_TILE, k1 = hybrid_min(k0 + HYBRID_TILE, B->rows);
+    int words = hybrid_words(B->cols);
+    double *dst = (double*)calloc((size_t)HYBRID_TILE * B->cols, sizeof(double));
+    uint64_t *mask = (uint64_t*)calloc((size_t)HYBRID_TILE * words, sizeof(uint64_t));
+    for (int k = k0; k < k1; k++) {
+        double *row = dst + (size_t)(k - k0) * B->cols;
+        uint64_t *bits = mask + (size_t)(k - k0) * words;
+        for (int m = B->row_ptr[k]; m < B->row_ptr[k+1]; m++) {
+            row[B->col_ind[m]] = B->values[m];
+            bits[B->col_ind[m] >> 6] |= 1ULL << (B->col_ind[m] & 63);
+        }
+    }
+    plan->b_dense[kb] = dst;
+    plan->b_mask[kb] = mask;
+}
+
+/*
+ * Plans C = A * B for `mode` and builds the dense copies of B it needs.
+ * ctx->ws must hold n_threads workspaces; dense panels get their c_panel
+ * buffers here.
+ */
+static inline void hybrid_plan(HybridContext *ctx, HybridPlan *plan, int n_threads) {
+    const CSRMatrix *A = ctx->A, *B = ctx->B;
+    plan->n_panels = (A->rows + HYBRID_TILE - 1) / HYBRID_TILE;
+    plan->n_kblocks = (A->cols + HYBRID_TILE - 1) / HYBRID_TILE;
+    plan->dense_panel = (char*)calloc(plan->n_panels, 1);
+    plan->dense_tile = (char*)calloc((size_t)plan->n_panels * plan->n_kblocks, 1);
+    plan->b_dense = (double**)calloc(plan->n_kblocks, sizeof(double*));
+    plan->b_mask = (uint64_t**)calloc(plan->n_kblocks, sizeof(uint64_t*));
+    ctx->plan = plan;
+    ctx->est_nnz = (long long*)malloc(plan->n_panels * sizeof(long long));
+
+    hybrid_reset_markers(ctx, n_threads);
+    parallel_rows(plan->n_panels, n_threads, hybrid_plan_panel, ctx);
+
+    long long est = 0, needed = 0;
+    plan->dense_panels = plan->dense_tiles = 0;
+    for (int p = 0; p < plan->n_panels; p++) {
+        est += ctx->est_nnz[p];
+        plan->dense_panels += plan->dense_panel[p];
+    }
+    for (int kb = 0; kb < plan->n_kblocks; kb++) {
+        int used = 0;
+        for (int p = 0; p < plan->n_panels; p++) {
+            plan->dense_tiles += plan->dense_tile[(size_t)p * plan->n_kblocks + kb];
+            used |= plan->dense_tile[(size_t)p * plan->n_kblocks + kb];
+        }
+        needed += used;
+    }
+    plan->est_density = (double)est / ((double)A->rows * B->cols);
+    free(ctx->est_nnz);
+    ctx->est_nnz = NULL;
+
+    // Too large a dense copy of B: fall back to scattering in every tile
+    if (needed * HYBRID_TILE * B->cols * (long)sizeof(double) > HYBRID_B_LIMIT) {
+        memset(plan->dense_tile, 0, (size_t)plan->n_panels * plan->n_kblocks);
+        plan->dense_tiles = 0;
+    }
+    parallel_rows(plan->n_kblocks, n_threads, hybrid_densify_b, ctx);
+
+    if (plan->dense_panels > 0) {
+        for (int t = 0; t < n_threads; t++) {
+            ctx->ws[t].c_panel = (double*)malloc((size_t)HYBRID_TILE * B->cols * sizeof(double));
+            ctx->ws[t].c_mask = (uint64_t*)malloc((size_t)HYBRID_TILE * hybrid_words(B->cols) * sizeof(uint64_t));
+        }
+    }
+}
+
+static inline void hybrid_plan_free(HybridPlan *plan) {
+    for (int kb = 0; kb < plan->n_kblocks; kb++) {
+        free(plan->b_dense[kb]);
+        free(plan->b_mask[kb]);
+    }
+    free(plan->b_dense); free(plan->b_mask); free(plan->dense_panel); free(plan->dense_tile);
+}
+
+// --- Numeric phase ---
+
+// c[m x cols] += a[m x kk] * b[kk x cols]; a has row stride HYBRID_TILE. Four rows of c per pass over b
+static inline void hybrid_tile_gemm(const double *a, int m, int kk, const double *b, double *c, int cols) {
+    for (int j0 = 0; j0 < cols; j0 += HYBRID_COL_BLOCK) {
+        int j1 = hybrid_min(j0 + HYBRID_COL_BLOCK, cols);
+        int i = 0;
+        for (; i + 4 <= m; i += 4) {
+            double *c0 = c + (size_t)i * cols, *c1 = c0 + cols, *c2 = c1 + cols, *c3 = c2 + cols;
+            for (int k = 0; k < kk; k++) {
+                const double *bk = b + (size_t)k * cols;
+                double a0 = a[i * HYBRID_TILE + k], a1 = a[(i + 1) * HYBRID_TILE + k];
+                double a2 = a[(i + 2) * HYBRID_TILE + k], a3 = a[(i + 3) * HYBRID_TILE + k];
+                for (int j = j0; j < j1; j++) {
+                    double bj = bk[j];
+                    c0[j] += a0 * bj;
+                    c1[j] += a1 * bj;
+                    c2[j] += a2 * bj;
+                    c3[j] += a3 * bj;
+                }
+            }
+        }
+        for (; i < m; i++) {
+            double *ci = c + (size_t)i * cols;
+            for (int k = 0; k < kk; k++) {
+                const double *bk = b + (size_t)k * cols;
+                double aik = a[i * HYBRID_TILE + k];
+                for (int j = j0; j < j1; j++) ci[j] += aik * bk[j];
+            }
+        }
+    }
+}
+
+// Panel with a dense output buffer: dense tiles by GEMM, the rest by scattering sparse B rows
+static inline long long hybrid_dense_panel(int p, HybridContext *c, HybridWorkspace *ws) {
+    const CSRMatrix *A = c->A, *B = c->B;
+    const HybridPlan *plan = c->plan;
+    int r0 = p * HYBRID_TILE, m = hybrid_min(HYBRID_TILE, A->rows - r0), cols = B->cols;
+    int words = hybrid_words(cols);
+    const char *tiles = plan->dense_tile + (size_t)p * plan->n_kblocks;
+
+    memset(ws->c_panel, 0, (size_t)m * cols * sizeof(double));
+    memset(ws->c_mask, 0, (size_t)m * words * sizeof(uint64_t));
+    for (int i = 0; i < m; i++) ws->cursor[i] = A->row_ptr[r0 + i];
+
+    // Rows of A are sorted, so each row's entries of k-block kb follow those of kb - 1
+    for (int kb = 0; kb < plan->n_kblocks; kb++) {
+        int k0 = kb * HYBRID_TILE, k1 = hybrid_min(k0 + HYBRID_TILE, A->cols);
+        if (tiles[kb]) {
+            memset(ws->a_tile, 0, HYBRID_TILE * HYBRID_TILE * sizeof(double));
+            for (int i = 0; i < m; i++) {
+                uint64_t *ci_mask = ws->c_mask + (size_t)i * words;
+                int end = A->row_ptr[r0 + i + 1];
+                for (; ws->cursor[i] < end && A->col_ind[ws->cursor[i]] < k1; ws->cursor[i]++) {
+                    int ka = A->col_ind[ws->cursor[i]] - k0;
+                    ws->a_tile[i * HYBRID_TILE + ka] = A->values[ws->cursor[i]];
+                    // Pattern: row i of C gains B row ka's pattern, ~1/64 of the GEMM's work
+                    const uint64_t *b_bits = plan->b_mask[kb] + (size_t)ka * words;
+                    for (int w = 0; w < words; w++) ci_mask[w] |= b_bits[w];
+                }
+            }
+            hybrid_tile_gemm(ws->a_tile, m, k1 - k0, plan->b_dense[kb], ws->c_panel, cols);
+        } else {
+            for (int i = 0; i < m; i++) {
+                double *ci = ws->c_panel + (size_t)i * cols;
+                uint64_t *ci_mask = ws->c_mask + (size_t)i * words;
+                int end = A->row_ptr[r0 + i + 1];
+                for (; ws->cursor[i] < end && A->col_ind[ws->cursor[i]] < k1; ws->cursor[i]++) {
+                    int ka = A->col_ind[ws->cursor[i]];
+                    double a = A->values[ws->cursor[i]];
+                    for (int q = B->row_ptr[ka]; q < B->row_ptr[ka+1]; q++) {
+                        int col = B->col_ind[q];
+                        ci[col] += a * B->values[q];
+                        ci_mask[col >> 6] |= 1ULL << (col & 63);
+                    }
+                }
+            }
+        }
+    }
+
+    // Every structurally present entry, zero or not, already in column order
+    long long n = 0;
+    for (int i = 0; i < m; i++) {
+        const double *ci = ws->c_panel + (size_t)i * cols;
+        const uint64_t *ci_mask = ws->c_mask + (size_t)i * words;
+        int count = 0;
+        for (int w = 0; w < words; w++) count += __builtin_popcountll(ci_mask[w]);
+        hybrid_out_reserve(ws, n + count);
+        for (int w = 0; w < words; w++) {
+            for (uint64_t bits = ci_mask[w]; bits; bits &= bits - 1) {
+                int j = w * 64 + __builtin_ctzll(bits);
+                ws->out_cols[n] = j;
+                ws->out_vals[n++] = ci[j];
+            }
+        }
+        c->row_nnz[r0 + i] = count;
+    }
+    return n;
+}
+
+// Sparse panel: one sparse accumulator pass per row
+static inline long long hybrid_sparse_panel(int p, HybridContext *c, HybridWorkspace *ws) {
+    const CSRMatrix *A = c->A, *B = c->B;
+    int r0 = p * HYBRID_TILE, r1 = hybrid_min(r0 + HYBRID_TILE, A->rows);
+    long long n = 0;
+    for (int r = r0; r < r1; r++) {
+        int count = 0;
+        for (int k = A->row_ptr[r]; k < A->row_ptr[r+1]; k++) {
+            int ka = A->col_ind[k];
+            double a = A->values[k];
+            for (int q = B->row_ptr[ka]; q < B->row_ptr[ka+1]; q++) {
+                int col = B->col_ind[q];
+                if (ws->marker[col] != r) {
+                    ws->marker[col] = r;
+                    ws->cols[count++] = col;
+                    ws->acc[col] = 0.0;
+                }
+                ws->acc[col] += a * B->values[q];
+            }
+        }
+        qsort(ws->cols, count, sizeof(int), compare_int);
+        hybrid_out_reserve(ws, n + count);
+        for (int i = 0; i < count; i++) {
+            ws->out_cols[n] = ws->cols[i];
+            ws->out_vals[n++] = ws->acc[ws->cols[i]];
+        }
+        c->row_nnz[r] = count;
+    }
+    return n;
+}
+
+static inline void hybrid_panel(int p, RowTask *task) {
+    HybridContext *c = (HybridContext*)task->ctx;
+    HybridWorkspace *ws = &c->ws[task->thread_id];
+    long long n = c->plan->dense_panel[p] ? hybrid_dense_panel(p, c, ws) : hybrid_sparse_panel(p, c, ws);
+    c->panel_cols[p] = (int*)malloc((n ? n : 1) * sizeof(int));
+    c->panel_vals[p] = (double*)malloc((n ? n : 1) * sizeof(double));
+    memcpy(c->panel_cols[p], ws->out_cols, n * sizeof(int));
+    memcpy(c->panel_vals[p], ws->out_vals, n * sizeof(double));
+}
+
+static inline void hybrid_copy_panel(int p, RowTask *task) {
+    HybridContext *c = (HybridContext*)task->ctx;
+    CSRMatrix *C = c->C;
+    int r0 = p * HYBRID_TILE, r1 = hybrid_min(r0 + HYBRID_TILE, C->rows);
+    long long n = C->row_ptr[r1] - C->row_ptr[r0];
+    memcpy(C->col_ind + C->row_ptr[r0], c->panel_cols[p], n * sizeof(int));
+    memcpy(C->values + C->row_ptr[r0], c->panel_vals[p], n * sizeof(double));
+    free(c->panel_cols[p]);
+    free(c->panel_vals[p]);
+}
+
+/*
+ * C = A * B following a plan made by hybrid_plan(). Panels are scheduled by
+ * `method` (tasks[i].ctx == ctx, rows == plan->n_panels); assembly uses
+ * static blocks.
+ */
+static inline CSRMatrix hybrid_spgemm(HybridContext *ctx, int method, int n_threads, RowTask *tasks) {
+    const CSRMatrix *A = ctx->A, *B = ctx->B;
+    int n_panels = ctx->plan->n_panels;
+    CSRMatrix C;
+    C.rows = A->rows;
+    C.cols = B->cols;
+    C.row_ptr = (int*)malloc((C.rows + 1) * sizeof(int));
+    ctx->C = &C;
+    ctx->row_nnz = (int*)malloc(A->rows * sizeof(int));
+    ctx->panel_cols = (int**)malloc(n_panels * sizeof(int*));
+    ctx->panel_vals = (double**)malloc(n_panels * sizeof(double*));
+
+    hybrid_reset_markers(ctx, n_threads);
+    run_method(method, n_threads, tasks, hybrid_panel);
+
+    parallel_prefix_sum(ctx->row_nnz, C.row_ptr, C.rows, n_threads);
+    C.nnz = C.row_ptr[C.rows];
+    C.col_ind = (int*)malloc((size_t)C.nnz * sizeof(int));
+    C.values = (double*)malloc((size_t)C.nnz * sizeof(double));
+    parallel_rows(n_panels, n_threads, hybrid_copy_panel, ctx);
+
+    free(ctx->row_nnz); free(ctx->panel_cols); free(ctx->panel_vals);
+    ctx->C = NULL;
+    return C;
+}
+
+#endif
@@ -0,0 +1,378 @@
+#ifndef LAB4_MTX_H
+#define LAB4_MTX_H
+
+/*
+ * Real inputs for the Lab4 benchmarks.
+ *
+ *   mtx_read()        - parallel Matrix Market (.mtx, coordinate) parser: the
+ *                       file is mmap()ed, split on line boundaries, parsed per
+ *                       thread, merged, and turned into CSR by coo_to_csr()
+ *   csr_cache_write() - binary CSR file: header + 64-byte aligned arrays
+ *   csr_cache_map()   - mmap()s such a file and points row_ptr / col_ind /
+ *                       values straight into the mapping (zero-copy)
+ *   load_matrix()     - .csr: map it; .mtx: map "<file>.csr" if it is newer,
+ *                       otherwise parse and write that cache for next time
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "sparse.h"
+
+#define CSR_CACHE_MAGIC "LAB4CSR1"
+
+typedef struct {
+    char magic[8];
+    int64_t rows, cols, nnz;
+    int64_t row_ptr_off;    // Byte offsets from the start of the file, 64-byte aligned
+    int64_t col_ind_off;
+    int64_t values_off;
+    int64_t reserved;
+} CsrFileHeader;
+
+// How a loaded matrix is backed: mapped file (addr != NULL) or heap arrays
+typedef struct {
+    void *addr;
+    size_t len;
+} CsrMapping;
+
+// --- Matrix Market parser ---
+typedef struct {
+    const char *begin, *end;    // Whole lines of the body
+    int symmetric;              // 0 general, 1 symmetric, -1 skew-symmetric
+    int pattern;                // No value column: every entry is 1.0
+    int rows, cols;
+    long long count, cap;       // Entries parsed by this thread (with symmetric mirrors)
+    long long lines;            // Entry lines read, as counted by the size line
+    int *r, *c;
+    double *v;
+    long long offset;           // Where they go in the merged COO
+    int *out_r, *out_c;
+    double *out_v;
+    int error;
+} MtxChunk;
+
+static inline const char* mtx_skip_blank(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    return p;
+}
+
+static inline const char* mtx_parse_long(const char *p, const char *end, long *out) {
+    p = mtx_skip_blank(p, end);
+    int neg = 0;
+    if (p < end && (*p == '-' || *p == '+')) neg = (*p++ == '-');
+    if (p >= end || *p < '0' || *p > '9') return NULL;
+    long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+    *out = neg ? -v : v;
+    return p;
+}
+
+// strtod() needs a terminated string and the mapping is not one, so copy the token
+static inline const char* mtx_parse_double(const char *p, const char *end, double *out) {
+    p = mtx_skip_blank(p, end);
+    char token[64];
+    int n = 0;
+    while (p < end && n < 63 && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') token[n++] = *p++;
+    if (n == 0) return NULL;
+    token[n] = '\0';
+    char *stop;
+    *out = strtod(token, &stop);
+    return stop == token ? NULL : p;
+}
+
+static inline void mtx_push(MtxChunk *ch, int i, int j, double v) {
+    if (ch->count == ch->cap) {
+        ch->cap = ch->cap ? 2 * ch->cap : 1 << 16;
+        ch->r = (int*)realloc(ch->r, ch->cap * sizeof(int));
+        ch->c = (int*)realloc(ch->c, ch->cap * sizeof(int));
+        ch->v = (double*)realloc(ch->v, ch->cap * sizeof(double));
+    }
+    ch->r[ch->count] = i;
+    ch->c[ch->count] = j;
+    ch->v[ch->count++] = v;
+}
+
+static inline void* mtx_parse_worker(void *arg) {
+    MtxChunk *ch = (MtxChunk*)arg;
+    const char *p = ch->begin, *end = ch->end;
+
+    while (p < end) {
+        const char *eol = memchr(p, '\n', end - p);
+        if (!eol) eol = end;
+        const char *q = mtx_skip_blank(p, eol);
+        if (q < eol && *q != '%') {
+            long i, j;
+            double v = 1.0;
+            q = mtx_parse_long(q, eol, &i);
+            if (q) q = mtx_parse_long(q, eol, &j);
+            if (q && !ch->pattern) q = mtx_parse_double(q, eol, &v);
+            if (!q || i < 1 || i > ch->rows || j < 1 || j > ch->cols) {
+                ch->error = 1;
+                return NULL;
+            }
+            ch->lines++;
+            mtx_push(ch, (int)i - 1, (int)j - 1, v);
+            if (ch->symmetric && i != j) mtx_push(ch, (int)j - 1, (int)i - 1, ch->symmetric < 0 ? -v : v);
+        }
+        p = eol + 1;
+    }
+    return NULL;
+}
+
+static inline void* mtx_merge_worker(void *arg) {
+    MtxChunk *ch = (MtxChunk*)arg;
+    memcpy(ch->out_r + ch->offset, ch->r, ch->count * sizeof(int));
+    memcpy(ch->out_c + ch->offset, ch->c, ch->count * sizeof(int));
+    memcpy(ch->out_v + ch->offset, ch->v, ch->count * sizeof(double));
+    free(ch->r); free(ch->c); free(ch->v);
+    return NULL;
+}
+
+// Parses a coordinate Matrix Market file into CSR. Returns 0, or -1 with a message on stderr.
+static inline int mtx_read(const char *path, CSRMatrix *M, int n_threads) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { perror(path); return -1; }
+    struct stat st;
+    fstat(fd, &st);
+    size_t size = (size_t)st.st_size;
+    const char *data = size ? (const char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    close(fd);
+    if (!data || data == MAP_FAILED) { fprintf(stderr, "%s: cannot map file\n", path); return -1; }
+    madvise((void*)data, size, MADV_SEQUENTIAL);
+    const char *end = data + size;
+
+    // Banner: %%MatrixMarket matrix coordinate <real|integer|pattern> <general|symmetric|skew-symmetric>
+    char banner[256] = {0};
+    const char *eol = memchr(data, '\n', size);
+    size_t len = (eol ? (size_t)(eol - data) : size);
+    memcpy(banner, data, len < 255 ? len : 255);
+    char object[32] = "", format[32] = "", field[32] = "", symmetry[32] = "";
+    if (sscanf(banner, "%%%%MatrixMarket %31s %31s %31s %31s", object, format, field, symmetry) != 4
+        || strcasecmp(object, "matrix") != 0 || strcasecmp(format, "coordinate") != 0
+        || strcasecmp(field, "complex") == 0 || strcasecmp(symmetry, "hermitian") == 0) {
+        fprintf(stderr, "%s: only real/integer/pattern coordinate Matrix Market files are supported\n", path);
+        munmap((void*)data, size);
+        return -1;
+    }
+
+    // Skip comments, then the size line
+    const char *p = eol ? eol + 1 : end;
+    while (p < end && (*p == '%' || *p == '\n' || *p == '\r')) {
+        const char *e = memchr(p, '\n', end - p);
+        p = e ? e + 1 : end;
+    }
+    long rows, cols, entries;
+    const char *q = mtx_parse_long(p, end, &rows);
+    if (q) q = mtx_parse_long(q, end, &cols);
+    if (q) q = mtx_parse_long(q, end, &entries);
+    if (!q || rows <= 0 || cols <= 0 || entries < 0) {
+        fprintf(stderr, "%s: bad size line\n", path);
+        munmap((void*)data, size);
+        return -1;
+    }
+    if (rows > INT32_MAX || cols > INT32_MAX) {
+        fprintf(stderr, "%s: %ld x %ld exceeds the 32-bit CSRMatrix dimensions\n", path, rows, cols);
+        munmap((void*)data, size);
+        return -1;
+    }
+    const char *e = memchr(q, '\n', end - q);
+    const char *body = e ? e + 1 : end;
+
+    // Split the body into n_threads byte ranges, each moved forward to a line start
+    MtxChunk chunks[n_threads];
+    pthread_t threads[n_threads];
+    const char *cut[n_threads + 1];
+    cut[0] = body;
+    cut[n_threads] = end;
+    for (int t = 1; t < n_threads; t++) {
+        const char *c = body + (size_t)(end - body) * t / n_threads;
+        if (c < cut[t - 1]) c = cut[t - 1];
+        if (c > body && c[-1] != '\n') {
+            const char *nl = memchr(c, '\n', end - c);
+            c = nl ? nl + 1 : end;
+        }
+        cut[t] = c;
+    }
+    int symmetric = strcasecmp(symmetry, "symmetric") == 0 ? 1 : (strcasecmp(symmetry, "skew-symmetric") == 0 ? -1 : 0);
+    for (int t = 0; t < n_threads; t++) {
+        chunks[t] = (MtxChunk){.begin = cut[t], .end = cut[t + 1], .symmetric = symmetric,
+                               .pattern = strcasecmp(field, "pattern") == 0, .rows = (int)rows, .cols = (int)cols};
+        pthread_create(&threads[t], NULL, mtx_parse_worker, &chunks[t]);
+    }
+    int error = 0;
+    long long total = 0, lines = 0;
+    for (int t = 0; t < n_threads; t++) {
+        pthread_join(threads[t], NULL);
+        error |= chunks[t].error;
+        chunks[t].offset = total;
+        total += chunks[t].count;
+        lines += chunks[t].lines;
+    }
+    munmap((void*)data, size);
+    if (error) {
+        fprintf(stderr, "%s: malformed or out-of-range entry\n", path);
+        for (int t = 0; t < n_threads; t++) { free(chunks[t].r); free(chunks[t].c); free(chunks[t].v); }
+        return -1;
+    }
+    // A truncated (or padded) file must not load as a different matrix
+    if (lines != entries) {
+        fprintf(stderr, "%s: size line declares %ld entries, file has %lld\n", path, entries, lines);
+        for (int t = 0; t < n_threads; t++) { free(chunks[t].r); free(chunks[t].c); free(chunks[t].v); }
+        return -1;
+    }
+    if (total > INT32_MAX) {
+        fprintf(stderr, "%s: %lld entries exceed the 32-bit CSRMatrix offsets\n", path, total);
+        for (int t = 0; t < n_threads; t++) { free(chunks[t].r); free(chunks[t].c); free(chunks[t].v); }
+        return -1;
+    }
+
+    // Merge the per-thread entries, then COO -> CSR
+    int *coo_row = (int*)malloc(total * sizeof(int));
+    int *coo_col = (int*)malloc(total * sizeof(int));
+    double *coo_val = (double*)malloc(total * sizeof(double));
+    for (int t = 0; t < n_threads; t++) {
+        chunks[t].out_r = coo_row;
+        chunks[t].out_c = coo_col;
+        chunks[t].out_v = coo_val;
+        pthread_create(&threads[t], NULL, mtx_merge_worker, &chunks[t]);
+    }
+    for (int t = 0; t < n_threads; t++) pthread_join(threads[t], NULL);
+
+    *M = coo_to_csr((int)rows, (int)cols, total, coo_row, coo_col, coo_val, n_threads);
+    free(coo_row); free(coo_col); free(coo_val);
+    return 0;
+}
+
+// --- Binary CSR cache ---
+static inline int64_t csr_cache_align(int64_t off) {
+    return (off + 63) / 64 * 64;
+}
+
+// A single write() stops at 0x7ffff000 bytes on Linux: loop until the whole array is out
+static inline int csr_cache_pwrite(int fd, const void *buf, size_t bytes, int64_t off) {
+    size_t done = 0;
+    while (done < bytes) {
+        ssize_t put = pwrite(fd, (const char*)buf + done, bytes - done, off + done);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return 0;
+        done += put;
+    }
+    return 1;
+}
+
+static inline int csr_cache_write(const char *path, const CSRMatrix *M) {
+    CsrFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CSR_CACHE_MAGIC, 8);
+    h.rows = M->rows;
+    h.cols = M->cols;
+    h.nnz = M->nnz;
+    h.row_ptr_off = csr_cache_align(sizeof(h));
+    h.col_ind_off = csr_cache_align(h.row_ptr_off + (h.rows + 1) * (int64_t)sizeof(int));
+    h.values_off = csr_cache_align(h.col_ind_off + h.nnz * (int64_t)sizeof(int));
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) { perror(path); return -1; }
+    int ok = csr_cache_pwrite(fd, &h, sizeof(h), 0)
+          && csr_cache_pwrite(fd, M->row_ptr, (h.rows + 1) * sizeof(int), h.row_ptr_off)
+          && csr_cache_pwrite(fd, M->col_ind, h.nnz * sizeof(int), h.col_ind_off)
+          && csr_cache_pwrite(fd, M->values, h.nnz * sizeof(double), h.values_off);
+    close(fd);
+    if (!ok) {
+        fprintf(stderr, "%s: write failed\n", path);
+        unlink(path);
+        return -1;
+    }
+    return 0;
+}
+
+// Maps a cache file; M's arrays point into the read-only mapping
+static inline int csr_cache_map(const char *path, CSRMatrix *M, CsrMapping *map) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    fstat(fd, &st);
+    size_t size = (size_t)st.st_size;
+    if (size < sizeof(CsrFileHeader)) { close(fd); return -1; }
+    void *addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return -1;
+
+    const CsrFileHeader *h = (const CsrFileHeader*)addr;
+    // Every array must lie inside the file, so a truncated or corrupt cache is rejected
+    if (memcmp(h->magic, CSR_CACHE_MAGIC, 8) != 0 || h->rows <= 0 || h->rows > INT32_MAX
+        || h->cols < 0 || h->cols > INT32_MAX || h->nnz < 0 || h->nnz > INT32_MAX
+        || h->row_ptr_off < (int64_t)sizeof(CsrFileHeader) || h->col_ind_off < 0 || h->values_off < 0
+        || h->row_ptr_off + (h->rows + 1) * (int64_t)sizeof(int) > (int64_t)size
+        || h->col_ind_off + h->nnz * (int64_t)sizeof(int) > (int64_t)size
+        || h->values_off + h->nnz * (int64_t)sizeof(double) > (int64_t)size) {
+        fprintf(stderr, "%s: not a valid CSR cache file\n", path);
+        munmap(addr, size);
+        return -1;
+    }
+    M->rows = (int)h->rows;
+    M->cols = (int)h->cols;
+    M->nnz = (int)h->nnz;
+    M->row_ptr = (int*)((char*)addr + h->row_ptr_off);
+    M->col_ind = (int*)((char*)addr + h->col_ind_off);
+    M->values = (double*)((char*)addr + h->values_off);
+    map->addr = addr;
+    map->len = size;
+    return 0;
+}
+
+static inline void csr_release(CSRMatrix *M, CsrMapping *map) {
+    if (map->addr) munmap(map->addr, map->len);
+    else free_csr(M);
+    map->addr = NULL;
+}
+
+static inline int ends_with(const char *s, const char *suffix) {
+    size_t n = strlen(s), k = strlen(suffix);
+    return n >= k && strcmp(s + n - k, suffix) == 0;
+}
+
+// Loads `path` (.mtx or .csr), preferring an up-to-date cache; prints how
+static inline int load_matrix(const char *path, CSRMatrix *M, CsrMapping *map, int n_threads) {
+    map->addr = NULL;
+    double start = get_time();
+
+    char cache[4096];
+    struct stat src, dst;
+    if (ends_with(path, ".csr")) {
+        snprintf(cache, sizeof(cache), "%s", path);
+    } else {
+        snprintf(cache, sizeof(cache), "%s.csr", path);
+        if (stat(path, &src) != 0) { perror(path); return -1; }
+        if (stat(cache, &dst) != 0 || dst.st_mtime < src.st_mtime) cache[0] = '\0';
+    }
+
+    if (cache[0] && csr_cache_map(cache, M, map) == 0) {
+        printf(">> Loaded %s: %d x %d, %d nnz, mmap zero-copy in %.3f ms\n",
+               cache, M->rows, M->cols, M->nnz, (get_time() - start) * 1e3);
+        return 0;
+    }
+    if (ends_with(path, ".csr")) {
+        fprintf(stderr, "%s: cannot load\n", path);
+        return -1;
+    }
+
+    if (mtx_read(path, M, n_threads) != 0) return -1;
+    printf(">> Parsed %s: %d x %d, %d nnz in %.3f sec (%d threads)\n",
+           path, M->rows, M->cols, M->nnz, get_time() - start, n_threads);
+    snprintf(cache, sizeof(cache), "%s.csr", path);
+    if (csr_cache_write(cache, M) == 0) printf(">> Wrote binary cache %s\n", cache);
+    return 0;
+}
+
+#endif
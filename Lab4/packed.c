@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "sparse.h"
+#include "sched.h"
+#include "mtx.h"
+#include "reorder.h"
+#include "packed.h"
+
+#define ROWS 500000           // Generated SpMV matrix: rows (= columns)
+#define NNZ_PER_ROW 16
+#define SPGEMM_ROWS 100000    // Generated SpGEMM operand (square)
+#define ITERATIONS 10         // Timed y = A*x iterations per variant
+#define SPMV_METHOD 0         // Static Block: equal rows, so only the format changes
+#define SPGEMM_METHOD 6       // Lock-free (Chunked): product rows vary in cost
+#define F32_TOLERANCE 1e-5    // float32 values carry ~6e-8 relative rounding per entry
+
+typedef struct {
+    const CSRMatrix *A;
+    const double *x;
+    double *y;
+} CsrSpmvContext;
+
+void csr_row(int r, RowTask *task) {
+    CsrSpmvContext *c = (CsrSpmvContext*)task->ctx;
+    const CSRMatrix *A = c->A;
+    double sum = 0.0;
+    for (int j = A->row_ptr[r]; j < A->row_ptr[r+1]; j++) {
+        sum += A->values[j] * c->x[A->col_ind[j]];
+    }
+    c->y[r] = sum;
+}
+
+// Norm-wise: float32 rounding is relative to the terms, and entries that cancel to ~0 would dominate an entry-wise error
+double max_rel_error(const double *y, const double *ref, int n) {
+    double err = 0.0, scale = 1e-300;
+    for (int i = 0; i < n; i++) {
+        if (fabs(y[i] - ref[i]) > err) err = fabs(y[i] - ref[i]);
+        if (fabs(ref[i]) > scale) scale = fabs(ref[i]);
+    }
+    return err / scale;
+}
+
+// SpGEMM products (u32 / f64 PackedCSR): pattern must match exactly; INFINITY otherwise
+double packed_max_rel_error(const PackedCSR *C, const PackedCSR *ref) {
+    if (C->rows != ref->rows || C->nnz != ref->nnz) return INFINITY;
+    for (int r = 0; r <= C->rows; r++) if (C->row_ptr[r] != ref->row_ptr[r]) return INFINITY;
+    for (int64_t k = 0; k < C->nnz; k++) if (C->col32[k] != ref->col32[k]) return INFINITY;
+    double err = 0.0, scale = 1e-300;
+    for (int64_t k = 0; k < C->nnz; k++) {
+        if (fabs(C->val64[k] - ref->val64[k]) > err) err = fabs(C->val64[k] - ref->val64[k]);
+        if (fabs(ref->val64[k]) > scale) scale = fabs(ref->val64[k]);
+    }
+    return err / scale;
+}
+
+void make_tasks(RowTask *tasks, int n_threads, int rows, void *ctx) {
+    for (int i = 0; i < n_threads; i++) {
+        tasks[i] = (RowTask){.thread_id = i, .num_threads = n_threads, .rows = rows, .ctx = ctx};
+    }
+}
+
+// Bytes/nnz, SpMV and (square A) SpGEMM C = A*A for every index x value variant of A;
+// returns 1 if any variant exceeds its tolerance, 0 otherwise
+int run_variants(const char *label, const CSRMatrix *A, const CSRMatrix *G, int iterations, int n_threads) {
+    printf("\n--- %s: SpMV %d x %d (%d nnz), SpGEMM %d x %d (%d nnz), %d threads ---\n",
+           label, A->rows, A->cols, A->nnz, G->rows, G->cols, G->nnz, n_threads);
+
+    // References: plain CSR SpMV, and the u32 / f64 packed SpGEMM (no compression)
+    double *x = (double*)malloc(A->cols * sizeof(double));
+    double *y = (double*)malloc(A->rows * sizeof(double));
+    double *y_ref = (double*)malloc(A->rows * sizeof(double));
+    for (int i = 0; i < A->cols; i++) x[i] = 1.0 + (i % 17) * 0.125;
+    RowTask tasks[n_threads];
+    CsrSpmvContext csr_ctx = {.A = A, .x = x, .y = y_ref};
+    make_tasks(tasks, n_threads, A->rows, &csr_ctx);
+    run_method(SPMV_METHOD, n_threads, tasks, csr_row);
+    double start = get_time();
+    for (int it = 0; it < iterations; it++) run_method(SPMV_METHOD, n_threads, tasks, csr_row);
+    double csr_spmv = (get_time() - start) / iterations;
+
+    long long *work = (long long*)malloc((G->rows + 1) * sizeof(long long));
+    work[0] = 0;
+    for (int r = 0; r < G->rows; r++) {
+        long long w = 0;
+        for (int k = G->row_ptr[r]; k < G->row_ptr[r+1]; k++) w += G->row_ptr[G->col_ind[k]+1] - G->row_ptr[G->col_ind[k]];
+        work[r + 1] = work[r] + w;
+    }
+    PackedCSR C_ref = {0};
+    double spgemm_base = 0.0;
+    int ok = 1;
+
+    printf("| %-20s | %-9s | %-9s | %-10s | %-7s | %-10s | %-7s | %-9s |\n",
+           "Variant", "Bytes/nnz", "Pack", "SpMV", "Speedup", "SpGEMM", "Speedup", "Max error");
+    printf("|----------------------|-----------|-----------|------------|---------|------------|---------|-----------|\n");
+    printf("| %-20s | %9.2f | %-9s | %8.3fms | %6.2fx | %-10s | %-7s | %-9s |\n",
+           "CSRMatrix (int32)", csr_bytes_per_nnz(A), "-", csr_spmv * 1e3, 1.0, "-", "-", "-");
+
+    for (int val = 0; val < NUM_PACK_VAL; val++) {
+        for (int idx = 0; idx < NUM_PACK_IDX; idx++) {
+            char name[32];
+            snprintf(name, sizeof(name), "%s / %s", pack_idx_names[idx], pack_val_names[val]);
+            double tolerance = val == PACK_VAL_F32 ? F32_TOLERANCE : 1e-9;
+
+            // SpMV
+            start = get_time();
+            PackedCSR P = csr_pack(A, idx, val, n_threads);
+            double pack_time = get_time() - start;
+            PackedWorkspace ws[n_threads];
+            for (int t = 0; t < n_threads; t++) ws[t] = packed_workspace_create(&P, NULL);
+            PackedContext ctx = {.A = &P, .x = x, .y = y, .ws = ws};
+            make_tasks(tasks, n_threads, A->rows, &ctx);
+            run_method(SPMV_METHOD, n_threads, tasks, packed_spmv_row);     // Warm-up
+            double err = max_rel_error(y, y_ref, A->rows);
+            start = get_time();
+            for (int it = 0; it < iterations; it++) run_method(SPMV_METHOD, n_threads, tasks, packed_spmv_row);
+            double spmv = (get_time() - start) / iterations;
+            double bytes = packed_bytes_per_nnz(&P);
+            for (int t = 0; t < n_threads; t++) packed_workspace_free(&ws[t]);
+            free_packed(&P);
+
+            // SpGEMM C = G * G, result a u32 / f64 PackedCSR (64-bit row_ptr)
+            PackedCSR Q = csr_pack(G, idx, val, n_threads);
+            for (int t = 0; t < n_threads; t++) ws[t] = packed_workspace_create(&Q, &Q);
+            PackedCSR C;
+            PackedContext gctx = {.A = &Q, .B = &Q, .C = &C, .ws = ws};
+            make_tasks(tasks, n_threads, G->rows, &gctx);
+            start = get_time();
+            packed_spgemm(SPGEMM_METHOD, n_threads, tasks, work);
+            double spgemm = get_time() - start;
+            if (idx == PACK_IDX_U32 && val == PACK_VAL_F64) {
+                C_ref = C;
+                spgemm_base = spgemm;
+            } else {
+                double e = packed_max_rel_error(&C, &C_ref);
+                if (e > err) err = e;
+                free_packed(&C);
+            }
+            for (int t = 0; t < n_threads; t++) packed_workspace_free(&ws[t]);
+            free_packed(&Q);
+
+            printf("| %-20s | %9.2f | %8.4fs | %8.3fms | %6.2fx | %9.4fs | %6.2fx | %9.2e |\n",
+                   name, bytes, pack_time, spmv * 1e3, csr_spmv / spmv, spgemm, spgemm_base / spgemm, err);
+            if (err > tolerance) {
+                printf("ERROR in %s: max relative error %.3e above %.0e\n", name, err, tolerance);
+                ok = 0;
+            }
+        }
+    }
+
+    free(x); free(y); free(y_ref);
+    free(work);
+    free_packed(&C_ref);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    int n_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n_threads < 1) n_threads = 1;
+    int from_file = argc > 2 && strcmp(argv[1], "--matrix") == 0;
+    int iterations = from_file && argc > 3 ? atoi(argv[3]) : ITERATIONS;
+
+    printf("=== Compressed CSR (packed indices, float32 values) Benchmark (Pthreads) ===\n");
+    int status = 0;
+
+    if (from_file) {
+        CSRMatrix A;
+        CsrMapping mapA = {0};
+        if (load_matrix(argv[2], &A, &mapA, n_threads) != 0) return 1;
+        if (A.rows != A.cols) {
+            fprintf(stderr, "%s: C = A * A needs a square matrix (%d x %d)\n", argv[2], A.rows, A.cols);
+            csr_release(&A, &mapA);
+            return 1;
+        }
+        status |= run_variants("Natural order", &A, &A, iterations, n_threads);
+
+        // Delta and block16 indices shrink with the gaps between columns: RCM narrows the band
+        Permutation p = reorder(ORDER_RCM, &A, 0);
+        CSRMatrix R = permute_symmetric(&A, &p, n_threads);
+        status |= run_variants("RCM order", &R, &R, iterations, n_threads);
+        free_csr(&R);
+        permutation_free(&p);
+        csr_release(&A, &mapA);
+    } else {
+        int rows = argc > 1 ? atoi(argv[1]) : ROWS;
+        double per_row = argc > 2 ? atof(argv[2]) : NNZ_PER_ROW;
+        int spgemm_rows = argc > 3 ? atoi(argv[3]) : SPGEMM_ROWS;
+        CSRMatrix A = generateSparseCSR(rows, rows, per_row / rows, 42, n_threads);
+        CSRMatrix G = generateSparseCSR(spgemm_rows, spgemm_rows, per_row / spgemm_rows, 43, n_threads);
+        status |= run_variants("Uniform random", &A, &G, iterations, n_threads);
+        free_csr(&A);
+        free_csr(&G);
+    }
+
+    return status;
+}
@@ -0,0 +1,418 @@
+#ifndef LAB4_PACKED_H
+#define LAB4_PACKED_H
+
+/*
+ * Compressed CSR for the bandwidth-bound kernels.
+ *
+ * CSRMatrix streams 4 bytes of column index and 8 bytes of value per
+ * non-zero. PackedCSR shrinks both:
+ *
+ *   index modes
+ *     PACK_IDX_U32     - plain 32-bit columns (baseline layout)
+ *     PACK_IDX_DELTA   - per row: first column, then the gaps between consecutive
+ *                        columns bit-packed at the width of the row's largest gap
+ *     PACK_IDX_BLOCK16 - columns split into blocks of 65536; a row is a list of
+ *                        (block, length) segments followed by 16-bit offsets
+ *   value modes
+ *     PACK_VAL_F64 / PACK_VAL_F32 - float32 storage; kernels accumulate in double
+ *
+ * All offsets (row_ptr, bit and segment pointers) are 64-bit, so a
+ * PackedCSR can hold more than 2^31 non-zeros. csr_pack() starts from a
+ * CSRMatrix and so stays below that; packed_spgemm() is the 64-bit builder: it
+ * counts C's rows, prefix-sums them into an int64 row_ptr and writes C as a
+ * u32 / f64 PackedCSR, so a product past 2^31 non-zeros is representable
+ * (rows are still below 2^31 long, as they hold distinct int columns).
+ *
+ * Kernels decode one row at a time into a small per-thread buffer
+ * (packed_row_cols / packed_row_vals), which stays in L1.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sparse.h"
+#include "sched.h"
+
+typedef enum { PACK_IDX_U32 = 0, PACK_IDX_DELTA, PACK_IDX_BLOCK16, NUM_PACK_IDX } PackIndexMode;
+typedef enum { PACK_VAL_F64 = 0, PACK_VAL_F32, NUM_PACK_VAL } PackValueMode;
+static const char *pack_idx_names[NUM_PACK_IDX] __attribute__((unused)) = {"u32", "delta+bitpack", "block16"};
+static const char *pack_val_names[NUM_PACK_VAL] __attribute__((unused)) = {"f64", "f32"};
+
+#define PACK_BLOCK_BITS 16
+#define PACK_SEG_MAX 65535          // Longest segment; longer runs in one block are split
+
+typedef struct {
+    int rows, cols;
+    int64_t nnz;
+    PackIndexMode idx;
+    PackValueMode val;
+    int64_t *row_ptr;       // rows + 1, into the values (and u32 / block16 offsets)
+    int max_row;            // Longest row, for decode buffers
+
+    uint32_t *col32;        // PACK_IDX_U32
+    uint8_t *bits;          // PACK_IDX_DELTA: bit stream, 8 bytes of padding at the end
+    int64_t *bit_ptr;       //   rows + 1, bit offset of each row
+    uint8_t *width;         //   bits per gap of each row
+    int *first;             //   first column of each row
+    uint16_t *col16;        // PACK_IDX_BLOCK16: low 16 bits of each column
+    int64_t *seg_ptr;       //   rows + 1, into seg_block / seg_len
+    uint16_t *seg_block;    //   block (column >> 16) of each segment
+    uint16_t *seg_len;
+
+    double *val64;
+    float *val32;
+} PackedCSR;
+
+static inline int pack_bits_for(uint32_t v) {
+    int b = 1;
+    while (b < 32 && (v >> b)) b++;
+    return b;
+}
+
+// Bytes the matrix occupies (all arrays), per non-zero
+static inline double packed_bytes_per_nnz(const PackedCSR *P) {
+    double bytes = (P->rows + 1) * 8.0;
+    if (P->idx == PACK_IDX_U32) bytes += P->nnz * 4.0;
+    if (P->idx == PACK_IDX_DELTA) bytes += (P->rows + 1) * 8.0 + P->rows * 5.0 + P->bit_ptr[P->rows] / 8;
+    if (P->idx == PACK_IDX_BLOCK16) bytes += (P->rows + 1) * 8.0 + P->seg_ptr[P->rows] * 4.0 + P->nnz * 2.0;
+    bytes += P->nnz * (P->val == PACK_VAL_F32 ? 4.0 : 8.0);
+    return P->nnz ? bytes / P->nnz : 0.0;
+}
+
+static inline double csr_bytes_per_nnz(const CSRMatrix *A) {
+    return A->nnz ? ((A->rows + 1) * 4.0 + A->nnz * 12.0) / A->nnz : 0.0;
+}
+
+// --- Decoding ---
+
+// Columns of row r into cols[]; returns the row length
+static inline int packed_row_cols(const PackedCSR *P, int r, int *cols) {
+    int64_t begin = P->row_ptr[r];
+    int len = (int)(P->row_ptr[r+1] - begin);
+    if (P->idx == PACK_IDX_U32) {
+        for (int i = 0; i < len; i++) cols[i] = (int)P->col32[begin + i];
+    } else if (P->idx == PACK_IDX_DELTA) {
+        int64_t pos = P->bit_ptr[r];
+        int w = P->width[r];
+        uint64_t mask = (1ULL << w) - 1;
+        int col = P->first[r];
+        if (len > 0) cols[0] = col;
+        for (int i = 1; i < len; i++, pos += w) {
+            uint64_t word;
+            memcpy(&word, P->bits + (pos >> 3), sizeof(word));     // Unaligned 64-bit load
+            col += (int)((word >> (pos & 7)) & mask);
+            cols[i] = col;
+        }
+    } else {
+        int i = 0;
+        for (int64_t s = P->seg_ptr[r]; s < P->seg_ptr[r+1]; s++) {
+            int base = (int)P->seg_block[s] << PACK_BLOCK_BITS;
+            for (int end = i + P->seg_len[s]; i < end; i++) cols[i] = base + P->col16[begin + i];
+        }
+    }
+    return len;
+}
+
+static inline void packed_row_vals(const PackedCSR *P, int r, double *vals) {
+    int64_t begin = P->row_ptr[r];
+    int len = (int)(P->row_ptr[r+1] - begin);
+    if (P->val == PACK_VAL_F32) {
+        for (int i = 0; i < len; i++) vals[i] = P->val32[begin + i];
+    } else {
+        memcpy(vals, P->val64 + begin, len * sizeof(double));
+    }
+}
+
+// --- CSR -> PackedCSR ---
+typedef struct {
+    const CSRMatrix *A;
+    PackedCSR *P;
+} PackContext;
+
+// Pass 1: gap width and bit count (delta) or segment count (block16) of row r
+static inline void pack_size_row(int r, RowTask *task) {
+    PackContext *c = (PackContext*)task->ctx;
+    const CSRMatrix *A = c->A;
+    PackedCSR *P = c->P;
+    int begin = A->row_ptr[r], end = A->row_ptr[r+1];
+    if (P->idx == PACK_IDX_DELTA) {
+        uint32_t max_gap = 0;
+        for (int k = begin + 1; k < end; k++) {
+            uint32_t gap = (uint32_t)(A->col_ind[k] - A->col_ind[k-1]);
+            if (gap > max_gap) max_gap = gap;
+        }
+        P->width[r] = (uint8_t)pack_bits_for(max_gap);
+        P->first[r] = end > begin ? A->col_ind[begin] : 0;
+        P->bit_ptr[r+1] = end > begin ? (int64_t)P->width[r] * (end - begin - 1) : 0;
+    } else if (P->idx == PACK_IDX_BLOCK16) {
+        int64_t segs = 0;
+        for (int k = begin, len = 0; k < end; k++) {
+            if (k == begin || (A->col_ind[k] >> PACK_BLOCK_BITS) != (A->col_ind[k-1] >> PACK_BLOCK_BITS) || len == PACK_SEG_MAX) {
+                segs++;
+                len = 0;
+            }
+            len++;
+        }
+        P->seg_ptr[r+1] = segs;
+    }
+}
+
+// Pass 2: write row r at the offsets from the prefix sums
+static inline void pack_fill_row(int r, RowTask *task) {
+    PackContext *c = (PackContext*)task->ctx;
+    const CSRMatrix *A = c->A;
+    PackedCSR *P = c->P;
+    int begin = A->row_ptr[r], end = A->row_ptr[r+1];
+    int64_t dst = P->row_ptr[r];
+
+    if (P->idx == PACK_IDX_U32) {
+        for (int k = begin; k < end; k++) P->col32[dst + k - begin] = (uint32_t)A->col_ind[k];
+    } else if (P->idx == PACK_IDX_DELTA) {
+        // Bit writer; rows start on byte boundaries, so no two rows (threads) share a byte
+        uint8_t *out = P->bits + (P->bit_ptr[r] >> 3);
+        int w = P->width[r];
+        uint64_t acc = 0;
+        int n_bits = 0;
+        for (int k = begin + 1; k < end; k++) {
+            acc |= (uint64_t)(A->col_ind[k] - A->col_ind[k-1]) << n_bits;
+            n_bits += w;
+            for (; n_bits >= 8; n_bits -= 8, acc >>= 8) *out++ = (uint8_t)acc;
+        }
+        if (n_bits > 0) *out = (uint8_t)acc;
+    } else {
+        int64_t s = P->seg_ptr[r] - 1;
+        for (int k = begin, len = 0; k < end; k++) {
+            if (k == begin || (A->col_ind[k] >> PACK_BLOCK_BITS) != (A->col_ind[k-1] >> PACK_BLOCK_BITS) || len == PACK_SEG_MAX) {
+                s++;
+                P->seg_block[s] = (uint16_t)(A->col_ind[k] >> PACK_BLOCK_BITS);
+                P->seg_len[s] = 0;
+                len = 0;
+            }
+            P->seg_len[s]++;
+            len++;
+            P->col16[dst + k - begin] = (uint16_t)(A->col_ind[k] & ((1 << PACK_BLOCK_BITS) - 1));
+        }
+    }
+
+    for (int k = begin; k < end; k++) {
+        if (P->val == PACK_VAL_F32) P->val32[dst + k - begin] = (float)A->values[k];
+        else P->val64[dst + k - begin] = A->values[k];
+    }
+}
+
+static inline PackedCSR csr_pack(const CSRMatrix *A, PackIndexMode idx, PackValueMode val, int n_threads) {
+    PackedCSR P;
+    memset(&P, 0, sizeof(P));
+    P.rows = A->rows;
+    P.cols = A->cols;
+    P.nnz = A->nnz;
+    P.idx = idx;
+    P.val = val;
+    P.row_ptr = (int64_t*)malloc((A->rows + 1) * sizeof(int64_t));
+    P.max_row = 0;
+    for (int r = 0; r <= A->rows; r++) P.row_ptr[r] = A->row_ptr[r];
+    for (int r = 0; r < A->rows; r++) {
+        if (A->row_ptr[r+1] - A->row_ptr[r] > P.max_row) P.max_row = A->row_ptr[r+1] - A->row_ptr[r];
+    }
+
+    if (idx == PACK_IDX_DELTA) {
+        P.width = (uint8_t*)malloc(A->rows ? A->rows : 1);
+        P.first = (int*)malloc((A->rows + 1) * sizeof(int));
+        P.bit_ptr = (int64_t*)calloc(A->rows + 1, sizeof(int64_t));
+    } else if (idx == PACK_IDX_BLOCK16) {
+        P.seg_ptr = (int64_t*)calloc(A->rows + 1, sizeof(int64_t));
+    }
+    PackContext ctx = {.A = A, .P = &P};
+    if (idx != PACK_IDX_U32) parallel_rows(A->rows, n_threads, pack_size_row, &ctx);
+
+    // 64-bit prefix sums; delta rows are rounded up to whole bytes
+    if (idx == PACK_IDX_DELTA) {
+        for (int r = 0; r < A->rows; r++) P.bit_ptr[r+1] = P.bit_ptr[r] + ((P.bit_ptr[r+1] + 7) & ~7LL);
+        P.bits = (uint8_t*)calloc(P.bit_ptr[A->rows] / 8 + 8, 1);
+    } else if (idx == PACK_IDX_BLOCK16) {
+        for (int r = 0; r < A->rows; r++) P.seg_ptr[r+1] += P.seg_ptr[r];
+        P.seg_block = (uint16_t*)malloc((P.seg_ptr[A->rows] + 1) * sizeof(uint16_t));
+        P.seg_len = (uint16_t*)malloc((P.seg_ptr[A->rows] + 1) * sizeof(uint16_t));
+        P.col16 = (uint16_t*)malloc((P.nnz + 1) * sizeof(uint16_t));
+    } else {
+        P.col32 = (uint32_t*)malloc((P.nnz + 1) * sizeof(uint32_t));
+    }
+    if (val == PACK_VAL_F32) P.val32 = (float*)malloc((P.nnz + 1) * sizeof(float));
+    else P.val64 = (double*)malloc((P.nnz + 1) * sizeof(double));
+
+    parallel_rows(A->rows, n_threads, pack_fill_row, &ctx);
+    return P;
+}
+
+static inline void free_packed(PackedCSR *P) {
+    free(P->row_ptr); free(P->col32);
+    free(P->bits); free(P->bit_ptr); free(P->width); free(P->first);
+    free(P->col16); free(P->seg_ptr); free(P->seg_block); free(P->seg_len);
+    free(P->val64); free(P->val32);
+}
+
+// --- Kernels ---
+typedef struct {
+    int *a_cols;            // Decoded row of A (max_row of A)
+    double *a_vals;
+    int *b_cols;            // Decoded row of B (max_row of B)
+    double *b_vals;
+    int *marker;            // SpGEMM accumulator over the columns of B
+    int *cols;
+    double *acc;
+} PackedWorkspace;
+
+typedef struct {
+    const PackedCSR *A;
+    const PackedCSR *B;
+    PackedCSR *C;           // SpGEMM result (u32 / f64); row_ptr[r + 1] holds the symbolic counts
+    const double *x;        // SpMV
+    double *y;
+    PackedWorkspace *ws;    // One per thread, indexed by thread_id
+} PackedContext;
+
+static inline PackedWorkspace packed_workspace_create(const PackedCSR *A, const PackedCSR *B) {
+    PackedWorkspace ws = {0};
+    ws.a_cols = (int*)malloc((A->max_row + 1) * sizeof(int));
+    ws.a_vals = (double*)malloc((A->max_row + 1) * sizeof(double));
+    if (B) {
+        ws.b_cols = (int*)malloc((B->max_row + 1) * sizeof(int));
+        ws.b_vals = (double*)malloc((B->max_row + 1) * sizeof(double));
+        ws.marker = (int*)malloc(B->cols * sizeof(int));
+        ws.cols = (int*)malloc(B->cols * sizeof(int));
+        ws.acc = (double*)malloc(B->cols * sizeof(double));
+        for (int i = 0; i < B->cols; i++) ws.marker[i] = -1;
+    }
+    return ws;
+}
+
+static inline void packed_workspace_reset(PackedWorkspace *ws, int cols) {
+    for (int i = 0; i < cols; i++) ws->marker[i] = -1;
+}
+
+static inline void packed_workspace_free(PackedWorkspace *ws) {
+    free(ws->a_cols); free(ws->a_vals); free(ws->b_cols); free(ws->b_vals);
+    free(ws->marker); free(ws->cols); free(ws->acc);
+}
+
+// Sum over row r of value * x[column], decoding in the same loop (no row buffer)
+#define PACKED_ROW_DOT(VALS) do { \
+    if (P->idx == PACK_IDX_U32) { \
+        const uint32_t *cols = P->col32 + begin; \
+        for (int i = 0; i < len; i++) sum += (double)(VALS)[i] * x[cols[i]]; \
+    } else if (P->idx == PACK_IDX_DELTA) { \
+        int64_t pos = P->bit_ptr[r]; \
+        int w = P->width[r]; \
+        uint64_t mask = (1ULL << w) - 1; \
+        int col = P->first[r]; \
+        if (len > 0) sum = (double)(VALS)[0] * x[col]; \
+        for (int i = 1; i < len; i++, pos += w) { \
+            uint64_t word; \
+            memcpy(&word, P->bits + (pos >> 3), sizeof(word)); \
+            col += (int)((word >> (pos & 7)) & mask); \
+            sum += (double)(VALS)[i] * x[col]; \
+        } \
+    } else { \
+        const uint16_t *low = P->col16 + begin; \
+        int i = 0; \
+        for (int64_t s = P->seg_ptr[r]; s < P->seg_ptr[r+1]; s++) { \
+            const double *xb = x + ((int64_t)P->seg_block[s] << PACK_BLOCK_BITS); \
+            for (int end = i + P->seg_len[s]; i < end; i++) sum += (double)(VALS)[i] * xb[low[i]]; \
+        } \
+    } \
+} while (0)
+
+static inline void packed_spmv_row(int r, RowTask *task) {
+    PackedContext *c = (PackedContext*)task->ctx;
+    const PackedCSR *P = c->A;
+    const double *x = c->x;
+    int64_t begin = P->row_ptr[r];
+    int len = (int)(P->row_ptr[r+1] - begin);
+    double sum = 0.0;
+    if (P->val == PACK_VAL_F32) PACKED_ROW_DOT(P->val32 + begin);
+    else PACKED_ROW_DOT(P->val64 + begin);
+    c->y[r] = sum;
+}
+
+static inline void packed_spgemm_symbolic_row(int r, RowTask *task) {
+    PackedContext *c = (PackedContext*)task->ctx;
+    PackedWorkspace *ws = &c->ws[task->thread_id];
+    int len = packed_row_cols(c->A, r, ws->a_cols);
+    int count = 0;
+    for (int i = 0; i < len; i++) {
+        int n = packed_row_cols(c->B, ws->a_cols[i], ws->b_cols);
+        for (int m = 0; m < n; m++) {
+            int col = ws->b_cols[m];
+            if (ws->marker[col] != r) {
+                ws->marker[col] = r;
+                count++;
+            }
+        }
+    }
+    c->C->row_ptr[r+1] = count;
+}
+
+static inline void packed_spgemm_numeric_row(int r, RowTask *task) {
+    PackedContext *c = (PackedContext*)task->ctx;
+    PackedWorkspace *ws = &c->ws[task->thread_id];
+    int len = packed_row_cols(c->A, r, ws->a_cols);
+    packed_row_vals(c->A, r, ws->a_vals);
+    int count = 0;
+    for (int i = 0; i < len; i++) {
+        int k = ws->a_cols[i];
+        int n = packed_row_cols(c->B, k, ws->b_cols);
+        packed_row_vals(c->B, k, ws->b_vals);
+        double a = ws->a_vals[i];
+        for (int m = 0; m < n; m++) {
+            int col = ws->b_cols[m];
+            if (ws->marker[col] != r) {
+                ws->marker[col] = r;
+                ws->cols[count++] = col;
+                ws->acc[col] = 0.0;
+            }
+            ws->acc[col] += a * ws->b_vals[m];
+        }
+    }
+    qsort(ws->cols, count, sizeof(int), compare_int);
+    int64_t dst = c->C->row_ptr[r];
+    for (int p = 0; p < count; p++) {
+        c->C->col32[dst + p] = (uint32_t)ws->cols[p];
+        c->C->val64[dst + p] = ws->acc[ws->cols[p]];
+    }
+}
+
+// C = A * B from packed operands into a u32 / f64 PackedCSR with 64-bit row_ptr.
+// tasks[t].ctx must all point to the same PackedContext with n_threads workspaces.
+static inline void packed_spgemm(int method, int n_threads, RowTask *tasks, const long long *work_prefix) {
+    PackedContext *c = (PackedContext*)tasks[0].ctx;
+    const PackedCSR *A = c->A, *B = c->B;
+    PackedCSR *C = c->C;
+    memset(C, 0, sizeof(*C));
+    C->rows = A->rows;
+    C->cols = B->cols;
+    C->idx = PACK_IDX_U32;
+    C->val = PACK_VAL_F64;
+    C->row_ptr = (int64_t*)calloc(C->rows + 1, sizeof(int64_t));
+
+    if (method_partitions[method] != PART_NONE) {
+        partition_rows(method_partitions[method], work_prefix, A->rows, n_threads, tasks);
+    }
+
+    for (int t = 0; t < n_threads; t++) packed_workspace_reset(&c->ws[t], B->cols);
+    run_method(method, n_threads, tasks, packed_spgemm_symbolic_row);
+
+    // 64-bit prefix sum, as in csr_pack()
+    for (int r = 0; r < C->rows; r++) {
+        if (C->row_ptr[r+1] > C->max_row) C->max_row = (int)C->row_ptr[r+1];
+        C->row_ptr[r+1] += C->row_ptr[r];
+    }
+    C->nnz = C->row_ptr[C->rows];
+    C->col32 = (uint32_t*)malloc((C->nnz + 1) * sizeof(uint32_t));
+    C->val64 = (double*)malloc((C->nnz + 1) * sizeof(double));
+
+    for (int t = 0; t < n_threads; t++) packed_workspace_reset(&c->ws[t], B->cols);
+    run_method(method, n_threads, tasks, packed_spgemm_numeric_row);
+}
+
+#endif
@@ -1,257 +1,763 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <unistd.h>
 #include <sys/time.h>
 #include <limits.h>
+#include <math.h>
+
+#include "sparse.h"
+#include "sched.h"
+#include "mtx.h"
+#include "reorder.h"
+#include "hybrid.h"
+#include "transpose.h"
 
 #define N 4096           // Matrix Dimension (4096 x 4096)
 #define SPARSITY 0.96    // 96% Zeros (Highly Sparse)
-#define CHUNK_SIZE 64    // Base Chunk size for Dynamic/Guided methods
+#define ESC_MAX_FLOPS 32 // Rows with at most this many products use expand-sort-compress
+#define HASH_RATIO 8     // Hash accumulator while flops < cols / HASH_RATIO, dense SPA above
+#define LEAF_ROWS 4096   // BFS bisection: rows per part (a part of B should stay cache resident)
+#define REORDER_RUNS 3   // Timed SpGEMM runs per ordering (best is reported)
+#define HYBRID_N 2048    // Matrix dimension of the --hybrid sparsity sweep
 
-// --- Data Structures ---
-typedef struct {
-    int *row_ptr;   // CSR Row Pointer
-    int *col_ind;   // CSR Column Indices
-    double *values; // CSR Values
-    int nnz;        // Number of Non-Zero elements
-    int rows;
-    int cols;
-} CSRMatrix;
+// Row accumulators for the numeric phase, chosen per row from its flops estimate
+enum { ACC_SPA = 0, ACC_HASH, ACC_ESC, NUM_ACC };
+const char *acc_names[NUM_ACC] = {"Dense SPA", "Hash", "ESC"};
 
+// Per-thread scratch, allocated once per worker and reused for every row
 typedef struct {
-    int thread_id;
-    int num_threads;
+    int *marker;        // Last row that touched each column of C (-1 = none)
+    double *acc;        // Dense SPA values
+    int *cols;          // Columns touched by the current row
+    int *hash_keys;     // Open-addressing table (-1 = empty), hash_cap slots
+    double *hash_vals;
+    int hash_cap;       // Power of two >= 2 * the largest flops routed to the hash
+    Product *esc;       // Expanded products of a short row, ESC_MAX_FLOPS entries
+    long rows_by_acc[NUM_ACC];  // How many rows each accumulator handled
+} Workspace;
+
+// Per-thread SpGEMM state, reached from the scheduler through RowTask.ctx
+typedef struct ThreadData {
     CSRMatrix *A;
     CSRMatrix *B;
-    double *C;
+    CSRMatrix *C;   // Sparse result; row_ptr is filled in between the two phases
+    int *row_nnz;   // Symbolic phase output: exact nnz of each row of C
+    Workspace *ws;  // This thread's scratch
+    int upper;      // Only columns >= r in row r of C (A * A^T with B = A^T, see spgemm_aat)
 } ThreadData;
 
-// --- Global Variables for Synchronization ---
-int global_row_counter = 0;
-pthread_mutex_t queue_mutex;
+// Prefix sum of per-row work (flops), rebuilt by the partitioned schedulers
+long long *row_work_prefix;
 
-// --- Helper Functions ---
-double get_time() {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return tv.tv_sec + tv.tv_usec * 1e-6;
+void reset_workspace(Workspace *ws, int num_threads, int cols) {
+    for (int t = 0; t < num_threads; t++)
+        for (int c = 0; c < cols; c++) ws[t].marker[c] = -1;
 }
 
-void reset_result(double *C, int size) {
-    for (int i = 0; i < size; i++) C[i] = 0.0;
+Workspace workspace_create(int cols) {
+    Workspace ws;
+    ws.marker = (int*)malloc(cols * sizeof(int));
+    ws.acc = (double*)malloc(cols * sizeof(double));
+    ws.cols = (int*)malloc(cols * sizeof(int));
+    ws.hash_cap = 1;
+    while (ws.hash_cap < 2 * (cols / HASH_RATIO + 1)) ws.hash_cap <<= 1;
+    ws.hash_keys = (int*)malloc(ws.hash_cap * sizeof(int));
+    ws.hash_vals = (double*)malloc(ws.hash_cap * sizeof(double));
+    ws.esc = (Product*)malloc(ESC_MAX_FLOPS * sizeof(Product));
+    for (int a = 0; a < NUM_ACC; a++) ws.rows_by_acc[a] = 0;
+    return ws;
 }
 
-// Convert Dense Matrix to CSR Format
-CSRMatrix convertToCSR(double *matrix, int rows, int cols) {
-    CSRMatrix csr;
-    csr.rows = rows;
-    csr.cols = cols;
-    csr.row_ptr = (int*)malloc((rows + 1) * sizeof(int));
-
-    // First pass: Count Non-Zeros
-    int nnz = 0;
-    for (int i = 0; i < rows * cols; i++) if (matrix[i] != 0.0) nnz++;
-    csr.nnz = nnz;
+void workspace_free(Workspace *ws) {
+    free(ws->marker); free(ws->acc); free(ws->cols);
+    free(ws->hash_keys); free(ws->hash_vals); free(ws->esc);
+}
 
-    // Allocate memory
-    csr.col_ind = (int*)malloc(nnz * sizeof(int));
-    csr.values = (double*)malloc(nnz * sizeof(double));
+// --- CORE PROCESSING KERNELS (two-phase SpGEMM) ---
+
+// First entry of B row col_a that row r of C uses: all of it, or with `upper`
+// only columns >= r (B rows are column-sorted, so a binary search)
+static inline int b_row_begin(ThreadData *data, int col_a, int r) {
+    CSRMatrix *B = data->B;
+    int lo = B->row_ptr[col_a], hi = B->row_ptr[col_a+1];
+    if (!data->upper) return lo;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (B->col_ind[mid] < r) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
 
-    // Second pass: Fill arrays
+// Phase 1 (symbolic): count the distinct columns of row r of C
+void symbolic_row(int r, RowTask *task) {
+    ThreadData *data = (ThreadData*)task->ctx;
+    CSRMatrix *A = data->A, *B = data->B;
+    int *marker = data->ws->marker;
     int count = 0;
-    for (int i = 0; i < rows; i++) {
-        csr.row_ptr[i] = count;
-        for (int j = 0; j < cols; j++) {
-            double val = matrix[i * cols + j];
-            if (val != 0.0) {
-                csr.values[count] = val;
-                csr.col_ind[count] = j;
+
+    for (int j = A->row_ptr[r]; j < A->row_ptr[r+1]; j++) {
+        int col_a = A->col_ind[j];
+        for (int k = b_row_begin(data, col_a, r); k < B->row_ptr[col_a+1]; k++) {
+            int col_b = B->col_ind[k];
+            if (marker[col_b] != r) {
+                marker[col_b] = r;
                 count++;
             }
         }
     }
-    csr.row_ptr[rows] = count;
-    return csr;
+    data->row_nnz[r] = count;
 }
 
-// Generate Random Sparse Matrix
-void generateRandomSparseMatrix(double *matrix, int rows, int cols, float sparsity) {
-    srand(42);
-    for (int i = 0; i < rows * cols; i++) {
-        if (((double)rand() / RAND_MAX) > sparsity) {
-            matrix[i] = ((double)rand() / RAND_MAX) * 10.0;
-        } else {
-            matrix[i] = 0.0;
-        }
+// Upper bound on the nnz of row r of C: the number of partial products
+static inline int row_flops(int r, CSRMatrix *A, CSRMatrix *B) {
+    int flops = 0;
+    for (int j = A->row_ptr[r]; j < A->row_ptr[r+1]; j++) {
+        int col_a = A->col_ind[j];
+        flops += B->row_ptr[col_a+1] - B->row_ptr[col_a];
     }
+    return flops;
 }
 
-// Observation Function
-int isSparse(double *matrix, int rows, int cols) {
-    long long zero_count = 0;
-    long long total = (long long)rows * cols;
-    for (int i = 0; i < total; i++) {
-        if (matrix[i] == 0.0) zero_count++;
-    }
-    double ratio = (double)zero_count / total;
-    printf(">> Observation: Matrix Density is %.2f%% (Sparsity: %.2f%%)\n", 
-           (1.0-ratio)*100, ratio * 100);
-    return (ratio > 0.8);
-}
+// Dense SPA: marker + dense value array, O(1) per product, O(cols) scratch
+static void accumulate_spa(int r, ThreadData *data) {
+    CSRMatrix *A = data->A, *B = data->B, *C = data->C;
+    int *marker = data->ws->marker;
+    double *acc = data->ws->acc;
+    int *cols = data->ws->cols;
+    int count = 0;
 
-// --- CORE PROCESSING KERNEL ---
-void compute_row(int r, CSRMatrix *A, CSRMatrix *B, double *C) {
     for (int j = A->row_ptr[r]; j < A->row_ptr[r+1]; j++) {
         int col_a = A->col_ind[j];      // Index in A
         double val_a = A->values[j];    // Value in A
 
         // Multiply A value by corresponding row in B
-        for (int k = B->row_ptr[col_a]; k < B->row_ptr[col_a+1]; k++) {
+        for (int k = b_row_begin(data, col_a, r); k < B->row_ptr[col_a+1]; k++) {
             int col_b = B->col_ind[k];
             double val_b = B->values[k];
-            C[r * N + col_b] += val_a * val_b;
+            if (marker[col_b] != r) {
+                marker[col_b] = r;
+                acc[col_b] = val_a * val_b;
+                cols[count++] = col_b;
+            } else {
+                acc[col_b] += val_a * val_b;
+            }
         }
     }
-}
 
-// --- APPROACH 1: Static Scheduling (Block) ---
-void* method_static_block(void* arg) {
-    ThreadData* data = (ThreadData*)arg;
-    int chunk = data->A->rows / data->num_threads;
-    int start = data->thread_id * chunk;
-    int end = (data->thread_id == data->num_threads - 1) ? data->A->rows : start + chunk;
+    // Nearly-dense rows: a scan over the marker is cheaper than sorting
+    if (count > B->cols / 16) {
+        count = 0;
+        for (int c = 0; c < B->cols; c++) if (marker[c] == r) cols[count++] = c;
+    } else {
+        qsort(cols, count, sizeof(int), compare_int);
+    }
 
-    for (int i = start; i < end; i++) {
-        compute_row(i, data->A, data->B, data->C);
+    int base = C->row_ptr[r];
+    for (int p = 0; p < count; p++) {
+        C->col_ind[base + p] = cols[p];
+        C->values[base + p] = acc[cols[p]];
     }
-    pthread_exit(NULL);
 }
 
-// --- APPROACH 2: Dynamic Scheduling (Fine Grained) ---
-void* method_dynamic_fine(void* arg) {
-    ThreadData* data = (ThreadData*)arg;
-    int r;
-    while(1) {
-        pthread_mutex_lock(&queue_mutex);
-        if(global_row_counter >= data->A->rows) {
-            pthread_mutex_unlock(&queue_mutex);
-            break;
+// Fibonacci hashing: the top `bits` bits of the product. The low bits of col * odd
+// depend only on the low bits of col, so strided columns would share a slot
+static inline int hash_slot(int col, int bits) {
+    return (int)(((unsigned)col * 2654435761u) >> (32 - bits));
+}
+
+// Hash: open addressing sized from the row's flops, so scratch touched is O(flops)
+static void accumulate_hash(int r, int flops, ThreadData *data) {
+    CSRMatrix *A = data->A, *B = data->B, *C = data->C;
+    int *keys = data->ws->hash_keys;
+    double *vals = data->ws->hash_vals;
+    int *cols = data->ws->cols;
+    int cap = 2, bits = 1;
+    while (cap < 2 * flops) {
+        cap <<= 1;
+        bits++;
+    }
+    int mask = cap - 1;
+    for (int h = 0; h < cap; h++) keys[h] = -1;
+
+    for (int j = A->row_ptr[r]; j < A->row_ptr[r+1]; j++) {
+        int col_a = A->col_ind[j];
+        double val_a = A->values[j];
+        for (int k = b_row_begin(data, col_a, r); k < B->row_ptr[col_a+1]; k++) {
+            int col_b = B->col_ind[k];
+            int h = hash_slot(col_b, bits);
+            while (keys[h] != -1 && keys[h] != col_b) h = (h + 1) & mask;
+            if (keys[h] == -1) {
+                keys[h] = col_b;
+                vals[h] = val_a * B->values[k];
+            } else {
+                vals[h] += val_a * B->values[k];
+            }
         }
-        r = global_row_counter++;
-        pthread_mutex_unlock(&queue_mutex);
-        
-        compute_row(r, data->A, data->B, data->C);
     }
-    pthread_exit(NULL);
+
+    // Gather, sort by column, then look each value up again
+    int count = 0;
+    for (int h = 0; h < cap; h++) if (keys[h] != -1) cols[count++] = keys[h];
+    qsort(cols, count, sizeof(int), compare_int);
+
+    int base = C->row_ptr[r];
+    for (int p = 0; p < count; p++) {
+        int h = hash_slot(cols[p], bits);
+        while (keys[h] != cols[p]) h = (h + 1) & mask;
+        C->col_ind[base + p] = cols[p];
+        C->values[base + p] = vals[h];
+    }
 }
 
-// --- APPROACH 3: Dynamic Scheduling (Chunked) ---
-void* method_dynamic_chunk(void* arg) {
-    ThreadData* data = (ThreadData*)arg;
-    int start, end;
-    while(1) {
-        pthread_mutex_lock(&queue_mutex);
-        if(global_row_counter >= data->A->rows) {
-            pthread_mutex_unlock(&queue_mutex);
-            break;
+// ESC: expand every product, insertion-sort by column, compress duplicates
+static void accumulate_esc(int r, ThreadData *data) {
+    CSRMatrix *A = data->A, *B = data->B, *C = data->C;
+    Product *esc = data->ws->esc;
+    int n = 0;
+
+    for (int j = A->row_ptr[r]; j < A->row_ptr[r+1]; j++) {
+        int col_a = A->col_ind[j];
+        double val_a = A->values[j];
+        for (int k = b_row_begin(data, col_a, r); k < B->row_ptr[col_a+1]; k++) {
+            Product p = {B->col_ind[k], val_a * B->values[k]};
+            int q = n++;
+            while (q > 0 && esc[q-1].col > p.col) {
+                esc[q] = esc[q-1];
+                q--;
+            }
+            esc[q] = p;
         }
-        start = global_row_counter;
-        global_row_counter += CHUNK_SIZE;
-        pthread_mutex_unlock(&queue_mutex);
+    }
 
-        end = (start + CHUNK_SIZE > data->A->rows) ? data->A->rows : start + CHUNK_SIZE;
-        for(int i = start; i < end; i++) {
-            compute_row(i, data->A, data->B, data->C);
+    int out = C->row_ptr[r] - 1;
+    for (int p = 0; p < n; p++) {
+        if (p > 0 && esc[p].col == esc[p-1].col) {
+            C->values[out] += esc[p].val;
+        } else {
+            out++;
+            C->col_ind[out] = esc[p].col;
+            C->values[out] = esc[p].val;
         }
     }
-    pthread_exit(NULL);
 }
 
-// --- APPROACH 4: Static Scheduling (Cyclic) ---
-// Distributes rows in a round-robin format (0, P, 2P...)
-// Good for load balancing if sparsity is uneven, without mutex overhead.
-void* method_static_cyclic(void* arg) {
-    ThreadData* data = (ThreadData*)arg;
-    for (int i = data->thread_id; i < data->A->rows; i += data->num_threads) {
-        compute_row(i, data->A, data->B, data->C);
+// Phase 2 (numeric): accumulate row r of C and write it, column-sorted, into its CSR slot
+void compute_row(int r, RowTask *task) {
+    ThreadData *data = (ThreadData*)task->ctx;
+    int flops = row_flops(r, data->A, data->B);
+
+    if (flops <= ESC_MAX_FLOPS) {
+        accumulate_esc(r, data);
+        data->ws->rows_by_acc[ACC_ESC]++;
+    } else if (flops < data->B->cols / HASH_RATIO) {
+        accumulate_hash(r, flops, data);
+        data->ws->rows_by_acc[ACC_HASH]++;
+    } else {
+        accumulate_spa(r, data);
+        data->ws->rows_by_acc[ACC_SPA]++;
     }
-    pthread_exit(NULL);
 }
 
-// --- APPROACH 5: Dynamic Scheduling (Guided) ---
-// Chunk size decreases exponentially. Formula: remaining_rows / (2 * num_threads)
-// Balances low overhead (start) with good load balancing (end).
-void* method_dynamic_guided(void* arg) {
-    ThreadData* data = (ThreadData*)arg;
-    int start, end, chunk;
-    int total_rows = data->A->rows;
-
-    while(1) {
-        pthread_mutex_lock(&queue_mutex);
-        int remaining = total_rows - global_row_counter;
-        
-        if(remaining <= 0) {
-            pthread_mutex_unlock(&queue_mutex);
-            break;
+// prefix[r] = work of rows [0, r), where row r costs the nnz of every B row it references
+void build_work_prefix(CSRMatrix *A, CSRMatrix *B, long long *prefix) {
+    prefix[0] = 0;
+    for (int r = 0; r < A->rows; r++) prefix[r + 1] = prefix[r] + row_flops(r, A, B);
+}
+
+// --- Two-Phase SpGEMM: C = A * B as CSR ---
+// 1. Symbolic: exact nnz of every row of C   (scheduled by `method`)
+// 2. Parallel prefix sum -> C.row_ptr, allocate C.col_ind / C.values
+// 3. Numeric: fill every row in its slot     (scheduled by `method`)
+void spgemm(int method, int n_threads, RowTask *tasks, CSRMatrix *C, int *row_nnz, Workspace *ws) {
+    CSRMatrix *A = ((ThreadData*)tasks[0].ctx)->A, *B = ((ThreadData*)tasks[0].ctx)->B;
+    C->rows = A->rows;
+    C->cols = B->cols;
+
+    // Partitioning is part of the method's cost, so it is inside the timing
+    if (method_partitions[method] != PART_NONE) {
+        build_work_prefix(A, B, row_work_prefix);
+        partition_rows(method_partitions[method], row_work_prefix, A->rows, n_threads, tasks);
+    }
+
+    reset_workspace(ws, n_threads, B->cols);
+    run_method(method, n_threads, tasks, symbolic_row);
+
+    parallel_prefix_sum(row_nnz, C->row_ptr, C->rows, n_threads);
+    C->nnz = C->row_ptr[C->rows];
+    C->col_ind = (int*)malloc((size_t)C->nnz * sizeof(int));
+    C->values = (double*)malloc((size_t)C->nnz * sizeof(double));
+
+    reset_workspace(ws, n_threads, B->cols);
+    for (int t = 0; t < n_threads; t++)
+        for (int a = 0; a < NUM_ACC; a++) ws[t].rows_by_acc[a] = 0;
+    run_method(method, n_threads, tasks, compute_row);
+}
+
+// --- Construction Benchmark (./prog --build ROWS NNZ_PER_ROW) ---
+
+// Expands M into COO with entry p stored at (p * stride) % nnz, so the builder
+// sees rows in scrambled order
+void* csr_to_scrambled_coo_worker(void* arg) {
+    BuildData* d = (BuildData*)arg;
+    CSRMatrix *M = d->M;
+    long long begin, end;
+    block_range(M->rows, d->thread_id, d->num_threads, &begin, &end);
+    for (long long r = begin; r < end; r++) {
+        for (int p = M->row_ptr[r]; p < M->row_ptr[r+1]; p++) {
+            long long q = (long long)p * d->stride % d->nnz;
+            d->coo_row[q] = (int)r;
+            d->coo_col[q] = M->col_ind[p];
+            d->coo_val[q] = M->values[p];
         }
+    }
+    return NULL;
+}
 
-        chunk = remaining / (2 * data->num_threads);
-        
-        if (chunk < CHUNK_SIZE) chunk = CHUNK_SIZE;
-        if (chunk > remaining) chunk = remaining;
+long long gcd_ll(long long a, long long b) {
+    while (b) { long long t = a % b; a = b; b = t; }
+    return a;
+}
 
-        start = global_row_counter;
-        global_row_counter += chunk;
-        pthread_mutex_unlock(&queue_mutex);
+int build_benchmark(int rows, double nnz_per_row) {
+    int n_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n_threads < 1) n_threads = 1;
+    double density = nnz_per_row / rows;
+    uint64_t seed = 7;
+
+    printf("=== Parallel CSR Construction (%d x %d, ~%.0f nnz/row, %d threads) ===\n",
+           rows, rows, nnz_per_row, n_threads);
+
+    // 1. Direct generator
+    double start = get_time();
+    CSRMatrix M = generateSparseCSR(rows, rows, density, seed, n_threads);
+    double gen_time = get_time() - start;
+    printf("Direct generator : %d nnz in %.3f sec (%.1f MB CSR, no dense intermediate)\n",
+           M.nnz, gen_time, ((rows + 1) * 4.0 + M.nnz * 12.0) / 1e6);
+
+    // 2. Scrambled COO of the same matrix, then the parallel COO -> CSR builder
+    long long nnz = M.nnz;
+    BuildData proto = {.rows = rows, .cols = rows, .M = &M, .nnz = nnz};
+    proto.coo_row = (int*)malloc(nnz * sizeof(int));
+    proto.coo_col = (int*)malloc(nnz * sizeof(int));
+    proto.coo_val = (double*)malloc(nnz * sizeof(double));
+    proto.stride = nnz * 0.618 + 1;
+    while (nnz > 1 && gcd_ll(proto.stride, nnz) != 1) proto.stride++;
+    run_build(n_threads, csr_to_scrambled_coo_worker, &proto);
+    free_csr(&M);
+
+    start = get_time();
+    CSRMatrix R = coo_to_csr(rows, rows, nnz, proto.coo_row, proto.coo_col, proto.coo_val, n_threads);
+    double build_time = get_time() - start;
+    printf("COO -> CSR build : %d nnz in %.3f sec\n", R.nnz, build_time);
+    free(proto.coo_row); free(proto.coo_col); free(proto.coo_val);
+
+    // 3. The generator is deterministic, so regenerate and compare
+    M = generateSparseCSR(rows, rows, density, seed, n_threads);
+    int ok = M.nnz == R.nnz
+          && memcmp(M.row_ptr, R.row_ptr, (rows + 1) * sizeof(int)) == 0
+          && memcmp(M.col_ind, R.col_ind, (size_t)nnz * sizeof(int)) == 0
+          && memcmp(M.values, R.values, (size_t)nnz * sizeof(double)) == 0;
+    printf(ok ? ">> Round trip CSR -> COO -> CSR matches\n" : "ERROR: rebuilt CSR differs from the generated one\n");
+
+    free_csr(&M);
+    free_csr(&R);
+    return ok ? 0 : 1;
+}
 
-        end = start + chunk;
-        for(int i = start; i < end; i++) {
-            compute_row(i, data->A, data->B, data->C);
+// --- Reordering Benchmark (./prog --reorder FILE) ---
+
+// Best of REORDER_RUNS C = A * A under one scheduler
+double time_spgemm(CSRMatrix *A, int method, int n_threads, Workspace *ws, int *row_nnz, CSRMatrix *C_out) {
+    double best = 1e9;
+    for (int run = 0; run < REORDER_RUNS; run++) {
+        CSRMatrix C;
+        C.row_ptr = (int*)malloc((A->rows + 1) * sizeof(int));
+        ThreadData t_data[n_threads];
+        RowTask tasks[n_threads];
+        for (int i = 0; i < n_threads; i++) {
+            tasks[i] = (RowTask){.thread_id = i, .num_threads = n_threads, .rows = A->rows, .ctx = &t_data[i]};
+            t_data[i] = (ThreadData){.A = A, .B = A, .C = &C, .row_nnz = row_nnz, .ws = &ws[i]};
         }
+        double start = get_time();
+        spgemm(method, n_threads, tasks, &C, row_nnz, ws);
+        double elapsed = get_time() - start;
+        if (elapsed < best) best = elapsed;
+        if (C_out && run == 0) *C_out = C;
+        else free_csr(&C);
     }
-    pthread_exit(NULL);
+    return best;
 }
 
-int main() {
-    printf("=== Sparse Matrix Multiplication Benchmark (Pthreads) ===\n");
-    printf("Matrix Size: %d x %d\n", N, N);
-    
-    double *matA = (double*)calloc(N * N, sizeof(double));
-    double *matB = (double*)calloc(N * N, sizeof(double));
-    double *matC = (double*)calloc(N * N, sizeof(double));
-
-    printf("Generating Matrices (Target Sparsity: %.0f%%)...\n", SPARSITY * 100);
-    generateRandomSparseMatrix(matA, N, N, SPARSITY);
-    generateRandomSparseMatrix(matB, N, N, SPARSITY);
-
-    if (isSparse(matA, N, N)) {
-        printf(">> Matrix detected as Sparse. Converting to CSR for optimization.\n");
+int reorder_benchmark(const char *path) {
+    int n_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n_threads < 1) n_threads = 1;
+    // One static and one dynamic scheduler: reordering also moves work between static blocks
+    int timed_methods[2] = {0, 6};
+
+    CSRMatrix A;
+    CsrMapping mapA = {0};
+    if (load_matrix(path, &A, &mapA, n_threads) != 0) return 1;
+    if (A.rows != A.cols) {
+        fprintf(stderr, "%s: reordering needs a square matrix (%d x %d)\n", path, A.rows, A.cols);
+        csr_release(&A, &mapA);
+        return 1;
+    }
+    printf("=== Reordering for C = A * A (%d x %d, %d nnz, %d threads) ===\n", A.rows, A.cols, A.nnz, n_threads);
+
+    Workspace ws[n_threads];
+    for (int t = 0; t < n_threads; t++) ws[t] = workspace_create(A.cols);
+    int *row_nnz = (int*)malloc(A.rows * sizeof(int));
+    row_work_prefix = (long long*)malloc((A.rows + 1) * sizeof(long long));
+
+    CSRMatrix C_ref = {0};
+    double base[2] = {0};
+    int ok = 1;
+
+    printf("| %-22s | %-9s | %-9s | %-10s | %-9s | %-19s | %-19s |\n", "Ordering", "Reorder", "Permute",
+           "Bandwidth", "Mean |i-j|", method_names[timed_methods[0]], method_names[timed_methods[1]]);
+    printf("|------------------------|-----------|-----------|------------|------------|---------------------|---------------------|\n");
+    for (int k = 0; k < NUM_ORDERS; k++) {
+        double start = get_time();
+        Permutation p = reorder(k, &A, LEAF_ROWS);
+        double order_time = get_time() - start;
+        start = get_time();
+        CSRMatrix P = permute_symmetric(&A, &p, n_threads);
+        double permute_time = get_time() - start;
+
+        int bw;
+        double mean;
+        csr_bandwidth(&P, &bw, &mean);
+        printf("| %-22s | %8.4fs | %8.4fs | %10d | %10.1f |", order_names[k], order_time, permute_time, bw, mean);
+
+        for (int m = 0; m < 2; m++) {
+            CSRMatrix C;
+            double t = time_spgemm(&P, timed_methods[m], n_threads, ws, row_nnz, &C);
+            if (k == ORDER_NATURAL) base[m] = t;
+            printf(" %10.4fs (%4.2fx) |", t, base[m] / t);
+
+            // Map P^2 = P A^2 P^T back to the original numbering and compare
+            if (k == ORDER_NATURAL && m == 0) {
+                C_ref = C;
+                continue;
+            }
+            Permutation inv = permutation_inverse(&p);
+            CSRMatrix back = permute_symmetric(&C, &inv, n_threads);
+            if (!csr_matches(&back, &C_ref)) {
+                printf("\nERROR in %s / %s: C mapped back differs from the natural-order result\n",
+                       order_names[k], method_names[timed_methods[m]]);
+                ok = 0;
+            }
+            free_csr(&back);
+            permutation_free(&inv);
+            free_csr(&C);
+        }
+        printf("\n");
+        free_csr(&P);
+        permutation_free(&p);
     }
 
-    CSRMatrix csrA = convertToCSR(matA, N, N);
-    CSRMatrix csrB = convertToCSR(matB, N, N);
+    free_csr(&C_ref);
+    for (int t = 0; t < n_threads; t++) workspace_free(&ws[t]);
+    free(row_nnz);
+    free(row_work_prefix);
+    csr_release(&A, &mapA);
+    return ok ? 0 : 1;
+}
+
+// --- Hybrid Dense/Sparse Sweep (./prog --hybrid [N]) ---
+
+// C = A * B through hybrid.h in `mode`, planning included in the time
+double time_hybrid(CSRMatrix *A, CSRMatrix *B, HybridMode mode, int method, int n_threads, HybridPlan *plan, CSRMatrix *C) {
+    HybridWorkspace ws[n_threads];
+    for (int t = 0; t < n_threads; t++) ws[t] = hybrid_workspace_create(A->cols, B->cols);
+    HybridContext ctx = {.A = A, .B = B, .mode = mode, .ws = ws};
 
-    free(matA); 
-    free(matB);
+    double start = get_time();
+    hybrid_plan(&ctx, plan, n_threads);
+    RowTask tasks[n_threads];
+    for (int i = 0; i < n_threads; i++) {
+        tasks[i] = (RowTask){.thread_id = i, .num_threads = n_threads, .rows = plan->n_panels, .ctx = &ctx};
+    }
+    *C = hybrid_spgemm(&ctx, method, n_threads, tasks);
+    double elapsed = get_time() - start;
+
+    for (int t = 0; t < n_threads; t++) hybrid_workspace_free(&ws[t]);
+    return elapsed;
+}
+
+int hybrid_benchmark(int n) {
+    int n_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n_threads < 1) n_threads = 1;
+    int method = 6;     // Lock-free (Chunked) for all three engines
+    double sparsities[] = {0.5, 0.6, 0.7, 0.8, 0.9, 0.95, 0.96, 0.98, 0.99, 0.995, 0.999};
+    int num_sparsities = sizeof(sparsities) / sizeof(sparsities[0]);
+
+    printf("=== Hybrid Dense / Sparse SpGEMM Sweep (%d x %d, %s, %d threads) ===\n",
+           n, n, method_names[method], n_threads);
+    printf("| %-8s | %-9s | %-9s | %-13s | %-13s | %-9s | %-9s | %-9s | %-11s |\n", "Sparsity", "Est. C", "C density",
+           "Dense panels", "Dense tiles", "CSR", "Dense", "Hybrid", "Fastest");
+    printf("|----------|-----------|-----------|---------------|---------------|-----------|-----------|-----------|-------------|\n");
+
+    Workspace ws[n_threads];
+    for (int t = 0; t < n_threads; t++) ws[t] = workspace_create(n);
+    int *row_nnz = (int*)malloc(n * sizeof(int));
+    row_work_prefix = (long long*)malloc((n + 1) * sizeof(long long));
+    int ok = 1;
+
+    for (int s = 0; s < num_sparsities; s++) {
+        CSRMatrix A = generateSparseCSR(n, n, 1.0 - sparsities[s], 42, n_threads);
+        CSRMatrix B = generateSparseCSR(n, n, 1.0 - sparsities[s], 43, n_threads);
+
+        // Pure CSR: the two-phase SpGEMM of this file
+        CSRMatrix C_csr;
+        C_csr.row_ptr = (int*)malloc((n + 1) * sizeof(int));
+        ThreadData t_data[n_threads];
+        RowTask tasks[n_threads];
+        for (int i = 0; i < n_threads; i++) {
+            tasks[i] = (RowTask){.thread_id = i, .num_threads = n_threads, .rows = n, .ctx = &t_data[i]};
+            t_data[i] = (ThreadData){.A = &A, .B = &B, .C = &C_csr, .row_nnz = row_nnz, .ws = &ws[i]};
+        }
+        double start = get_time();
+        spgemm(method, n_threads, tasks, &C_csr, row_nnz, ws);
+        double t_csr = get_time() - start;
+
+        HybridPlan plan_dense, plan_auto;
+        CSRMatrix C_dense, C_auto;
+        double t_dense = time_hybrid(&A, &B, HYBRID_ALL_DENSE, method, n_threads, &plan_dense, &C_dense);
+        double t_auto = time_hybrid(&A, &B, HYBRID_AUTO, method, n_threads, &plan_auto, &C_auto);
+
+        if (!csr_matches(&C_dense, &C_csr) || !csr_matches(&C_auto, &C_csr)) {
+            printf("ERROR at sparsity %.3f: hybrid result differs from CSR\n", sparsities[s]);
+            ok = 0;
+        }
+
+        const char *fastest = t_csr <= t_dense && t_csr <= t_auto ? "CSR" : (t_dense <= t_auto ? "Dense" : "Hybrid");
+        char panels[32], tiles[32];
+        snprintf(panels, sizeof(panels), "%lld / %d", plan_auto.dense_panels, plan_auto.n_panels);
+        snprintf(tiles, sizeof(tiles), "%.1f%%", 100.0 * plan_auto.dense_tiles / ((double)plan_auto.n_panels * plan_auto.n_kblocks));
+        printf("| %8.3f | %8.2f%% | %8.2f%% | %-13s | %-13s | %8.4fs | %8.4fs | %8.4fs | %-11s |\n",
+               sparsities[s], 100.0 * plan_auto.est_density, 100.0 * C_csr.nnz / ((double)n * n),
+               panels, tiles, t_csr, t_dense, t_auto, fastest);
+
+        hybrid_plan_free(&plan_dense);
+        hybrid_plan_free(&plan_auto);
+        free_csr(&C_dense); free_csr(&C_auto); free_csr(&C_csr);
+        free_csr(&A); free_csr(&B);
+    }
+
+    for (int t = 0; t < n_threads; t++) workspace_free(&ws[t]);
+    free(row_nnz);
+    free(row_work_prefix);
+    return ok ? 0 : 1;
+}
+
+// --- Transposed Products (./prog --transpose [ROWS] [COLS] [NNZ_PER_ROW]) ---
+
+// C = A * B (upper = 0) or its upper triangle (upper = 1, B = A^T), with the two-phase SpGEMM
+CSRMatrix spgemm_pair(CSRMatrix *A, CSRMatrix *B, int upper, int method, int n_threads, Workspace *ws, int *row_nnz) {
+    CSRMatrix C;
+    C.row_ptr = (int*)malloc((A->rows + 1) * sizeof(int));
+    ThreadData t_data[n_threads];
+    RowTask tasks[n_threads];
+    for (int i = 0; i < n_threads; i++) {
+        tasks[i] = (RowTask){.thread_id = i, .num_threads = n_threads, .rows = A->rows, .ctx = &t_data[i]};
+        t_data[i] = (ThreadData){.A = A, .B = B, .C = &C, .row_nnz = row_nnz, .ws = &ws[i], .upper = upper};
+    }
+    spgemm(method, n_threads, tasks, &C, row_nnz, ws);
+    return C;
+}
+
+// C = A^T * B: transpose A in parallel, then the row-wise SpGEMM
+CSRMatrix spgemm_atb(CSRMatrix *A, CSRMatrix *B, int method, int n_threads, Workspace *ws, int *row_nnz) {
+    CSRMatrix T = csr_transpose(A, n_threads);
+    CSRMatrix C = spgemm_pair(&T, B, 0, method, n_threads, ws, row_nnz);
+    free_csr(&T);
+    return C;
+}
+
+// C = A * A^T; with `upper` only the upper triangle is multiplied, then mirrored
+CSRMatrix spgemm_aat(CSRMatrix *A, int upper, int method, int n_threads, Workspace *ws, int *row_nnz) {
+    CSRMatrix T = csr_transpose(A, n_threads);
+    CSRMatrix C = spgemm_pair(A, &T, upper, method, n_threads, ws, row_nnz);
+    free_csr(&T);
+    if (!upper) return C;
+    CSRMatrix full = csr_mirror_upper(&C, n_threads);
+    free_csr(&C);
+    return full;
+}
+
+// max relative error of C * x against A^T * (B * x)
+double check_atb(CSRMatrix *A, CSRMatrix *B, CSRMatrix *C) {
+    double *x = (double*)malloc(B->cols * sizeof(double));
+    double *bx = (double*)calloc(B->rows, sizeof(double));
+    double *ref = (double*)calloc(A->cols, sizeof(double));
+    for (int j = 0; j < B->cols; j++) x[j] = 1.0 + (j % 13) * 0.25;
+    for (int r = 0; r < B->rows; r++)
+        for (int k = B->row_ptr[r]; k < B->row_ptr[r+1]; k++) bx[r] += B->values[k] * x[B->col_ind[k]];
+    for (int r = 0; r < A->rows; r++)
+        for (int k = A->row_ptr[r]; k < A->row_ptr[r+1]; k++) ref[A->col_ind[k]] += A->values[k] * bx[r];
+
+    double err = 0.0;
+    for (int r = 0; r < C->rows; r++) {
+        double y = 0.0;
+        for (int k = C->row_ptr[r]; k < C->row_ptr[r+1]; k++) y += C->values[k] * x[C->col_ind[k]];
+        double e = fabs(y - ref[r]) / (fabs(ref[r]) + 1e-12);
+        if (e > err) err = e;
+    }
+    free(x); free(bx); free(ref);
+    return err;
+}
+
+int transpose_benchmark(int rows, int cols, double nnz_per_row) {
+    int n_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n_threads < 1) n_threads = 1;
+    printf("=== Transpose and Transposed Products (A: %d x %d, ~%.0f nnz/row, %d threads) ===\n",
+           rows, cols, nnz_per_row, n_threads);
+
+    CSRMatrix A = generateSparseCSR(rows, cols, nnz_per_row / cols, 42, n_threads);
+    CSRMatrix B = generateSparseCSR(rows, cols, nnz_per_row / cols, 43, n_threads);
+    int ok = 1;
+
+    // 1. CSR -> CSC at every thread count; transposing twice must give A back
+    int thread_counts[] = {1, 2, 4, 8, 16};
+    printf("\nCSR -> CSC transpose (%d nnz):", A.nnz);
+    for (int t_idx = 0; t_idx < 5; t_idx++) {
+        double start = get_time();
+        CSRMatrix T = csr_transpose(&A, thread_counts[t_idx]);
+        printf(" %d thr %.4fs%s", thread_counts[t_idx], get_time() - start, t_idx < 4 ? " |" : "\n");
+        CSRMatrix TT = csr_transpose(&T, thread_counts[t_idx]);
+        if (memcmp(TT.row_ptr, A.row_ptr, (rows + 1) * sizeof(int)) != 0
+            || memcmp(TT.col_ind, A.col_ind, (size_t)A.nnz * sizeof(int)) != 0
+            || memcmp(TT.values, A.values, (size_t)A.nnz * sizeof(double)) != 0) {
+            printf("ERROR: (A^T)^T differs from A with %d threads\n", thread_counts[t_idx]);
+            ok = 0;
+        }
+        free_csr(&T);
+        free_csr(&TT);
+    }
+
+    // 2. A^T B and A A^T under every scheduler
+    int out_cols = rows > cols ? rows : cols;
+    Workspace ws[n_threads];
+    for (int t = 0; t < n_threads; t++) ws[t] = workspace_create(out_cols);
+    int *row_nnz = (int*)malloc(out_cols * sizeof(int));
+    row_work_prefix = (long long*)malloc((out_cols + 1) * sizeof(long long));
+
+    printf("\n| %-25s | %-10s | %-12s | %-14s | %-7s |\n", "Approach Name", "A^T B", "A A^T (full)", "A A^T (upper)", "Speedup");
+    printf("|---------------------------|------------|--------------|----------------|---------|\n");
+    for (int method = 0; method < NUM_METHODS; method++) {
+        double start = get_time();
+        CSRMatrix C = spgemm_atb(&A, &B, method, n_threads, ws, row_nnz);
+        double t_atb = get_time() - start;
+        double err = check_atb(&A, &B, &C);
+        if (err > 1e-9) {
+            printf("ERROR in %s: A^T B max relative error %.3e\n", method_names[method], err);
+            ok = 0;
+        }
+        free_csr(&C);
+
+        start = get_time();
+        CSRMatrix full = spgemm_aat(&A, 0, method, n_threads, ws, row_nnz);
+        double t_full = get_time() - start;
+        start = get_time();
+        CSRMatrix sym = spgemm_aat(&A, 1, method, n_threads, ws, row_nnz);
+        double t_sym = get_time() - start;
+        if (!csr_matches(&sym, &full)) {
+            printf("ERROR in %s: mirrored upper triangle differs from the full A A^T\n", method_names[method]);
+            ok = 0;
+        }
+
+        printf("| %-25s | %9.4fs | %11.4fs | %13.4fs | %6.2fx |\n", method_names[method], t_atb, t_full, t_sym, t_full / t_sym);
+        if (method == NUM_METHODS - 1) {
+            printf(">> A^T B: %d x %d | A A^T: %d x %d, %d nnz\n", cols, cols, rows, rows, full.nnz);
+        }
+        free_csr(&full);
+        free_csr(&sym);
+    }
+
+    for (int t = 0; t < n_threads; t++) workspace_free(&ws[t]);
+    free(row_nnz);
+    free(row_work_prefix);
+    free_csr(&A);
+    free_csr(&B);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--build") == 0) {
+        return build_benchmark(argc > 2 ? atoi(argv[2]) : 10000000, argc > 3 ? atof(argv[3]) : 10.0);
+    }
+    if (argc > 2 && strcmp(argv[1], "--reorder") == 0) {
+        return reorder_benchmark(argv[2]);
+    }
+    if (argc > 1 && strcmp(argv[1], "--hybrid") == 0) {
+        return hybrid_benchmark(argc > 2 ? atoi(argv[2]) : HYBRID_N);
+    }
+    if (argc > 1 && strcmp(argv[1], "--transpose") == 0) {
+        return transpose_benchmark(argc > 2 ? atoi(argv[2]) : 20000, argc > 3 ? atoi(argv[3]) : 10000,
+                                   argc > 4 ? atof(argv[4]) : 16.0);
+    }
+
+    printf("=== Sparse Matrix Multiplication Benchmark (Pthreads) ===\n");
+    int gen_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (gen_threads < 1) gen_threads = 1;
+
+    CSRMatrix csrA, csrB;
+    CsrMapping mapA = {0}, mapB = {0};
+    int b_is_a = 0;
+    if (argc > 2 && strcmp(argv[1], "--matrix") == 0) {
+        // Real input (.mtx or cached .csr): C = A * A
+        if (load_matrix(argv[2], &csrA, &mapA, gen_threads) != 0) return 1;
+        if (csrA.rows != csrA.cols) {
+            fprintf(stderr, "%s: C = A * A needs a square matrix (%d x %d)\n", argv[2], csrA.rows, csrA.cols);
+            csr_release(&csrA, &mapA);
+            return 1;
+        }
+        csrB = csrA;
+        b_is_a = 1;
+        printf("Matrix Size: %d x %d, computing C = A * A\n", csrA.rows, csrA.cols);
+    } else {
+        printf("Matrix Size: %d x %d\n", N, N);
+        printf("Generating Matrices (Target Sparsity: %.0f%%)...\n", SPARSITY * 100);
+        double gen_start = get_time();
+        csrA = generateSparseCSR(N, N, 1.0 - SPARSITY, 42, gen_threads);
+        csrB = generateSparseCSR(N, N, 1.0 - SPARSITY, 43, gen_threads);
+        printf(">> Generated directly in CSR in %.3f sec\n", get_time() - gen_start);
+    }
+    int rows = csrA.rows, cols = csrB.cols;
+    printf(">> Matrix Density is %.4f%% (Sparsity: %.4f%%)\n",
+           100.0 * csrA.nnz / ((double)rows * csrA.cols), 100.0 - 100.0 * csrA.nnz / ((double)rows * csrA.cols));
 
     int thread_counts[] = {1, 2, 4, 8, 16};
     int num_tests = 5;
-    int num_methods = 5; 
+    int max_threads = 16;
+
+    // Scratch for the largest team, allocated once and reused by every method
+    Workspace ws[max_threads];
+    for (int t = 0; t < max_threads; t++) ws[t] = workspace_create(cols);
+    int *row_nnz = (int*)malloc(rows * sizeof(int));
+    row_work_prefix = (long long*)malloc((rows + 1) * sizeof(long long));
 
     struct Result {
         char name[40];
         int optimal_threads;
         double min_time;
-    } results[5]; 
+    } results[NUM_METHODS]; 
 
-    for (int method = 0; method < num_methods; method++) {
+    // Serial SPA reference, so a wrong first method cannot become the baseline
+    double ref_start = get_time();
+    CSRMatrix C_ref = reference_spgemm(&csrA, &csrB);
+    printf(">> Result C: %d non-zeros (%.2f%% dense), serial reference in %.3f sec\n",
+           C_ref.nnz, 100.0 * C_ref.nnz / ((double)rows * cols), get_time() - ref_start);
+    int first_run = 1;
+    int ok = 1;
+
+    for (int method = 0; method < NUM_METHODS; method++) {
         
-        if (method == 0) sprintf(results[method].name, "Static (Block)");
-        else if (method == 1) sprintf(results[method].name, "Dynamic (Fine)");
-        else if (method == 2) sprintf(results[method].name, "Dynamic (Chunked)");
-        else if (method == 3) sprintf(results[method].name, "Static (Cyclic)");
-        else if (method == 4) sprintf(results[method].name, "Dynamic (Guided)");
+        sprintf(results[method].name, "%s", method_names[method]);
 
         printf("\n--- Testing: %s ---\n", results[method].name);
         
@@ -261,43 +767,57 @@ int main() {
         for (int t_idx = 0; t_idx < num_tests; t_idx++) {
             int n_threads = thread_counts[t_idx];
 
-            reset_result(matC, N * N);
-            global_row_counter = 0;
-            pthread_mutex_init(&queue_mutex, NULL);
-            
-            pthread_t threads[n_threads];
-            ThreadData t_data[n_threads];
-
-            double start = get_time();
+            CSRMatrix csrC;
+            csrC.row_ptr = (int*)malloc((rows + 1) * sizeof(int));
 
+            ThreadData t_data[n_threads];
+            RowTask tasks[n_threads];
             for (int i = 0; i < n_threads; i++) {
-                t_data[i].thread_id = i;
-                t_data[i].num_threads = n_threads;
+                tasks[i].thread_id = i;
+                tasks[i].num_threads = n_threads;
+                tasks[i].rows = rows;
+                tasks[i].ctx = &t_data[i];
                 t_data[i].A = &csrA;
                 t_data[i].B = &csrB;
-                t_data[i].C = matC;
-
-                if (method == 0) pthread_create(&threads[i], NULL, method_static_block, &t_data[i]);
-                else if (method == 1) pthread_create(&threads[i], NULL, method_dynamic_fine, &t_data[i]);
-                else if (method == 2) pthread_create(&threads[i], NULL, method_dynamic_chunk, &t_data[i]);
-                else if (method == 3) pthread_create(&threads[i], NULL, method_static_cyclic, &t_data[i]);
-                else if (method == 4) pthread_create(&threads[i], NULL, method_dynamic_guided, &t_data[i]);
-            }
-
-            for (int i = 0; i < n_threads; i++) {
-                pthread_join(threads[i], NULL);
+                t_data[i].C = &csrC;
+                t_data[i].row_nnz = row_nnz;
+                t_data[i].ws = &ws[i];
+                t_data[i].upper = 0;
             }
 
+            double start = get_time();
+            spgemm(method, n_threads, tasks, &csrC, row_nnz, ws);
             double end = get_time();
             double elapsed = end - start;
-            pthread_mutex_destroy(&queue_mutex);
 
-            printf("Threads: %2d | Time: %.4f sec\n", n_threads, elapsed);
+            // Every method / thread count must match the reference, pattern and values
+            if (!csr_matches(&csrC, &C_ref)) {
+                printf("ERROR in %s (%d threads): C differs from the serial reference (nnz %d vs %d)\n",
+                       method_names[method], n_threads, csrC.nnz, C_ref.nnz);
+                ok = 0;
+            }
+            if (first_run) {
+                first_run = 0;
+                long rows_by_acc[NUM_ACC] = {0};
+                for (int t = 0; t < n_threads; t++)
+                    for (int a = 0; a < NUM_ACC; a++) rows_by_acc[a] += ws[t].rows_by_acc[a];
+                printf(">> Accumulators:");
+                for (int a = 0; a < NUM_ACC; a++) printf(" %s %ld rows%s", acc_names[a], rows_by_acc[a], a < NUM_ACC - 1 ? " |" : "\n");
+            }
+
+            if (method_partitions[method] != PART_NONE) {
+                printf("Threads: %2d | Time: %.4f sec | Work imbalance: %.3f\n",
+                       n_threads, elapsed, partition_imbalance(row_work_prefix, n_threads, tasks));
+            } else {
+                printf("Threads: %2d | Time: %.4f sec\n", n_threads, elapsed);
+            }
 
             if (elapsed < best_time) {
                 best_time = elapsed;
                 best_threads = n_threads;
             }
+
+            free_csr(&csrC);
         }
 
         results[method].optimal_threads = best_threads;
@@ -309,7 +829,7 @@ int main() {
     printf("=============================================================\n");
     printf("| %-25s | %-15s | %-10s |\n", "Approach Name", "Optimal Threads", "Min Time");
     printf("|---------------------------|-----------------|------------|\n");
-    for(int i = 0; i < num_methods; i++) {
+    for(int i = 0; i < NUM_METHODS; i++) {
         printf("| %-25s | %-15d | %-9.4fs |\n", 
                results[i].name, 
                results[i].optimal_threads, 
@@ -318,9 +838,12 @@ int main() {
     printf("=============================================================\n");
 
     // Cleanup
-    free(csrA.row_ptr); free(csrA.col_ind); free(csrA.values);
-    free(csrB.row_ptr); free(csrB.col_ind); free(csrB.values);
-    free(matC);
-
-    return 0;
-}
\ No newline at end of file
+    csr_release(&csrA, &mapA);
+    if (!b_is_a) csr_release(&csrB, &mapB);
+    for (int t = 0; t < max_threads; t++) workspace_free(&ws[t]);
+    free(row_nnz);
+    free(row_work_prefix);
+    free_csr(&C_ref);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,330 @@
+#ifndef LAB4_REORDER_H
+#define LAB4_REORDER_H
+
+/*
+ * Locality-improving symmetric reorderings of a square CSRMatrix.
+ *
+ *   reorder_degree()    - rows by descending degree, so hub rows of B sit together
+ *   reorder_rcm()       - reverse Cuthill-McKee: BFS from a pseudo-peripheral vertex,
+ *                         neighbours by ascending degree, then reversed (small bandwidth)
+ *   reorder_partition() - recursive BFS bisection into parts of at most leaf_rows rows;
+ *                         rows of one part are numbered contiguously (graph-partitioning lite)
+ *
+ * The orderings only look at the pattern of A (its rows as adjacency lists),
+ * so they are meant for structurally symmetric inputs. permute_symmetric()
+ * builds P A P^T in parallel; the Permutation is kept so vectors and result
+ * matrices can be mapped back with permute_vector() / unpermute_vector() and
+ * permute_symmetric() with the inverse.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sparse.h"
+#include "sched.h"
+
+typedef struct {
+    int n;
+    int *perm;      // perm[new] = old
+    int *iperm;     // iperm[old] = new
+} Permutation;
+
+typedef enum { ORDER_NATURAL, ORDER_DEGREE, ORDER_RCM, ORDER_PARTITION, NUM_ORDERS } OrderKind;
+static const char *order_names[NUM_ORDERS] __attribute__((unused)) = {"Natural", "Degree sort", "Reverse Cuthill-McKee", "BFS bisection"};
+
+static inline Permutation permutation_create(int n) {
+    Permutation p;
+    p.n = n;
+    p.perm = (int*)malloc(n * sizeof(int));
+    p.iperm = (int*)malloc(n * sizeof(int));
+    return p;
+}
+
+// Fills iperm from perm
+static inline void permutation_finish(Permutation *p) {
+    for (int i = 0; i < p->n; i++) p->iperm[p->perm[i]] = i;
+}
+
+static inline Permutation permutation_inverse(const Permutation *p) {
+    Permutation q = permutation_create(p->n);
+    memcpy(q.perm, p->iperm, p->n * sizeof(int));
+    memcpy(q.iperm, p->perm, p->n * sizeof(int));
+    return q;
+}
+
+static inline void permutation_free(Permutation *p) {
+    free(p->perm); free(p->iperm);
+}
+
+// out[new] = x[old]
+static inline void permute_vector(const Permutation *p, const double *x, double *out) {
+    for (int i = 0; i < p->n; i++) out[i] = x[p->perm[i]];
+}
+
+// out[old] = x[new]
+static inline void unpermute_vector(const Permutation *p, const double *x, double *out) {
+    for (int i = 0; i < p->n; i++) out[p->perm[i]] = x[i];
+}
+
+static inline int row_degree(const CSRMatrix *A, int r) {
+    return A->row_ptr[r+1] - A->row_ptr[r];
+}
+
+// --- Degree sort ---
+static inline Permutation reorder_degree(const CSRMatrix *A) {
+    int n = A->rows, max_deg = 0;
+    for (int r = 0; r < n; r++) if (row_degree(A, r) > max_deg) max_deg = row_degree(A, r);
+
+    // Stable counting sort, highest degree first
+    int *start = (int*)calloc(max_deg + 2, sizeof(int));
+    for (int r = 0; r < n; r++) start[max_deg - row_degree(A, r) + 1]++;
+    for (int d = 1; d <= max_deg + 1; d++) start[d] += start[d-1];
+    Permutation p = permutation_create(n);
+    for (int r = 0; r < n; r++) p.perm[start[max_deg - row_degree(A, r)]++] = r;
+    free(start);
+    permutation_finish(&p);
+    return p;
+}
+
+// --- BFS helpers ---
+typedef struct {
+    int *queue;         // BFS order
+    int *stamp;         // stamp[v] == cur: v visited in this sweep
+    int cur;
+    int *placed;        // placed[v] == place_id: v already has its final position
+    int place_id;
+    const int *part;    // Optional: only vertices with part[v] == part_id are visited
+    int part_id;
+    long long *nbrs;    // (degree << 32 | vertex) of the vertex being expanded
+} BfsState;
+
+static inline BfsState bfs_create(const CSRMatrix *A, const int *part) {
+    BfsState s;
+    int max_deg = 0;
+    for (int r = 0; r < A->rows; r++) if (row_degree(A, r) > max_deg) max_deg = row_degree(A, r);
+    s.queue = (int*)malloc(A->rows * sizeof(int));
+    s.stamp = (int*)calloc(A->rows, sizeof(int));
+    s.cur = 0;
+    s.placed = (int*)calloc(A->rows, sizeof(int));
+    s.place_id = 1;
+    s.part = part;
+    s.part_id = 0;
+    s.nbrs = (long long*)malloc((max_deg + 1) * sizeof(long long));
+    return s;
+}
+
+static inline void bfs_free(BfsState *s) {
+    free(s->queue); free(s->stamp); free(s->placed); free(s->nbrs);
+}
+
+static inline int bfs_allowed(const BfsState *s, int v) {
+    return s->stamp[v] != s->cur && s->placed[v] != s->place_id && (!s->part || s->part[v] == s->part_id);
+}
+
+static inline int compare_ll(const void *a, const void *b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * BFS from root over the allowed vertices, appending to s->queue[*tail].
+ * With by_degree, the unvisited neighbours of each vertex are queued by
+ * ascending degree (Cuthill-McKee). Returns the depth (number of levels);
+ * *last is a minimum-degree vertex of the deepest level.
+ */
+static inline int bfs_sweep(const CSRMatrix *A, BfsState *s, int root, int *tail, int by_degree, int *last) {
+    int head = *tail, depth = 0;
+    s->stamp[root] = s->cur;
+    s->queue[(*tail)++] = root;
+    while (head < *tail) {
+        int level_end = *tail, best = -1;
+        depth++;
+        for (; head < level_end; head++) {
+            int v = s->queue[head];
+            if (best < 0 || row_degree(A, v) < row_degree(A, best)) best = v;
+            int k = 0;
+            for (int j = A->row_ptr[v]; j < A->row_ptr[v+1]; j++) {
+                int u = A->col_ind[j];
+                if (bfs_allowed(s, u)) {
+                    s->stamp[u] = s->cur;
+                    s->nbrs[k++] = by_degree ? ((long long)row_degree(A, u) << 32) | u : u;
+                }
+            }
+            if (by_degree && k > 1) qsort(s->nbrs, k, sizeof(long long), compare_ll);
+            for (int i = 0; i < k; i++) s->queue[(*tail)++] = (int)(s->nbrs[i] & 0xFFFFFFFF);
+        }
+        *last = best;
+    }
+    return depth;
+}
+
+// George-Liu: walk to a vertex of (nearly) maximal eccentricity. Uses
+// s->queue from *tail on as scratch
+static inline int pseudo_peripheral(const CSRMatrix *A, BfsState *s, int root, int tail) {
+    int depth = -1;
+    for (int it = 0; it < 8; it++) {
+        int end = tail, last;
+        s->cur++;
+        int d = bfs_sweep(A, s, root, &end, 0, &last);
+        if (d <= depth) break;
+        depth = d;
+        root = last;
+    }
+    return root;
+}
+
+// Places the component of root (among unplaced, allowed vertices) at s->queue[*tail...]
+static inline void bfs_place(const CSRMatrix *A, BfsState *s, int root, int *tail, int by_degree) {
+    int begin = *tail, last;
+    root = pseudo_peripheral(A, s, root, *tail);
+    s->cur++;
+    bfs_sweep(A, s, root, tail, by_degree, &last);
+    for (int k = begin; k < *tail; k++) s->placed[s->queue[k]] = s->place_id;
+}
+
+// --- Reverse Cuthill-McKee ---
+static inline Permutation reorder_rcm(const CSRMatrix *A) {
+    int n = A->rows;
+    Permutation p = permutation_create(n);
+    BfsState s = bfs_create(A, NULL);
+    int tail = 0;
+
+    // Components in order of their lowest-degree vertex
+    Permutation by_deg = reorder_degree(A);
+    for (int i = n - 1; i >= 0; i--) {
+        int root = by_deg.perm[i];
+        if (s.placed[root] != s.place_id) bfs_place(A, &s, root, &tail, 1);
+    }
+    for (int k = 0; k < n; k++) p.perm[n - 1 - k] = s.queue[k];   // Reversed
+    permutation_free(&by_deg);
+    bfs_free(&s);
+    permutation_finish(&p);
+    return p;
+}
+
+// --- Recursive BFS bisection ---
+static inline Permutation reorder_partition(const CSRMatrix *A, int leaf_rows) {
+    int n = A->rows;
+    Permutation p = permutation_create(n);
+    int *part = (int*)calloc(n, sizeof(int));
+    int *order = p.perm;
+    for (int i = 0; i < n; i++) order[i] = i;
+    BfsState s = bfs_create(A, part);
+
+    // Stack of segments [lo, hi) of `order`, each the vertices of one part
+    int cap = 64, top = 0, next_id = 1;
+    int (*stack)[3] = malloc(cap * sizeof(*stack));
+    stack[top][0] = 0; stack[top][1] = n; stack[top][2] = 0; top++;
+    while (top > 0) {
+        top--;
+        int lo = stack[top][0], hi = stack[top][1], id = stack[top][2];
+        s.part_id = id;
+        s.place_id++;
+
+        // BFS order of the segment, restarting for disconnected pieces
+        int tail = 0;
+        for (int i = lo; i < hi; i++) {
+            if (s.placed[order[i]] != s.place_id) bfs_place(A, &s, order[i], &tail, 0);
+        }
+        memcpy(order + lo, s.queue, (hi - lo) * sizeof(int));
+
+        if (hi - lo <= leaf_rows) continue;
+        int mid = lo + (hi - lo) / 2;
+        if (top + 2 > cap) {
+            cap *= 2;
+            stack = realloc(stack, cap * sizeof(*stack));
+        }
+        int id_lo = next_id++, id_hi = next_id++;
+        for (int i = lo; i < mid; i++) part[order[i]] = id_lo;
+        for (int i = mid; i < hi; i++) part[order[i]] = id_hi;
+        // Push the upper half first so parts are finished left to right
+        stack[top][0] = mid; stack[top][1] = hi; stack[top][2] = id_hi; top++;
+        stack[top][0] = lo; stack[top][1] = mid; stack[top][2] = id_lo; top++;
+    }
+    free(stack);
+    free(part);
+    bfs_free(&s);
+    permutation_finish(&p);
+    return p;
+}
+
+static inline Permutation reorder(OrderKind kind, const CSRMatrix *A, int leaf_rows) {
+    switch (kind) {
+    case ORDER_DEGREE: return reorder_degree(A);
+    case ORDER_RCM: return reorder_rcm(A);
+    case ORDER_PARTITION: return reorder_partition(A, leaf_rows);
+    default: {
+        Permutation p = permutation_create(A->rows);
+        for (int i = 0; i < A->rows; i++) p.perm[i] = i;
+        permutation_finish(&p);
+        return p;
+    }
+    }
+}
+
+// --- P A P^T ---
+typedef struct {
+    const CSRMatrix *A;
+    CSRMatrix *out;
+    const Permutation *p;
+    int *counts;
+    Product **scratch;      // Per thread, for sort_row
+    int *scratch_cap;
+} PermuteContext;
+
+static inline void permute_count_row(int r, RowTask *task) {
+    PermuteContext *c = (PermuteContext*)task->ctx;
+    c->counts[r] = row_degree(c->A, c->p->perm[r]);
+}
+
+static inline void permute_fill_row(int r, RowTask *task) {
+    PermuteContext *c = (PermuteContext*)task->ctx;
+    const CSRMatrix *A = c->A;
+    int old = c->p->perm[r], dst = c->out->row_ptr[r];
+    for (int k = A->row_ptr[old]; k < A->row_ptr[old+1]; k++, dst++) {
+        c->out->col_ind[dst] = c->p->iperm[A->col_ind[k]];
+        c->out->values[dst] = A->values[k];
+    }
+    sort_row(c->out, r, &c->scratch[task->thread_id], &c->scratch_cap[task->thread_id]);
+}
+
+// Row i of the result is row perm[i] of A, with column j renamed iperm[j]
+static inline CSRMatrix permute_symmetric(const CSRMatrix *A, const Permutation *p, int n_threads) {
+    CSRMatrix out;
+    out.rows = A->rows;
+    out.cols = A->cols;
+    out.nnz = A->nnz;
+    out.row_ptr = (int*)malloc((A->rows + 1) * sizeof(int));
+    out.col_ind = (int*)malloc((size_t)A->nnz * sizeof(int));
+    out.values = (double*)malloc((size_t)A->nnz * sizeof(double));
+    int *counts = (int*)malloc(A->rows * sizeof(int));
+    Product *scratch[n_threads];
+    int scratch_cap[n_threads];
+    for (int t = 0; t < n_threads; t++) { scratch[t] = NULL; scratch_cap[t] = 0; }
+    PermuteContext ctx = {.A = A, .out = &out, .p = p, .counts = counts, .scratch = scratch, .scratch_cap = scratch_cap};
+
+    parallel_rows(A->rows, n_threads, permute_count_row, &ctx);
+    parallel_prefix_sum(counts, out.row_ptr, A->rows, n_threads);
+    parallel_rows(A->rows, n_threads, permute_fill_row, &ctx);
+
+    for (int t = 0; t < n_threads; t++) free(scratch[t]);
+    free(counts);
+    return out;
+}
+
+// Locality metrics: largest and mean |i - j| over the non-zeros
+static inline void csr_bandwidth(const CSRMatrix *A, int *max_dist, double *mean_dist) {
+    long long sum = 0;
+    int mx = 0;
+    for (int r = 0; r < A->rows; r++) {
+        for (int k = A->row_ptr[r]; k < A->row_ptr[r+1]; k++) {
+            int d = abs(A->col_ind[k] - r);
+            if (d > mx) mx = d;
+            sum += d;
+        }
+    }
+    *max_dist = mx;
+    *mean_dist = A->nnz ? (double)sum / A->nnz : 0.0;
+}
+
+#endif
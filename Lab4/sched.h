@@ -0,0 +1,308 @@
+#ifndef LAB4_SCHED_H
+#define LAB4_SCHED_H
+
+/*
+ * Row schedulers shared by the Lab4 benchmarks.
+ *
+ * Every scheduler hands out row indices [0, rows) to a team of RowTasks and
+ * calls task->kernel(r, task) for each; what a "row" is (a CSR row, a SELL
+ * chunk, a CSR5 tile) is up to the kernel. Per-thread kernel state hangs off
+ * task->ctx. The partitioned schedulers run the [row_begin, row_end) range
+ * that partition_rows() assigned before launch.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define CHUNK_SIZE 64    // Base Chunk size for Dynamic/Guided methods
+
+typedef struct RowTask {
+    int thread_id;
+    int num_threads;
+    int rows;        // Row indices to hand out: [0, rows)
+    int row_begin;   // [row_begin, row_end) for the partitioned static schedulers
+    int row_end;
+    void (*kernel)(int r, struct RowTask *task);
+    void *ctx;       // Kernel state, e.g. this thread's ThreadData
+} RowTask;
+
+// --- Global Variables for Synchronization ---
+static int global_row_counter = 0;
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Lock-free work counter, alone on its cache line so claiming rows does not
+// false-share with anything else the threads write
+typedef struct {
+    _Alignas(64) atomic_int next;
+    char pad[64 - sizeof(atomic_int)];
+} PaddedCounter;
+
+static PaddedCounter atomic_row_counter;
+
+// --- APPROACH 1: Static Scheduling (Block) ---
+static inline void* method_static_block(void* arg) {
+    RowTask* task = (RowTask*)arg;
+    int chunk = task->rows / task->num_threads;
+    int start = task->thread_id * chunk;
+    int end = (task->thread_id == task->num_threads - 1) ? task->rows : start + chunk;
+
+    for (int i = start; i < end; i++) {
+        task->kernel(i, task);
+    }
+    pthread_exit(NULL);
+}
+
+// --- APPROACH 2: Dynamic Scheduling (Fine Grained) ---
+static inline void* method_dynamic_fine(void* arg) {
+    RowTask* task = (RowTask*)arg;
+    int r;
+    while(1) {
+        pthread_mutex_lock(&queue_mutex);
+        if(global_row_counter >= task->rows) {
+            pthread_mutex_unlock(&queue_mutex);
+            break;
+        }
+        r = global_row_counter++;
+        pthread_mutex_unlock(&queue_mutex);
+        
+        task->kernel(r, task);
+    }
+    pthread_exit(NULL);
+}
+
+// --- APPROACH 3: Dynamic Scheduling (Chunked) ---
+static inline void* method_dynamic_chunk(void* arg) {
+    RowTask* task = (RowTask*)arg;
+    int start, end;
+    while(1) {
+        pthread_mutex_lock(&queue_mutex);
+        if(global_row_counter >= task->rows) {
+            pthread_mutex_unlock(&queue_mutex);
+            break;
+        }
+        start = global_row_counter;
+        global_row_counter += CHUNK_SIZE;
+        pthread_mutex_unlock(&queue_mutex);
+
+        end = (start + CHUNK_SIZE > task->rows) ? task->rows : start + CHUNK_SIZE;
+        for(int i = start; i < end; i++) {
+            task->kernel(i, task);
+        }
+    }
+    pthread_exit(NULL);
+}
+
+// --- APPROACH 4: Static Scheduling (Cyclic) ---
+// Distributes rows in a round-robin format (0, P, 2P...)
+// Good for load balancing if sparsity is uneven, without mutex overhead.
+static inline void* method_static_cyclic(void* arg) {
+    RowTask* task = (RowTask*)arg;
+    for (int i = task->thread_id; i < task->rows; i += task->num_threads) {
+        task->kernel(i, task);
+    }
+    pthread_exit(NULL);
+}
+
+// --- APPROACH 5: Dynamic Scheduling (Guided) ---
+// Chunk size decreases exponentially. Formula: remaining_rows / (2 * num_threads)
+// Balances low overhead (start) with good load balancing (end).
+static inline void* method_dynamic_guided(void* arg) {
+    RowTask* task = (RowTask*)arg;
+    int start, end, chunk;
+    int total_rows = task->rows;
+
+    while(1) {
+        pthread_mutex_lock(&queue_mutex);
+        int remaining = total_rows - global_row_counter;
+        
+        if(remaining <= 0) {
+            pthread_mutex_unlock(&queue_mutex);
+            break;
+        }
+
+        chunk = remaining / (2 * task->num_threads);
+        
+        if (chunk < CHUNK_SIZE) chunk = CHUNK_SIZE;
+        if (chunk > remaining) chunk = remaining;
+
+        start = global_row_counter;
+        global_row_counter += chunk;
+        pthread_mutex_unlock(&queue_mutex);
+
+        end = start + chunk;
+        for(int i = start; i < end; i++) {
+            task->kernel(i, task);
+        }
+    }
+    pthread_exit(NULL);
+}
+
+// --- APPROACH 6: Lock-free Dynamic Scheduling (Fine Grained) ---
+// One atomic fetch-add per row instead of a mutex round trip.
+static inline void* method_lockfree_fine(void* arg) {
+    RowTask* task = (RowTask*)arg;
+    int r;
+    while ((r = atomic_fetch_add_explicit(&atomic_row_counter.next, 1, memory_order_relaxed)) < task->rows) {
+        task->kernel(r, task);
+    }
+    pthread_exit(NULL);
+}
+
+// --- APPROACH 7: Lock-free Dynamic Scheduling (Chunked) ---
+static inline void* method_lockfree_chunk(void* arg) {
+    RowTask* task = (RowTask*)arg;
+    int start, end;
+    while ((start = atomic_fetch_add_explicit(&atomic_row_counter.next, CHUNK_SIZE, memory_order_relaxed)) < task->rows) {
+        end = (start + CHUNK_SIZE > task->rows) ? task->rows : start + CHUNK_SIZE;
+        for (int i = start; i < end; i++) {
+            task->kernel(i, task);
+        }
+    }
+    pthread_exit(NULL);
+}
+
+// --- APPROACH 8: Lock-free Dynamic Scheduling (Guided) ---
+// The chunk depends on the current counter value, so it is claimed with a
+// compare-and-swap loop: a failed CAS reloads the counter and recomputes.
+static inline void* method_lockfree_guided(void* arg) {
+    RowTask* task = (RowTask*)arg;
+    int total_rows = task->rows;
+    int start = atomic_load_explicit(&atomic_row_counter.next, memory_order_relaxed);
+
+    while (start < total_rows) {
+        int remaining = total_rows - start;
+        int chunk = remaining / (2 * task->num_threads);
+        if (chunk < CHUNK_SIZE) chunk = CHUNK_SIZE;
+        if (chunk > remaining) chunk = remaining;
+
+        // On failure `start` is refreshed with the value another thread left
+        if (!atomic_compare_exchange_weak_explicit(&atomic_row_counter.next, &start, start + chunk,
+                                                   memory_order_relaxed, memory_order_relaxed)) {
+            continue;
+        }
+        for (int i = start; i < start + chunk; i++) {
+            task->kernel(i, task);
+        }
+        start = atomic_load_explicit(&atomic_row_counter.next, memory_order_relaxed);
+    }
+    pthread_exit(NULL);
+}
+
+// --- APPROACH 9/10: Static Scheduling (Work-partitioned) ---
+// Each thread runs the contiguous range its partitioner assigned up front:
+// no shared counter, no locks, no atomics while the kernel runs.
+static inline void* method_static_partitioned(void* arg) {
+    RowTask* task = (RowTask*)arg;
+    for (int i = task->row_begin; i < task->row_end; i++) {
+        task->kernel(i, task);
+    }
+    pthread_exit(NULL);
+}
+
+// --- Work Partitioners ---
+enum { PART_NONE = 0, PART_FLOPS, PART_MERGE_PATH };
+
+// First row r with prefix[r] >= target
+static inline int lower_bound_work(const long long *prefix, int rows, long long target) {
+    int lo = 0, hi = rows;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (prefix[mid] < target) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/*
+ * Merge-path search: walk the merge of the row ends (prefix[1..rows]) with the
+ * work items 0..total-1 and find where diagonal `diag` crosses it. Returns the
+ * row coordinate; *work_coord gets the work item coordinate. Every diagonal
+ * covers the same number of rows + work items, so short rows are not free.
+ */
+static inline int merge_path_search(long long diag, const long long *prefix, int rows, long long *work_coord) {
+    long long lo = diag > prefix[rows] ? diag - prefix[rows] : 0;
+    long long hi = diag < rows ? diag : rows;
+    while (lo < hi) {
+        long long mid = lo + (hi - lo) / 2;
+        if (prefix[mid + 1] <= diag - mid - 1) lo = mid + 1;
+        else hi = mid;
+    }
+    *work_coord = diag - lo;
+    return (int)lo;
+}
+
+// Splits rows [0, rows) into n_threads contiguous ranges of (roughly) equal
+// work, given prefix[r] = work of rows [0, r)
+static inline void partition_rows(int kind, const long long *prefix, int rows, int n_threads, RowTask *tasks) {
+    long long total = prefix[rows];
+
+    for (int t = 0; t <= n_threads; t++) {
+        int row;
+        if (kind == PART_FLOPS) {
+            row = lower_bound_work(prefix, rows, total * t / n_threads);
+        } else {
+            // Rows are indivisible here, so only the row coordinate is used
+            long long work_coord;
+            row = merge_path_search((rows + total) * t / n_threads, prefix, rows, &work_coord);
+        }
+        if (t < n_threads) tasks[t].row_begin = row;
+        if (t > 0) tasks[t - 1].row_end = row;
+    }
+    tasks[n_threads - 1].row_end = rows;
+}
+
+// Max / mean work per thread; 1.0 is a perfect split
+static inline double partition_imbalance(const long long *prefix, int n_threads, RowTask *tasks) {
+    long long max_work = 0, total = 0;
+    for (int t = 0; t < n_threads; t++) {
+        long long w = prefix[tasks[t].row_end] - prefix[tasks[t].row_begin];
+        if (w > max_work) max_work = w;
+        total += w;
+    }
+    return total ? (double)max_work * n_threads / total : 1.0;
+}
+
+// --- Scheduler Table ---
+#define NUM_METHODS 10
+
+static const char *method_names[NUM_METHODS] __attribute__((unused)) = {
+    "Static (Block)", "Dynamic (Fine)", "Dynamic (Chunked)", "Static (Cyclic)", "Dynamic (Guided)",
+    "Lock-free (Fine)", "Lock-free (Chunked)", "Lock-free (Guided)",
+    "Static (Flops-balanced)", "Static (Merge-path)"
+};
+static void* (*method_funcs[NUM_METHODS])(void*) __attribute__((unused)) = {
+    method_static_block, method_dynamic_fine, method_dynamic_chunk, method_static_cyclic, method_dynamic_guided,
+    method_lockfree_fine, method_lockfree_chunk, method_lockfree_guided,
+    method_static_partitioned, method_static_partitioned
+};
+static int method_partitions[NUM_METHODS] __attribute__((unused)) = {
+    PART_NONE, PART_NONE, PART_NONE, PART_NONE, PART_NONE,
+    PART_NONE, PART_NONE, PART_NONE,
+    PART_FLOPS, PART_MERGE_PATH
+};
+
+// Runs one scheduling method over rows [0, tasks[0].rows) with the given row kernel
+static inline void run_method(int method, int n_threads, RowTask *tasks, void (*kernel)(int, RowTask*)) {
+    pthread_t threads[n_threads];
+    global_row_counter = 0;
+    atomic_store(&atomic_row_counter.next, 0);
+
+    for (int i = 0; i < n_threads; i++) {
+        tasks[i].kernel = kernel;
+        pthread_create(&threads[i], NULL, method_funcs[method], &tasks[i]);
+    }
+    for (int i = 0; i < n_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+// Runs `kernel` over [0, rows) in static blocks with one shared ctx; for setup work like conversions
+static inline void parallel_rows(int rows, int n_threads, void (*kernel)(int, RowTask*), void *ctx) {
+    RowTask tasks[n_threads];
+    for (int i = 0; i < n_threads; i++) {
+        tasks[i] = (RowTask){.thread_id = i, .num_threads = n_threads, .rows = rows, .ctx = ctx};
+    }
+    run_method(0, n_threads, tasks, kernel);
+}
+
+#endif
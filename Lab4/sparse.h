@@ -0,0 +1,386 @@
+#ifndef LAB4_SPARSE_H
+#define LAB4_SPARSE_H
+
+/*
+ * CSR matrix type and its parallel construction, shared by the Lab4
+ * benchmarks (prog.c: SpGEMM, spmv.c: SpMV).
+ *
+ *   generateSparseCSR() - random matrix built directly in CSR, no dense intermediate
+ *   coo_to_csr()        - parallel COO -> CSR (count, prefix sum, scatter, row sort)
+ *   parallel_prefix_sum - per-row counts -> row_ptr
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <math.h>
+#include <stdatomic.h>
+
+#include "../common/counter_rng.h"
+
+typedef struct {
+    int *row_ptr;   // CSR Row Pointer
+    int *col_ind;   // CSR Column Indices
+    double *values; // CSR Values
+    int nnz;        // Number of Non-Zero elements
+    int rows;
+    int cols;
+} CSRMatrix;
+
+typedef struct {
+    int col;
+    double val;
+} Product;
+
+static inline double get_time() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static inline int compare_int(const void *a, const void *b) {
+    return (*(const int*)a > *(const int*)b) - (*(const int*)a < *(const int*)b);
+}
+
+static inline void free_csr(CSRMatrix *M) {
+    free(M->row_ptr); free(M->col_ind); free(M->values);
+}
+
+// Same pattern and values (up to rounding) as the reference
+static inline int csr_matches(const CSRMatrix *C, const CSRMatrix *ref) {
+    if (C->nnz != ref->nnz) return 0;
+    for (int r = 0; r <= C->rows; r++) if (C->row_ptr[r] != ref->row_ptr[r]) return 0;
+    for (int k = 0; k < C->nnz; k++) {
+        if (C->col_ind[k] != ref->col_ind[k]) return 0;
+        if (fabs(C->values[k] - ref->values[k]) > 1e-9 * (fabs(ref->values[k]) + 1e-12)) return 0;
+    }
+    return 1;
+}
+
+// Serial SPA SpGEMM C = A * B, the independent reference for the parallel kernels
+static inline CSRMatrix reference_spgemm(const CSRMatrix *A, const CSRMatrix *B) {
+    CSRMatrix C;
+    C.rows = A->rows;
+    C.cols = B->cols;
+    C.row_ptr = (int*)malloc((C.rows + 1) * sizeof(int));
+    int *marker = (int*)malloc(B->cols * sizeof(int));
+    int *cols = (int*)malloc(B->cols * sizeof(int));
+    double *acc = (double*)malloc(B->cols * sizeof(double));
+    for (int i = 0; i < B->cols; i++) marker[i] = -1;
+    size_t cap = (size_t)A->nnz + 1, nnz = 0;
+    C.col_ind = (int*)malloc(cap * sizeof(int));
+    C.values = (double*)malloc(cap * sizeof(double));
+
+    C.row_ptr[0] = 0;
+    for (int r = 0; r < A->rows; r++) {
+        int count = 0;
+        for (int k = A->row_ptr[r]; k < A->row_ptr[r+1]; k++) {
+            for (int m = B->row_ptr[A->col_ind[k]]; m < B->row_ptr[A->col_ind[k]+1]; m++) {
+                int col = B->col_ind[m];
+                if (marker[col] != r) {
+                    marker[col] = r;
+                    cols[count++] = col;
+                    acc[col] = 0.0;
+                }
+                acc[col] += A->values[k] * B->values[m];
+            }
+        }
+        qsort(cols, count, sizeof(int), compare_int);
+        if (nnz + count > cap) {
+            while (nnz + count > cap) cap *= 2;
+            C.col_ind = (int*)realloc(C.col_ind, cap * sizeof(int));
+            C.values = (double*)realloc(C.values, cap * sizeof(double));
+        }
+        for (int p = 0; p < count; p++) {
+            C.col_ind[nnz] = cols[p];
+            C.values[nnz++] = acc[cols[p]];
+        }
+        C.row_ptr[r + 1] = (int)nnz;
+    }
+    C.nnz = (int)nnz;
+    free(marker); free(cols); free(acc);
+    return C;
+}
+
+// --- Parallel Prefix Sum (row_nnz -> row_ptr) ---
+typedef struct {
+    int thread_id;
+    int num_threads;
+    int n;
+    const int *counts;
+    int *row_ptr;
+    long long *block_sums;
+    pthread_barrier_t *barrier;
+} ScanData;
+
+static inline void* scan_worker(void* arg) {
+    ScanData* d = (ScanData*)arg;
+    int start = (int)((long long)d->n * d->thread_id / d->num_threads);
+    int end = (int)((long long)d->n * (d->thread_id + 1) / d->num_threads);
+
+    // 1. Sum of this thread's block
+    long long sum = 0;
+    for (int i = start; i < end; i++) sum += d->counts[i];
+    d->block_sums[d->thread_id] = sum;
+    pthread_barrier_wait(d->barrier);
+
+    // 2. Offset = sum of the blocks before this one, then a local inclusive scan
+    long long offset = 0;
+    for (int t = 0; t < d->thread_id; t++) offset += d->block_sums[t];
+    for (int i = start; i < end; i++) {
+        offset += d->counts[i];
+        d->row_ptr[i + 1] = (int)offset;
+    }
+    return NULL;
+}
+
+static inline void parallel_prefix_sum(const int *counts, int *row_ptr, int n, int num_threads) {
+    pthread_t threads[num_threads];
+    ScanData s_data[num_threads];
+    long long block_sums[num_threads];
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, num_threads);
+
+    row_ptr[0] = 0;
+    for (int i = 0; i < num_threads; i++) {
+        s_data[i] = (ScanData){i, num_threads, n, counts, row_ptr, block_sums, &barrier};
+        pthread_create(&threads[i], NULL, scan_worker, &s_data[i]);
+    }
+    for (int i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+    pthread_barrier_destroy(&barrier);
+}
+
+// --- Parallel Sparse Construction (no dense intermediate) ---
+
+// Counter-based RNG (common/counter_rng.h): the draw for (key, counter) is a
+// pure function, so any thread can produce any row's numbers and the matrix
+// is identical for every thread count
+
+enum { STREAM_ROW_NNZ = 1, STREAM_COLS, STREAM_VALUES };
+
+// Number of non-zeros in one row: Binomial(n, p)
+static inline int sample_binomial(int n, double p, uint64_t key, uint64_t counter) {
+    if (p <= 0.0) return 0;
+    if (p >= 1.0) return n;
+    double mean = n * p;
+    double u = rng_uniform(key, 2 * counter);
+
+    if (mean < 32.0) {
+        // Inversion: walk the CDF up from k = 0
+        double q = 1.0 - p;
+        double prob = pow(q, n), cdf = prob;
+        int k = 0;
+        while (u > cdf && k < n) {
+            prob *= (double)(n - k) / (k + 1) * p / q;
+            k++;
+            cdf += prob;
+        }
+        return k;
+    }
+
+    // Normal approximation (Box-Muller), exact enough for mean >= 32
+    double z = sqrt(-2.0 * log(1.0 - u)) * cos(2.0 * M_PI * rng_uniform(key, 2 * counter + 1));
+    long k = lround(mean + z * sqrt(mean * (1.0 - p)));
+    return k < 0 ? 0 : (k > n ? n : (int)k);
+}
+
+// Fills c[0..k) with k distinct sorted columns out of [0, cols)
+static inline void sample_row_columns(int *c, int k, int cols, uint64_t key, uint64_t row) {
+    uint64_t base = row << 32;
+
+    if (2LL * k > cols) {
+        // Dense rows: selection sampling (Knuth's Algorithm S), one pass, already sorted
+        int need = k;
+        for (int j = 0; j < cols && need > 0; j++) {
+            if (rng_uniform(key, base + j) * (cols - j) < need) {
+                c[k - need] = j;
+                need--;
+            }
+        }
+        return;
+    }
+
+    // Sparse rows: draw, sort, drop duplicates, redraw the shortfall
+    int have = 0;
+    uint64_t draw = 0;
+    while (have < k) {
+        for (int i = have; i < k; i++) c[i] = (int)(rng_hash(key, base + draw++) % (uint64_t)cols);
+        qsort(c, k, sizeof(int), compare_int);
+        have = 1;
+        for (int i = 1; i < k; i++) if (c[i] != c[have - 1]) c[have++] = c[i];
+    }
+}
+
+static inline int compare_product(const void *a, const void *b) {
+    return compare_int(&((const Product*)a)->col, &((const Product*)b)->col);
+}
+
+// Sorts one CSR row by column, moving its values along
+static inline void sort_row(CSRMatrix *M, int r, Product **scratch, int *scratch_cap) {
+    int begin = M->row_ptr[r], len = M->row_ptr[r+1] - begin;
+    int *c = M->col_ind + begin;
+    double *v = M->values + begin;
+
+    if (len <= 32) {
+        for (int i = 1; i < len; i++) {
+            int ci = c[i];
+            double vi = v[i];
+            int j = i;
+            while (j > 0 && c[j-1] > ci) { c[j] = c[j-1]; v[j] = v[j-1]; j--; }
+            c[j] = ci;
+            v[j] = vi;
+        }
+        return;
+    }
+    if (len > *scratch_cap) {
+        *scratch_cap = len;
+        *scratch = (Product*)realloc(*scratch, len * sizeof(Product));
+    }
+    for (int i = 0; i < len; i++) (*scratch)[i] = (Product){c[i], v[i]};
+    qsort(*scratch, len, sizeof(Product), compare_product);
+    for (int i = 0; i < len; i++) { c[i] = (*scratch)[i].col; v[i] = (*scratch)[i].val; }
+}
+
+typedef struct {
+    int thread_id;
+    int num_threads;
+    int rows, cols;
+    double density;
+    uint64_t seed;
+    CSRMatrix *M;
+    int *counts;            // Per-row nnz, later the per-row scatter cursor
+    long long nnz;          // COO input
+    int *coo_row, *coo_col;
+    double *coo_val;
+    long long stride;       // Scrambling stride for csr_to_scrambled_coo
+} BuildData;
+
+static inline void block_range(long long n, int t, int num_threads, long long *begin, long long *end) {
+    *begin = n * t / num_threads;
+    *end = n * (t + 1) / num_threads;
+}
+
+static inline void run_build(int n_threads, void* (*worker)(void*), BuildData *proto) {
+    pthread_t threads[n_threads];
+    BuildData b_data[n_threads];
+    for (int i = 0; i < n_threads; i++) {
+        b_data[i] = *proto;
+        b_data[i].thread_id = i;
+        b_data[i].num_threads = n_threads;
+        pthread_create(&threads[i], NULL, worker, &b_data[i]);
+    }
+    for (int i = 0; i < n_threads; i++) pthread_join(threads[i], NULL);
+}
+
+static inline void* gen_count_worker(void* arg) {
+    BuildData* d = (BuildData*)arg;
+    uint64_t key = rng_hash(d->seed, STREAM_ROW_NNZ);
+    long long begin, end;
+    block_range(d->rows, d->thread_id, d->num_threads, &begin, &end);
+    for (long long r = begin; r < end; r++) d->counts[r] = sample_binomial(d->cols, d->density, key, r);
+    return NULL;
+}
+
+static inline void* gen_fill_worker(void* arg) {
+    BuildData* d = (BuildData*)arg;
+    CSRMatrix *M = d->M;
+    uint64_t col_key = rng_hash(d->seed, STREAM_COLS), val_key = rng_hash(d->seed, STREAM_VALUES);
+    long long begin, end;
+    block_range(d->rows, d->thread_id, d->num_threads, &begin, &end);
+    for (long long r = begin; r < end; r++) {
+        int p = M->row_ptr[r], len = M->row_ptr[r+1] - p;
+        sample_row_columns(M->col_ind + p, len, d->cols, col_key, r);
+    }
+    // Values of all this thread's rows in one vectorised run: value p is draw p
+    int p0 = M->row_ptr[begin], p1 = M->row_ptr[end];
+    rng_fill_double(M->values + p0, p1 - p0, val_key, p0, 0.0, 10.0, 1);
+    return NULL;
+}
+
+// Random rows x cols CSR matrix with the given density, built directly in
+// parallel: per-row nnz first, prefix sum, then each row's columns and values
+static inline CSRMatrix generateSparseCSR(int rows, int cols, double density, uint64_t seed, int n_threads) {
+    CSRMatrix M;
+    M.rows = rows;
+    M.cols = cols;
+    M.row_ptr = (int*)malloc((rows + 1) * sizeof(int));
+    int *counts = (int*)malloc(rows * sizeof(int));
+
+    BuildData proto = {.rows = rows, .cols = cols, .density = density, .seed = seed, .M = &M, .counts = counts};
+    run_build(n_threads, gen_count_worker, &proto);
+    parallel_prefix_sum(counts, M.row_ptr, rows, n_threads);
+    free(counts);
+    proto.counts = NULL;
+
+    M.nnz = M.row_ptr[rows];
+    M.col_ind = (int*)malloc((size_t)M.nnz * sizeof(int));
+    M.values = (double*)malloc((size_t)M.nnz * sizeof(double));
+    run_build(n_threads, gen_fill_worker, &proto);
+    return M;
+}
+
+static inline void* coo_count_worker(void* arg) {
+    BuildData* d = (BuildData*)arg;
+    long long begin, end;
+    block_range(d->nnz, d->thread_id, d->num_threads, &begin, &end);
+    for (long long i = begin; i < end; i++)
+        atomic_fetch_add_explicit((atomic_int*)&d->counts[d->coo_row[i]], 1, memory_order_relaxed);
+    return NULL;
+}
+
+static inline void* coo_scatter_worker(void* arg) {
+    BuildData* d = (BuildData*)arg;
+    CSRMatrix *M = d->M;
+    long long begin, end;
+    block_range(d->nnz, d->thread_id, d->num_threads, &begin, &end);
+    for (long long i = begin; i < end; i++) {
+        int p = atomic_fetch_add_explicit((atomic_int*)&d->counts[d->coo_row[i]], 1, memory_order_relaxed);
+        M->col_ind[p] = d->coo_col[i];
+        M->values[p] = d->coo_val[i];
+    }
+    return NULL;
+}
+
+static inline void* csr_sort_worker(void* arg) {
+    BuildData* d = (BuildData*)arg;
+    Product *scratch = NULL;
+    int scratch_cap = 0;
+    long long begin, end;
+    block_range(d->rows, d->thread_id, d->num_threads, &begin, &end);
+    for (long long r = begin; r < end; r++) sort_row(d->M, r, &scratch, &scratch_cap);
+    free(scratch);
+    return NULL;
+}
+
+/*
+ * Parallel COO -> CSR: count entries per row, prefix-sum into row_ptr,
+ * scatter through per-row atomic cursors, then sort each row by column.
+ * Memory is O(nnz + rows). Entries are assumed unique (no duplicate (i, j)).
+ */
+static inline CSRMatrix coo_to_csr(int rows, int cols, long long nnz, int *coo_row, int *coo_col, double *coo_val, int n_threads) {
+    CSRMatrix M;
+    M.rows = rows;
+    M.cols = cols;
+    M.nnz = (int)nnz;
+    M.row_ptr = (int*)malloc((rows + 1) * sizeof(int));
+    M.col_ind = (int*)malloc(nnz * sizeof(int));
+    M.values = (double*)malloc(nnz * sizeof(double));
+    int *counts = (int*)calloc(rows, sizeof(int));
+
+    BuildData proto = {.rows = rows, .cols = cols, .M = &M, .counts = counts,
+                       .nnz = nnz, .coo_row = coo_row, .coo_col = coo_col, .coo_val = coo_val};
+    run_build(n_threads, coo_count_worker, &proto);
+    parallel_prefix_sum(counts, M.row_ptr, rows, n_threads);
+    memcpy(counts, M.row_ptr, rows * sizeof(int));   // counts become scatter cursors
+    run_build(n_threads, coo_scatter_worker, &proto);
+    run_build(n_threads, csr_sort_worker, &proto);
+
+    free(counts);
+    return M;
+}
+
+#endif
@@ -0,0 +1,539 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <math.h>
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include "sparse.h"
+#include "sched.h"
+#include "mtx.h"
+
+#define ROWS 500000        // Matrix Dimension (ROWS x ROWS)
+#define NNZ_PER_ROW 16     // Average non-zeros per row
+#define ITERATIONS 20      // Timed y = A*x iterations per configuration
+
+#define SELL_C 8           // SELL chunk height: rows per chunk (two AVX2 vectors of doubles)
+#define SELL_SIGMA 256     // SELL sorting window, a multiple of SELL_C
+#define CSR5_OMEGA 4       // CSR5 tile width: lanes = doubles per AVX2 vector
+#define CSR5_SIGMA 16      // CSR5 tile height: non-zeros per lane
+#define CSR5_TILE (CSR5_OMEGA * CSR5_SIGMA)
+
+// --- Data Structures ---
+
+/*
+ * SELL-C-sigma: rows are sorted by length inside windows of SELL_SIGMA rows,
+ * then cut into chunks of SELL_C rows. Each chunk is padded to its longest
+ * row and stored column-major, so step j of a chunk is SELL_C contiguous
+ * values: one vector load per step, one gather for x.
+ */
+typedef struct {
+    int rows;
+    int n_chunks;
+    int *perm;          // perm[i] = original row stored in slot i
+    int *chunk_len;     // Longest row of each chunk
+    int *chunk_ptr;     // Offset of each chunk in col / val
+    int *col;           // Padding uses column 0 with value 0.0
+    double *val;
+    long long stored;   // Entries incl. padding
+} SellMatrix;
+
+/*
+ * CSR5: the non-zeros are cut into tiles of CSR5_OMEGA lanes x CSR5_SIGMA
+ * entries, stored transposed so step s of a tile is one vector of
+ * CSR5_OMEGA values. Each tile carries a bit per entry marking row starts
+ * and, per lane, the row segment it starts in. A tile owns the rows that
+ * start in it; the part of a row that began in an earlier tile goes into
+ * the tile's carry and is added in a short serial calibration pass, so
+ * tiles need no synchronisation. Entries past the last full tile form a
+ * scalar tail tile.
+ */
+typedef struct {
+    int rows;
+    int nnz;
+    int n_tiles;          // Full tiles; tile n_tiles is the scalar tail
+    int n_segs;           // Non-empty rows
+    int *seg_rows;        // k-th non-empty row
+    int *seg_start;       // Its first entry
+    int *col;             // Full tiles transposed, tail in CSR order
+    double *val;
+    uint64_t *tile_flags; // Bit s*OMEGA + l: entry (lane l, step s) starts a row
+    int *lane_seg;        // Segment of the entry before each lane's first one
+    int *tile_row_begin;  // Rows owned by tile t: [tile_row_begin[t], tile_row_begin[t+1])
+    int *carry_row;       // Row continued from before tile t (-1 = none)
+    double *carry;        // Its partial sum from tile t
+} Csr5Matrix;
+
+enum { FMT_CSR = 0, FMT_SELL, FMT_CSR5, NUM_FORMATS };
+const char *format_names[NUM_FORMATS] = {"CSR", "SELL-C-sigma", "CSR5"};
+
+// Shared by every task of a run
+typedef struct {
+    CSRMatrix *A;
+    SellMatrix *S;
+    Csr5Matrix *T;
+    const double *x;
+    double *y;
+} SpmvContext;
+
+// --- Helper Functions ---
+int lower_bound_int(const int *a, int n, int key) {
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (a[mid] < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// --- CSR KERNEL ---
+void csr_row(int r, RowTask *task) {
+    SpmvContext *c = (SpmvContext*)task->ctx;
+    const CSRMatrix *A = c->A;
+    double sum = 0.0;
+    for (int j = A->row_ptr[r]; j < A->row_ptr[r+1]; j++) {
+        sum += A->values[j] * c->x[A->col_ind[j]];
+    }
+    c->y[r] = sum;
+}
+
+// --- SELL-C-sigma ---
+int compare_len_desc(const void *a, const void *b) {
+    const int *pa = (const int*)a, *pb = (const int*)b;   // {length, row} pairs
+    if (pa[0] != pb[0]) return pb[0] - pa[0];
+    return pa[1] - pb[1];
+}
+
+void sell_sort_window(int w, RowTask *task) {
+    SpmvContext *c = (SpmvContext*)task->ctx;
+    const CSRMatrix *A = c->A;
+    int begin = w * SELL_SIGMA;
+    int end = begin + SELL_SIGMA > A->rows ? A->rows : begin + SELL_SIGMA;
+    int pairs[2 * SELL_SIGMA];
+
+    for (int r = begin; r < end; r++) {
+        pairs[2 * (r - begin)] = A->row_ptr[r+1] - A->row_ptr[r];
+        pairs[2 * (r - begin) + 1] = r;
+    }
+    qsort(pairs, end - begin, 2 * sizeof(int), compare_len_desc);
+    for (int i = 0; i < end - begin; i++) c->S->perm[begin + i] = pairs[2 * i + 1];
+}
+
+void sell_fill_chunk(int ch, RowTask *task) {
+    SpmvContext *c = (SpmvContext*)task->ctx;
+    const CSRMatrix *A = c->A;
+    SellMatrix *S = c->S;
+    int base = S->chunk_ptr[ch];
+
+    for (int i = 0; i < SELL_C; i++) {
+        int slot = ch * SELL_C + i;
+        int r = slot < S->rows ? S->perm[slot] : -1;
+        int len = r >= 0 ? A->row_ptr[r+1] - A->row_ptr[r] : 0;
+        for (int j = 0; j < S->chunk_len[ch]; j++) {
+            int p = base + j * SELL_C + i;
+            if (j < len) {
+                S->col[p] = A->col_ind[A->row_ptr[r] + j];
+                S->val[p] = A->values[A->row_ptr[r] + j];
+            } else {
+                S->col[p] = 0;
+                S->val[p] = 0.0;
+            }
+        }
+    }
+}
+
+SellMatrix csr_to_sell(CSRMatrix *A, int n_threads) {
+    SellMatrix S;
+    S.rows = A->rows;
+    S.n_chunks = (A->rows + SELL_C - 1) / SELL_C;
+    S.perm = (int*)malloc(A->rows * sizeof(int));
+    S.chunk_len = (int*)malloc(S.n_chunks * sizeof(int));
+    S.chunk_ptr = (int*)malloc((S.n_chunks + 1) * sizeof(int));
+    SpmvContext ctx = {.A = A, .S = &S};
+
+    // 1. Sort rows by length inside each sigma window
+    parallel_rows((A->rows + SELL_SIGMA - 1) / SELL_SIGMA, n_threads, sell_sort_window, &ctx);
+
+    // 2. Chunk sizes (first row of a chunk is its longest), prefix sum
+    int *chunk_size = (int*)malloc(S.n_chunks * sizeof(int));
+    for (int ch = 0; ch < S.n_chunks; ch++) {
+        int r = S.perm[ch * SELL_C];
+        S.chunk_len[ch] = A->row_ptr[r+1] - A->row_ptr[r];
+        chunk_size[ch] = S.chunk_len[ch] * SELL_C;
+    }
+    parallel_prefix_sum(chunk_size, S.chunk_ptr, S.n_chunks, n_threads);
+    free(chunk_size);
+    S.stored = S.chunk_ptr[S.n_chunks];
+
+    // 3. Column-major fill
+    S.col = (int*)aligned_alloc(64, ((S.stored * sizeof(int) + 63) / 64) * 64);
+    S.val = (double*)aligned_alloc(64, ((S.stored * sizeof(double) + 63) / 64) * 64);
+    parallel_rows(S.n_chunks, n_threads, sell_fill_chunk, &ctx);
+    return S;
+}
+
+void free_sell(SellMatrix *S) {
+    free(S->perm); free(S->chunk_len); free(S->chunk_ptr); free(S->col); free(S->val);
+}
+
+void sell_chunk(int ch, RowTask *task) {
+    SpmvContext *c = (SpmvContext*)task->ctx;
+    const SellMatrix *S = c->S;
+    const double *x = c->x;
+    const int *col = S->col + S->chunk_ptr[ch];
+    const double *val = S->val + S->chunk_ptr[ch];
+    double out[SELL_C];
+
+#if defined(__AVX2__) && defined(__FMA__) && SELL_C == 8
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    for (int j = 0; j < S->chunk_len[ch]; j++, col += SELL_C, val += SELL_C) {
+        __m256i idx = _mm256_loadu_si256((const __m256i*)col);
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(val), _mm256_i32gather_pd(x, _mm256_castsi256_si128(idx), 8), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(val + 4), _mm256_i32gather_pd(x, _mm256_extracti128_si256(idx, 1), 8), acc1);
+    }
+    _mm256_storeu_pd(out, acc0);
+    _mm256_storeu_pd(out + 4, acc1);
+#else
+    for (int i = 0; i < SELL_C; i++) out[i] = 0.0;
+    for (int j = 0; j < S->chunk_len[ch]; j++, col += SELL_C, val += SELL_C) {
+        for (int i = 0; i < SELL_C; i++) out[i] += val[i] * x[col[i]];
+    }
+#endif
+
+    for (int i = 0; i < SELL_C; i++) {
+        int slot = ch * SELL_C + i;
+        if (slot < S->rows) c->y[S->perm[slot]] = out[i];
+    }
+}
+
+// --- CSR5 ---
+void csr5_build_tile(int t, RowTask *task) {
+    SpmvContext *c = (SpmvContext*)task->ctx;
+    const CSRMatrix *A = c->A;
+    Csr5Matrix *T = c->T;
+    int base = t * CSR5_TILE;
+
+    T->tile_row_begin[t] = lower_bound_int(A->row_ptr, A->rows, base);
+    int first_seg = lower_bound_int(T->seg_start, T->n_segs, base) - 1;
+    T->carry_row[t] = first_seg >= 0 ? T->seg_rows[first_seg] : -1;
+
+    if (t == T->n_tiles) {
+        // Tail: kept in CSR order
+        for (int e = base; e < T->nnz; e++) {
+            T->col[e] = A->col_ind[e];
+            T->val[e] = A->values[e];
+        }
+        return;
+    }
+
+    uint64_t flags = 0;
+    for (int l = 0; l < CSR5_OMEGA; l++) {
+        int e0 = base + l * CSR5_SIGMA;
+        int seg = lower_bound_int(T->seg_start, T->n_segs, e0) - 1;
+        T->lane_seg[t * CSR5_OMEGA + l] = seg;
+        for (int s = 0; s < CSR5_SIGMA; s++) {
+            int e = e0 + s;
+            if (seg + 1 < T->n_segs && T->seg_start[seg + 1] == e) {
+                flags |= 1ULL << (s * CSR5_OMEGA + l);
+                seg++;
+            }
+            T->col[base + s * CSR5_OMEGA + l] = A->col_ind[e];
+            T->val[base + s * CSR5_OMEGA + l] = A->values[e];
+        }
+    }
+    T->tile_flags[t] = flags;
+}
+
+Csr5Matrix csr_to_csr5(CSRMatrix *A, int n_threads) {
+    Csr5Matrix T;
+    T.rows = A->rows;
+    T.nnz = A->nnz;
+    T.n_tiles = A->nnz / CSR5_TILE;
+
+    // Non-empty rows = row segments
+    T.seg_rows = (int*)malloc(A->rows * sizeof(int));
+    T.seg_start = (int*)malloc(A->rows * sizeof(int));
+    T.n_segs = 0;
+    for (int r = 0; r < A->rows; r++) {
+        if (A->row_ptr[r+1] > A->row_ptr[r]) {
+            T.seg_rows[T.n_segs] = r;
+            T.seg_start[T.n_segs++] = A->row_ptr[r];
+        }
+    }
+
+    T.col = (int*)aligned_alloc(64, ((T.nnz * sizeof(int) + 63) / 64 + 1) * 64);
+    T.val = (double*)aligned_alloc(64, ((T.nnz * sizeof(double) + 63) / 64 + 1) * 64);
+    T.tile_flags = (uint64_t*)malloc((T.n_tiles + 1) * sizeof(uint64_t));
+    T.lane_seg = (int*)malloc((T.n_tiles + 1) * CSR5_OMEGA * sizeof(int));
+    T.tile_row_begin = (int*)malloc((T.n_tiles + 2) * sizeof(int));
+    T.carry_row = (int*)malloc((T.n_tiles + 1) * sizeof(int));
+    T.carry = (double*)malloc((T.n_tiles + 1) * sizeof(double));
+
+    SpmvContext ctx = {.A = A, .T = &T};
+    parallel_rows(T.n_tiles + 1, n_threads, csr5_build_tile, &ctx);
+    T.tile_row_begin[T.n_tiles + 1] = A->rows;
+    return T;
+}
+
+void free_csr5(Csr5Matrix *T) {
+    free(T->seg_rows); free(T->seg_start); free(T->col); free(T->val); free(T->tile_flags);
+    free(T->lane_seg); free(T->tile_row_begin); free(T->carry_row); free(T->carry);
+}
+
+// Adds v to row segment `seg`; the segment continued from before the tile goes to the carry
+static inline void csr5_emit(const Csr5Matrix *T, double *y, int seg, int first_seg, double *carry, double v) {
+    if (seg == first_seg) *carry += v;
+    else y[T->seg_rows[seg]] += v;
+}
+
+void csr5_tile(int t, RowTask *task) {
+    SpmvContext *c = (SpmvContext*)task->ctx;
+    const Csr5Matrix *T = c->T;
+    const double *x = c->x;
+    double *y = c->y;
+    int base = t * CSR5_TILE;
+    double carry = 0.0;
+
+    // Rows this tile owns start at zero; nobody else writes them in this phase
+    for (int r = T->tile_row_begin[t]; r < T->tile_row_begin[t+1]; r++) y[r] = 0.0;
+
+    if (t == T->n_tiles) {
+        // Scalar tail
+        int first_seg = lower_bound_int(T->seg_start, T->n_segs, base) - 1;
+        int seg = first_seg;
+        double sum = 0.0;
+        for (int e = base; e < T->nnz; e++) {
+            if (seg + 1 < T->n_segs && T->seg_start[seg + 1] == e) {
+                csr5_emit(T, y, seg, first_seg, &carry, sum);
+                sum = 0.0;
+                seg++;
+            }
+            sum += T->val[e] * x[T->col[e]];
+        }
+        csr5_emit(T, y, seg, first_seg, &carry, sum);
+        T->carry[t] = carry;
+        return;
+    }
+
+    const int *lane_seg = T->lane_seg + t * CSR5_OMEGA;
+    int first_seg = lane_seg[0];
+    int seg[CSR5_OMEGA];
+    double sum[CSR5_OMEGA], prod[CSR5_OMEGA];
+    for (int l = 0; l < CSR5_OMEGA; l++) seg[l] = lane_seg[l];
+    uint64_t flags = T->tile_flags[t];
+
+#if defined(__AVX2__) && defined(__FMA__) && CSR5_OMEGA == 4
+    __m256d vsum = _mm256_setzero_pd();
+    for (int s = 0; s < CSR5_SIGMA; s++) {
+        const int p = base + s * CSR5_OMEGA;
+        __m256d vprod = _mm256_mul_pd(_mm256_loadu_pd(T->val + p),
+                                      _mm256_i32gather_pd(x, _mm_loadu_si128((const __m128i*)(T->col + p)), 8));
+        unsigned m = (unsigned)(flags >> (s * CSR5_OMEGA)) & 0xF;
+        if (!m) {
+            vsum = _mm256_add_pd(vsum, vprod);
+            continue;
+        }
+        // A row starts in some lane: flush those lanes' sums (segmented sum)
+        _mm256_storeu_pd(sum, vsum);
+        _mm256_storeu_pd(prod, vprod);
+        for (int l = 0; l < CSR5_OMEGA; l++) {
+            if (m & (1u << l)) {
+                csr5_emit(T, y, seg[l], first_seg, &carry, sum[l]);
+                seg[l]++;
+                sum[l] = prod[l];
+            } else {
+                sum[l] += prod[l];
+            }
+        }
+        vsum = _mm256_loadu_pd(sum);
+    }
+    _mm256_storeu_pd(sum, vsum);
+#else
+    for (int l = 0; l < CSR5_OMEGA; l++) sum[l] = 0.0;
+    for (int s = 0; s < CSR5_SIGMA; s++) {
+        const int p = base + s * CSR5_OMEGA;
+        for (int l = 0; l < CSR5_OMEGA; l++) {
+            prod[l] = T->val[p + l] * x[T->col[p + l]];
+            if (flags & (1ULL << (s * CSR5_OMEGA + l))) {
+                csr5_emit(T, y, seg[l], first_seg, &carry, sum[l]);
+                seg[l]++;
+                sum[l] = prod[l];
+            } else {
+                sum[l] += prod[l];
+            }
+        }
+    }
+#endif
+
+    for (int l = 0; l < CSR5_OMEGA; l++) csr5_emit(T, y, seg[l], first_seg, &carry, sum[l]);
+    T->carry[t] = carry;
+}
+
+// Adds each tile's carry to the row it continued (serial, one add per tile)
+void csr5_calibrate(const Csr5Matrix *T, double *y) {
+    for (int t = 0; t <= T->n_tiles; t++) {
+        if (T->carry_row[t] >= 0) y[T->carry_row[t]] += T->carry[t];
+    }
+}
+
+// --- Benchmark ---
+double max_rel_error(const double *y, const double *ref, int n) {
+    double err = 0.0;
+    for (int i = 0; i < n; i++) {
+        double e = fabs(y[i] - ref[i]) / (fabs(ref[i]) + 1e-12);
+        if (e > err) err = e;
+    }
+    return err;
+}
+
+int main(int argc, char **argv) {
+    int gen_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (gen_threads < 1) gen_threads = 1;
+    int from_file = argc > 2 && strcmp(argv[1], "--matrix") == 0;
+    int rows = !from_file && argc > 1 ? atoi(argv[1]) : ROWS;
+    double nnz_per_row = !from_file && argc > 2 ? atof(argv[2]) : NNZ_PER_ROW;
+    int iterations = argc > 3 ? atoi(argv[3]) : ITERATIONS;
+
+    printf("=== Sparse Matrix-Vector Multiplication Benchmark (Pthreads) ===\n");
+#if defined(__AVX2__) && defined(__FMA__)
+    printf("SELL-C-sigma / CSR5 kernels: AVX2 gather + FMA\n");
+#else
+    printf("SELL-C-sigma / CSR5 kernels: scalar (build with -mavx2 -mfma for the AVX2 kernels)\n");
+#endif
+
+    CSRMatrix A;
+    CsrMapping mapA = {0};
+    if (from_file) {
+        // Real input (.mtx or cached .csr)
+        if (load_matrix(argv[2], &A, &mapA, gen_threads) != 0) return 1;
+        rows = A.rows;
+        printf("Matrix Size: %d x %d, %d nnz, %d iterations per run\n", A.rows, A.cols, A.nnz, iterations);
+    } else {
+        printf("Matrix Size: %d x %d, ~%.0f nnz/row, %d iterations per run\n", rows, rows, nnz_per_row, iterations);
+        A = generateSparseCSR(rows, rows, nnz_per_row / rows, 42, gen_threads);
+        printf(">> A: %d non-zeros\n", A.nnz);
+    }
+
+    double *x = (double*)malloc(A.cols * sizeof(double));
+    double *y = (double*)malloc(rows * sizeof(double));
+    double *y_ref = (double*)malloc(rows * sizeof(double));
+    for (int i = 0; i < A.cols; i++) x[i] = 1.0 + (i % 17) * 0.125;
+    SpmvContext ref = {.A = &A, .x = x, .y = y_ref};
+    parallel_rows(rows, 1, csr_row, &ref);
+
+    int thread_counts[] = {1, 2, 4, 8, 16};
+    int num_tests = 5;
+
+    SellMatrix S;
+    Csr5Matrix T;
+    double conversion[NUM_FORMATS];
+    double best_iter[NUM_FORMATS];
+    int best_method[NUM_FORMATS], best_threads[NUM_FORMATS];
+    int ok = 1;
+
+    for (int f = 0; f < NUM_FORMATS; f++) {
+        // Conversion (and the work prefix for the partitioned schedulers), timed once
+        double start = get_time();
+        int units;
+        long long *prefix;
+        if (f == FMT_CSR) {
+            units = rows;
+            prefix = (long long*)malloc((units + 1) * sizeof(long long));
+            for (int r = 0; r <= rows; r++) prefix[r] = A.row_ptr[r];
+        } else if (f == FMT_SELL) {
+            S = csr_to_sell(&A, gen_threads);
+            units = S.n_chunks;
+            prefix = (long long*)malloc((units + 1) * sizeof(long long));
+            for (int ch = 0; ch <= units; ch++) prefix[ch] = S.chunk_ptr[ch];
+        } else {
+            T = csr_to_csr5(&A, gen_threads);
+            units = T.n_tiles + 1;
+            prefix = (long long*)malloc((units + 1) * sizeof(long long));
+            for (int t = 0; t <= units; t++) prefix[t] = (long long)t * CSR5_TILE < A.nnz ? (long long)t * CSR5_TILE : A.nnz;
+        }
+        conversion[f] = get_time() - start;
+        void (*kernel)(int, RowTask*) = f == FMT_CSR ? csr_row : (f == FMT_SELL ? sell_chunk : csr5_tile);
+
+        printf("\n--- Format: %s | conversion %.4f sec", format_names[f], conversion[f]);
+        if (f == FMT_SELL) printf(" | C=%d sigma=%d, padding %.1f%%", SELL_C, SELL_SIGMA, 100.0 * (S.stored - A.nnz) / A.nnz);
+        if (f == FMT_CSR5) printf(" | %d x %d tiles: %d (+ tail)", CSR5_OMEGA, CSR5_SIGMA, T.n_tiles);
+        printf(" ---\n");
+        printf("| %-25s |", "ms / iteration");
+        for (int t_idx = 0; t_idx < num_tests; t_idx++) printf(" %4d thr |", thread_counts[t_idx]);
+        printf("\n");
+
+        best_iter[f] = 1e9;
+        for (int method = 0; method < NUM_METHODS; method++) {
+            printf("| %-25s |", method_names[method]);
+            for (int t_idx = 0; t_idx < num_tests; t_idx++) {
+                int n_threads = thread_counts[t_idx];
+                SpmvContext ctx = {.A = &A, .S = &S, .T = &T, .x = x, .y = y};
+                RowTask tasks[n_threads];
+                for (int i = 0; i < n_threads; i++) {
+                    tasks[i] = (RowTask){.thread_id = i, .num_threads = n_threads, .rows = units, .ctx = &ctx};
+                }
+                // Partitioning is done once per matrix, like a conversion; not per iteration
+                if (method_partitions[method] != PART_NONE) {
+                    partition_rows(method_partitions[method], prefix, units, n_threads, tasks);
+                }
+
+                memset(y, 0, rows * sizeof(double));
+                run_method(method, n_threads, tasks, kernel);   // Warm-up
+                if (f == FMT_CSR5) csr5_calibrate(&T, y);
+                double err = max_rel_error(y, y_ref, rows);
+                if (err > 1e-9) {
+                    printf("\nERROR in %s / %s (%d threads): max relative error %.3e\n",
+                           format_names[f], method_names[method], n_threads, err);
+                    ok = 0;
+                }
+
+                start = get_time();
+                for (int it = 0; it < iterations; it++) {
+                    run_method(method, n_threads, tasks, kernel);
+                    if (f == FMT_CSR5) csr5_calibrate(&T, y);
+                }
+                double per_iter = (get_time() - start) / iterations;
+                printf(" %8.3f |", per_iter * 1e3);
+
+                if (per_iter < best_iter[f]) {
+                    best_iter[f] = per_iter;
+                    best_method[f] = method;
+                    best_threads[f] = n_threads;
+                }
+            }
+            printf("\n");
+        }
+        free(prefix);
+    }
+
+    printf("\n\n==============================================================================================\n");
+    printf("                                  FINAL PERFORMANCE SUMMARY                                   \n");
+    printf("==============================================================================================\n");
+    printf("| %-12s | %-10s | %-10s | %-8s | %-28s | %-12s |\n",
+           "Format", "Conversion", "Best Iter", "GFLOP/s", "Best Scheduler @ Threads", "Break-even");
+    printf("|--------------|------------|------------|----------|------------------------------|--------------|\n");
+    for (int f = 0; f < NUM_FORMATS; f++) {
+        char sched[64], even[32];
+        snprintf(sched, sizeof(sched), "%s @ %d", method_names[best_method[f]], best_threads[f]);
+        // Iterations after which conversion + faster iterations beat plain CSR
+        if (f == FMT_CSR) snprintf(even, sizeof(even), "-");
+        else if (best_iter[f] < best_iter[FMT_CSR])
+            snprintf(even, sizeof(even), "%.0f iters", ceil(conversion[f] / (best_iter[FMT_CSR] - best_iter[f])));
+        else snprintf(even, sizeof(even), "never");
+        printf("| %-12s | %8.4fs | %8.3fms | %8.2f | %-28s | %-12s |\n",
+               format_names[f], conversion[f], best_iter[f] * 1e3, 2.0 * A.nnz / best_iter[f] / 1e9, sched, even);
+    }
+    printf("==============================================================================================\n");
+
+    // Cleanup
+    csr_release(&A, &mapA);
+    free_sell(&S);
+    free_csr5(&T);
+    free(x); free(y); free(y_ref);
+
+    return ok ? 0 : 1;
+}
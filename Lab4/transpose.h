@@ -0,0 +1,145 @@
+#ifndef LAB4_TRANSPOSE_H
+#define LAB4_TRANSPOSE_H
+
+/*
+ * Parallel CSR transpose (= CSR -> CSC) and the mirror step of symmetric
+ * products.
+ *
+ *   csr_transpose()     - A^T in CSR, which is A in CSC: per-thread column
+ *                         histograms, prefix sums, then a scatter in which
+ *                         every thread owns a private cursor per column
+ *   csr_mirror_upper()  - full symmetric matrix from its upper triangle (U + U^T - diag)
+ *
+ * Threads take contiguous row blocks in order (parallel_rows, static
+ * blocks), and each writes its entries of a column after those of all
+ * lower-numbered threads, so every row of the transpose comes out sorted.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sparse.h"
+#include "sched.h"
+
+typedef struct {
+    const CSRMatrix *A;
+    CSRMatrix *T;
+    int n_threads;
+    int **hist;         // Per thread: entries per column of A in its rows, then its write cursors
+    int *counts;        // Per column of A: nnz (= row lengths of T)
+} TransposeContext;
+
+static inline void transpose_count_row(int r, RowTask *task) {
+    TransposeContext *c = (TransposeContext*)task->ctx;
+    int *hist = c->hist[task->thread_id];
+    for (int k = c->A->row_ptr[r]; k < c->A->row_ptr[r+1]; k++) hist[c->A->col_ind[k]]++;
+}
+
+// Column j: total nnz for the prefix sum
+static inline void transpose_total_col(int j, RowTask *task) {
+    TransposeContext *c = (TransposeContext*)task->ctx;
+    int sum = 0;
+    for (int t = 0; t < c->n_threads; t++) sum += c->hist[t][j];
+    c->counts[j] = sum;
+}
+
+// Column j: turn each thread's count into its first write position in row j of T
+static inline void transpose_offsets_col(int j, RowTask *task) {
+    TransposeContext *c = (TransposeContext*)task->ctx;
+    int pos = c->T->row_ptr[j];
+    for (int t = 0; t < c->n_threads; t++) {
+        int n = c->hist[t][j];
+        c->hist[t][j] = pos;
+        pos += n;
+    }
+}
+
+static inline void transpose_scatter_row(int r, RowTask *task) {
+    TransposeContext *c = (TransposeContext*)task->ctx;
+    int *cursor = c->hist[task->thread_id];
+    for (int k = c->A->row_ptr[r]; k < c->A->row_ptr[r+1]; k++) {
+        int dst = cursor[c->A->col_ind[k]]++;
+        c->T->col_ind[dst] = r;
+        c->T->values[dst] = c->A->values[k];
+    }
+}
+
+static inline CSRMatrix csr_transpose(const CSRMatrix *A, int n_threads) {
+    CSRMatrix T;
+    T.rows = A->cols;
+    T.cols = A->rows;
+    T.nnz = A->nnz;
+    T.row_ptr = (int*)malloc((T.rows + 1) * sizeof(int));
+    T.col_ind = (int*)malloc((size_t)T.nnz * sizeof(int));
+    T.values = (double*)malloc((size_t)T.nnz * sizeof(double));
+
+    int *hist[n_threads];
+    for (int t = 0; t < n_threads; t++) hist[t] = (int*)calloc(A->cols, sizeof(int));
+    int *counts = (int*)malloc(A->cols * sizeof(int));
+    TransposeContext ctx = {.A = A, .T = &T, .n_threads = n_threads, .hist = hist, .counts = counts};
+
+    parallel_rows(A->rows, n_threads, transpose_count_row, &ctx);
+    parallel_rows(A->cols, n_threads, transpose_total_col, &ctx);
+    parallel_prefix_sum(counts, T.row_ptr, T.rows, n_threads);
+    parallel_rows(A->cols, n_threads, transpose_offsets_col, &ctx);
+    parallel_rows(A->rows, n_threads, transpose_scatter_row, &ctx);
+
+    for (int t = 0; t < n_threads; t++) free(hist[t]);
+    free(counts);
+    return T;
+}
+
+// --- Symmetric mirror ---
+typedef struct {
+    const CSRMatrix *U;     // Upper triangle (columns >= row in every row)
+    const CSRMatrix *Ut;    // Its transpose: columns <= row
+    CSRMatrix *C;
+    int *counts;
+} MirrorContext;
+
+// Strictly lower part of row r comes from U^T (all but its last entry, the diagonal)
+static inline int mirror_lower_len(const MirrorContext *c, int r) {
+    int begin = c->Ut->row_ptr[r], end = c->Ut->row_ptr[r+1];
+    return end > begin && c->Ut->col_ind[end - 1] == r ? end - begin - 1 : end - begin;
+}
+
+static inline void mirror_count_row(int r, RowTask *task) {
+    MirrorContext *c = (MirrorContext*)task->ctx;
+    c->counts[r] = mirror_lower_len(c, r) + c->U->row_ptr[r+1] - c->U->row_ptr[r];
+}
+
+static inline void mirror_fill_row(int r, RowTask *task) {
+    MirrorContext *c = (MirrorContext*)task->ctx;
+    int dst = c->C->row_ptr[r];
+    int lower = mirror_lower_len(c, r);
+    memcpy(c->C->col_ind + dst, c->Ut->col_ind + c->Ut->row_ptr[r], lower * sizeof(int));
+    memcpy(c->C->values + dst, c->Ut->values + c->Ut->row_ptr[r], lower * sizeof(double));
+    dst += lower;
+    int n = c->U->row_ptr[r+1] - c->U->row_ptr[r];
+    memcpy(c->C->col_ind + dst, c->U->col_ind + c->U->row_ptr[r], n * sizeof(int));
+    memcpy(c->C->values + dst, c->U->values + c->U->row_ptr[r], n * sizeof(double));
+}
+
+// C = U + U^T - diag(U): row r is (U^T row r without the diagonal) ++ (U row r), already sorted
+static inline CSRMatrix csr_mirror_upper(const CSRMatrix *U, int n_threads) {
+    CSRMatrix Ut = csr_transpose(U, n_threads);
+    CSRMatrix C;
+    C.rows = U->rows;
+    C.cols = U->cols;
+    C.row_ptr = (int*)malloc((C.rows + 1) * sizeof(int));
+    int *counts = (int*)malloc(C.rows * sizeof(int));
+    MirrorContext ctx = {.U = U, .Ut = &Ut, .C = &C, .counts = counts};
+
+    parallel_rows(C.rows, n_threads, mirror_count_row, &ctx);
+    parallel_prefix_sum(counts, C.row_ptr, C.rows, n_threads);
+    C.nnz = C.row_ptr[C.rows];
+    C.col_ind = (int*)malloc((size_t)C.nnz * sizeof(int));
+    C.values = (double*)malloc((size_t)C.nnz * sizeof(double));
+    parallel_rows(C.rows, n_threads, mirror_fill_row, &ctx);
+
+    free(counts);
+    free_csr(&Ut);
+    return C;
+}
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef LAB5_CPU_ACCOUNTING_H
+#define LAB5_CPU_ACCOUNTING_H
+
+/*
+ * Per-process and per-thread CPU accounting.
+ *
+ * /proc/stat counts every process on the machine, so on a shared node its
+ * CPU% says nothing about the benchmark. Everything here is scoped to this
+ * process:
+ *
+ *   process_usage()   - getrusage(RUSAGE_SELF): user + system time, context switches
+ *   thread_usage()    - getrusage(RUSAGE_THREAD) of the calling thread
+ *   thread_cpu_now()  - clock_gettime(CLOCK_THREAD_CPUTIME_ID), cheap enough
+ *                       to bracket single parallel regions (WorkerPool busy / spin)
+ *   task_usages()     - /proc/self/task/<tid>/stat and status: CPU time and
+ *                       context switches of every thread, OpenMP workers included
+ *
+ * account_begin() / account_end() take both views around a measurement.
+ */
+
+#include <dirent.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+struct Usage {
+    double cpu;         // User + system seconds
+    long vcsw;          // Voluntary context switches (blocked: futex, I/O)
+    long ivcsw;         // Involuntary (preempted)
+};
+
+struct TaskUsage {
+    int tid;
+    Usage usage;
+};
+
+inline double timeval_sec(const timeval& tv) {
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+inline Usage rusage_to_usage(const rusage& ru) {
+    Usage u = {timeval_sec(ru.ru_utime) + timeval_sec(ru.ru_stime), ru.ru_nvcsw, ru.ru_nivcsw};
+    return u;
+}
+
+inline Usage process_usage() {
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return rusage_to_usage(ru);
+}
+
+inline Usage thread_usage() {
+    rusage ru;
+    getrusage(RUSAGE_THREAD, &ru);
+    return rusage_to_usage(ru);
+}
+
+inline double thread_cpu_now() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+inline Usage usage_delta(const Usage& before, const Usage& after) {
+    Usage d = {after.cpu - before.cpu, after.vcsw - before.vcsw, after.ivcsw - before.ivcsw};
+    return d;
+}
+
+// utime + stime of one task: fields 14 and 15 of /proc/self/task/<tid>/stat,
+// counted after the ")" that closes the (possibly space-containing) comm field
+inline bool read_task_stat(int tid, Usage& u) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+    std::ifstream file(path);
+    std::string line;
+    if (!std::getline(file, line)) return false;
+    size_t close = line.rfind(')');
+    if (close == std::string::npos) return false;
+    const char* p = line.c_str() + close + 2;   // Field 3 (state)
+    unsigned long long utime = 0, stime = 0;
+    for (int field = 3; field <= 15 && *p; field++) {
+        if (field == 14) utime = strtoull(p, nullptr, 10);
+        if (field == 15) stime = strtoull(p, nullptr, 10);
+        while (*p && *p != ' ') p++;
+        while (*p == ' ') p++;
+    }
+    u.cpu = (double)(utime + stime) / sysconf(_SC_CLK_TCK);
+
+    snprintf(path, sizeof(path), "/proc/self/task/%d/status", tid);
+    std::ifstream status(path);
+    u.vcsw = u.ivcsw = 0;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 24, "voluntary_ctxt_switches:") == 0) u.vcsw = atol(line.c_str() + 24);
+        if (line.compare(0, 27, "nonvoluntary_ctxt_switches:") == 0) u.ivcsw = atol(line.c_str() + 27);
+    }
+    return true;
+}
+
+// Every thread of this process, by tid
+inline std::vector<TaskUsage> task_usages() {
+    std::vector<TaskUsage> tasks;
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) return tasks;
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') continue;
+        TaskUsage t;
+        t.tid = atoi(entry->d_name);
+        if (read_task_stat(t.tid, t.usage)) tasks.push_back(t);
+    }
+    closedir(dir);
+    std::sort(tasks.begin(), tasks.end(), [](const TaskUsage& a, const TaskUsage& b) { return a.tid < b.tid; });
+    return tasks;
+}
+
+struct AccountSnapshot {
+    double wall;
+    Usage process;
+    std::vector<TaskUsage> tasks;
+};
+
+struct Account {
+    double wall;                    // Seconds
+    Usage process;
+    std::vector<TaskUsage> tasks;   // Threads that ran during the measurement (tick resolution)
+
+    // Process CPU as a share of `threads` cores over the wall time
+    double utilisation(int threads) const {
+        return wall > 0 && threads > 0 ? process.cpu / (wall * threads) * 100.0 : 0.0;
+    }
+};
+
+inline double wall_now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+inline AccountSnapshot account_begin() {
+    AccountSnapshot s;
+    s.tasks = task_usages();
+    s.process = process_usage();
+    s.wall = wall_now();
+    return s;
+}
+
+inline Account account_end(const AccountSnapshot& begin) {
+    Account a;
+    a.wall = wall_now() - begin.wall;
+    a.process = usage_delta(begin.process, process_usage());
+    std::map<int, Usage> before;
+    for (const TaskUsage& t : begin.tasks) before[t.tid] = t.usage;
+    for (const TaskUsage& t : task_usages()) {
+        Usage zero = {0, 0, 0};
+        auto it = before.find(t.tid);
+        TaskUsage d = {t.tid, usage_delta(it == before.end() ? zero : it->second, t.usage)};
+        if (d.usage.cpu > 0 || d.usage.vcsw > 0 || d.usage.ivcsw > 0) a.tasks.push_back(d);
+    }
+    return a;
+}
+
+#endif
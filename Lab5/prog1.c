@@ -1,67 +1,170 @@
+#define _GNU_SOURCE     // pthread_setaffinity_np; must come before the first system header
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
 #include <omp.h>
-#include <time.h>
+
+#include "reduce_kernels.h"
+#include "../common/bw_profile.h"
 
 #define SIZE 500000000
+#define TIMED_RUNS 3        // Best of
+#define SEED 2024           // Default input seed (third argument)
+
+// Scalar baselines as in the original lab: branches in the loop, OpenMP reduction clauses
+#define DEFINE_BASELINES(NAME, T, SUM_T, FIELD)                                             \
+static void serial_##NAME(const void *data, size_t n, ReduceResult *r) {                   \
+    const T *arr = (const T*)data;                                                          \
+    SUM_T sum = 0;                                                                          \
+    T mn = arr[0], mx = arr[0];                                                             \
+    for (size_t i = 0; i < n; i++) {                                                        \
+        T val = arr[i];                                                                     \
+        sum += val;                                                                         \
+        if (val < mn) mn = val;                                                             \
+        if (val > mx) mx = val;                                                             \
+    }                                                                                       \
+    reduce_identity(r);                                                                     \
+    r->FIELD##sum = sum; r->FIELD##min = mn; r->FIELD##max = mx;                            \
+}                                                                                           \
+static void omp_##NAME(const void *data, size_t n, ReduceResult *r) {                      \
+    const T *arr = (const T*)data;                                                          \
+    SUM_T sum = 0;                                                                          \
+    T mn = arr[0], mx = arr[0];                                                             \
+    _Pragma("omp parallel for reduction(+:sum) reduction(min:mn) reduction(max:mx)")        \
+    for (size_t i = 0; i < n; i++) {                                                        \
+        T val = arr[i];                                                                     \
+        sum += val;                                                                         \
+        if (val < mn) mn = val;                                                             \
+        if (val > mx) mx = val;                                                             \
+    }                                                                                       \
+    reduce_identity(r);                                                                     \
+    r->FIELD##sum = sum; r->FIELD##min = mn; r->FIELD##max = mx;                            \
+}
+
+DEFINE_BASELINES(int32, int32_t, long long, i)
+DEFINE_BASELINES(int64, int64_t, long long, i)
+DEFINE_BASELINES(float, float, double, f)
+DEFINE_BASELINES(double, double, double, f)
 
-int main() {
-    int *arr = (int*)malloc(SIZE * sizeof(int));
-    if (arr == NULL) return 1;
+typedef void (*Reducer)(const void *data, size_t n, ReduceResult *r);
+static const Reducer serial_reducers[NUM_REDUCE_TYPES] = {serial_int32, serial_int64, serial_float, serial_double};
+static const Reducer omp_reducers[NUM_REDUCE_TYPES] = {omp_int32, omp_int64, omp_float, omp_double};
 
-    srand(time(NULL));
-    for (int i = 0; i < SIZE; i++) {
-        arr[i] = rand();
+// Pins OpenMP thread t of a team of `threads` to CPU t; libgomp keeps the same
+// threads for later regions of that size, so the pinning sticks
+void pin_threads(int threads) {
+    int ncpu = omp_get_num_procs();
+    #pragma omp parallel num_threads(threads)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(omp_get_thread_num() % ncpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
     }
+}
 
-    long long serial_sum = 0;
-    int serial_min = INT_MAX;
-    int serial_max = INT_MIN;
+// First touch by the threads (and the static split) that will read each share,
+// then the values from the counter-based RNG, generated in parallel
+void* alloc_input(ReduceType type, size_t n, uint64_t seed, int threads) {
+    size_t bytes = (n * reduce_type_size[type] + 63) / 64 * 64;
+    char *data = (char*)aligned_alloc(64, bytes);
+    if (data == NULL) return NULL;
+    #pragma omp parallel num_threads(threads)
+    {
+        size_t begin, end;
+        reduce_split(n, reduce_type_size[type], omp_get_thread_num(), threads, &begin, &end);
+        memset(data + begin * reduce_type_size[type], 0, (end - begin) * reduce_type_size[type]);
+    }
+    reduce_fill_random(type, data, n, seed, 0, threads);
+    return data;
+}
 
-    double start_serial = omp_get_wtime();
+int results_match(ReduceType type, const ReduceResult *a, const ReduceResult *b, size_t n) {
+    if (type == RT_INT32 || type == RT_INT64) {
+        return a->isum == b->isum && a->imin == b->imin && a->imax == b->imax;
+    }
+    // Sums in a different order: relative to the sum of magnitudes (at most 1000 per element)
+    return a->fmin == b->fmin && a->fmax == b->fmax && fabs(a->fsum - b->fsum) <= 1000.0 * 1e-12 * n;
+}
 
-    for (int i = 0; i < SIZE; i++) {
-        int val = arr[i];
-        serial_sum += val;
-        if (val < serial_min) serial_min = val;
-        if (val > serial_max) serial_max = val;
+void print_result(const char *label, ReduceType type, const ReduceResult *r) {
+    if (type == RT_INT32 || type == RT_INT64) {
+        printf("%-26s Sum: %lld | Min: %lld | Max: %lld\n", label, (long long)r->isum, (long long)r->imin, (long long)r->imax);
+    } else {
+        printf("%-26s Sum: %.6f | Min: %.6f | Max: %.6f\n", label, r->fsum, r->fmin, r->fmax);
     }
+}
 
-    double end_serial = omp_get_wtime();
-    double time_serial = end_serial - start_serial;
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : SIZE;
+    uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : SEED;
+    int threads = omp_get_max_threads();
 
-    long long par_sum = 0;
-    int par_min = INT_MAX;
-    int par_max = INT_MIN;
+    BwProfile profile;
+    int have_profile = bw_profile_load_default(&profile) == 0;
+    if (!have_profile) printf("No bandwidth profile found (run Assignment1/Bandwidth/stream); %% of peak omitted\n");
 
-    double start_par = omp_get_wtime();
+    pin_threads(threads);
 
-    #pragma omp parallel for reduction(+:par_sum) reduction(min:par_min) reduction(max:par_max)
-    for (int i = 0; i < SIZE; i++) {
-        int val = arr[i];
-        par_sum += val;
-        if (val < par_min) par_min = val;
-        if (val > par_max) par_max = val;
-    }
+    int ok = 1;
+    for (int type = 0; type < NUM_REDUCE_TYPES; type++) {
+        // Optional second argument: comma-separated list of types to run
+        if (argc > 2 && strstr(argv[2], reduce_type_names[type]) == NULL) continue;
 
-    double end_par = omp_get_wtime();
-    double time_par = end_par - start_par;
-
-    printf("\nPerformance Comparison (Array Size: %d)\n", SIZE);
-    printf("===================================================\n");
-    printf("| %-20s | %-20s |\n", "Execution Type", "Time (seconds)");
-    printf("|----------------------|----------------------|\n");
-    printf("| %-20s | %-20f |\n", "Serial (Single Core)", time_serial);
-    printf("| %-20s | %-20f |\n", "Parallel (OpenMP)", time_par);
-    printf("===================================================\n");
-    
-    printf("\nVerification:\n");
-    printf("Serial Sum: %lld | Parallel Sum: %lld\n", serial_sum, par_sum);
-    printf("Serial Min: %d | Parallel Min: %d\n", serial_min, par_min);
-    printf("Serial Max: %d | Parallel Max: %d\n", serial_max, par_max);
-
-    free(arr);
-    return 0;
-}
+        double fill_start = omp_get_wtime();
+        void *data = alloc_input(type, n, seed, threads);
+        if (data == NULL) {
+            fprintf(stderr, "Cannot allocate %zu %s elements\n", n, reduce_type_names[type]);
+            return 1;
+        }
+        double fill_sec = omp_get_wtime() - fill_start;
+        long long bytes = (long long)(n * reduce_type_size[type]);
 
+        const char *labels[4] = {"Serial (scalar branches)", "OpenMP reduction (scalar)", "Fused SIMD (1 thread)", "Fused SIMD (pinned)"};
+        int run_threads[4] = {1, threads, 1, threads};
+        double best[4];
+        ReduceResult results[4];
+        for (int m = 0; m < 4; m++) {
+            best[m] = 1e30;
+            for (int run = 0; run < TIMED_RUNS; run++) {
+                double start = omp_get_wtime();
+                if (m == 0) serial_reducers[type](data, n, &results[m]);
+                else if (m == 1) omp_reducers[type](data, n, &results[m]);
+                else fused_reduce(type, data, n, run_threads[m], &results[m]);
+                double elapsed = omp_get_wtime() - start;
+                if (elapsed < best[m]) best[m] = elapsed;
+            }
+        }
+
+        printf("\nPerformance Comparison (%s, Array Size: %zu, %.2f GB, %d threads, best of %d)\n",
+               reduce_type_names[type], n, bytes / 1e9, threads, TIMED_RUNS);
+        printf("Input: seed %llu, generated in %.3f s (%.2f GB/s)\n", (unsigned long long)seed, fill_sec, bytes / fill_sec / 1e9);
+        printf("=====================================================================================\n");
+        printf("| %-26s | %-14s | %-10s | %-10s | %-10s |\n", "Execution Type", "Time (seconds)", "GB/s", "Read peak", "% of peak");
+        printf("|----------------------------|----------------|------------|------------|------------|\n");
+        for (int m = 0; m < 4; m++) {
+            char label[48];
+            snprintf(label, sizeof(label), m == 3 ? "%s x%d" : "%s", labels[m], run_threads[m]);
+            double gbps = bytes / best[m] / 1e9;
+            double peak = have_profile ? bw_profile_peak(&profile, "read", bytes, run_threads[m]) : 0.0;
+            if (peak > 0) printf("| %-26s | %-14f | %10.2f | %10.2f | %9.1f%% |\n", label, best[m], gbps, peak, 100.0 * gbps / peak);
+            else printf("| %-26s | %-14f | %10.2f | %-10s | %-10s |\n", label, best[m], gbps, "-", "-");
+        }
+        printf("=====================================================================================\n");
+
+        printf("\nVerification:\n");
+        for (int m = 0; m < 4; m++) print_result(labels[m], type, &results[m]);
+        for (int m = 1; m < 4; m++) {
+            if (!results_match(type, &results[m], &results[0], n)) {
+                printf("ERROR: %s differs from the serial result\n", labels[m]);
+                ok = 0;
+            }
+        }
+        free(data);
+    }
+    return ok ? 0 : 1;
+}
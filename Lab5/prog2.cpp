@@ -7,45 +7,19 @@
 #include <thread>
 #include <atomic>
 #include <fstream>
-#include <sstream>
 #include <string>
 #include <omp.h>
+#include "cpu_accounting.h"
+#include "worker_pool.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
-struct CpuSnapshot {
-    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
-};
-
-CpuSnapshot get_cpu_snapshot() {
-    CpuSnapshot snap = {0};
-    ifstream file("/proc/stat");
-    if (!file.is_open()) return snap;
-
-    string line, label;
-    getline(file, line);
-    istringstream iss(line);
-
-    iss >> label >> snap.user >> snap.nice >> snap.system >> snap.idle
-        >> snap.iowait >> snap.irq >> snap.softirq >> snap.steal;
-
-    return snap;
-}
-
-double calculate_cpu_usage(const CpuSnapshot& start, const CpuSnapshot& end) {
-    unsigned long long active_start = start.user + start.nice + start.system + start.irq + start.softirq + start.steal;
-    unsigned long long idle_start = start.idle + start.iowait;
-
-    unsigned long long active_end = end.user + end.nice + end.system + end.irq + end.softirq + end.steal;
-    unsigned long long idle_end = end.idle + end.iowait;
-
-    unsigned long long active_diff = active_end - active_start;
-    unsigned long long idle_diff = idle_end - idle_start;
-    unsigned long long total_diff = active_diff + idle_diff;
-
-    if (total_diff == 0) return 0.0;
-    return (double)active_diff / total_diff * 100.0;
-}
+#define CHECK_BLOCK 4096            // Elements per block of the cancellable check (16 KB of int)
+#define VIOLATION_FRACTION 100      // Unsorted input: first violation at n / VIOLATION_FRACTION
+#define DISPATCH_REPS 20000         // Empty parallel regions per dispatch latency measurement
 
 void generate_list(vector<int>& arr, int size) {
     for (int i = 0; i < size; i++) {
@@ -93,92 +67,293 @@ void thread_worker(const vector<int>* arr, int start, int end, int* result) {
 
 bool manual_thread_check(const vector<int>& arr) {
     int n = arr.size();
-    int num_threads = thread::hardware_concurrency();
-    vector<thread> threads;
+    WorkerPool& pool = default_pool();
+    int num_threads = pool.size();
     
     // Changed vector<bool> to vector<int>
     vector<int> results(num_threads, 1);
     
     int chunk_size = (n - 1) / num_threads;
 
-    for (int i = 0; i < num_threads; i++) {
+    // Persistent pool: one wake-up + barrier per call instead of creating num_threads threads
+    auto chunk = [&](int i, int count) {
         int start = i * chunk_size;
-        int end = (i == num_threads - 1) ? (n - 1) : (i + 1) * chunk_size;
-        
-        threads.emplace_back(thread_worker, &arr, start, end, &results[i]);
-    }
+        int end = (i == count - 1) ? (n - 1) : (i + 1) * chunk_size;
+        thread_worker(&arr, start, end, &results[i]);
+    };
+    pool.run(chunk);
 
     bool global_sorted = true;
     for (int i = 0; i < num_threads; i++) {
-        threads[i].join();
         if (results[i] == 0) global_sorted = false;
     }
     return global_sorted;
 }
 
-int main() {
+// Index of the first arr[i] > arr[i+1] in [begin, end), or -1
+long long scan_block(const int* arr, long long begin, long long end) {
+    long long i = begin;
+#if defined(__AVX2__)
+    // 8 pairs per compare: arr[i..i+7] against arr[i+1..i+8]; OR the masks, test once per 32 pairs
+    for (; i + 32 <= end; i += 32) {
+        __m256i bad = _mm256_setzero_si256();
+        for (int k = 0; k < 32; k += 8) {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(arr + i + k));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(arr + i + k + 1));
+            bad = _mm256_or_si256(bad, _mm256_cmpgt_epi32(a, b));
+        }
+        if (!_mm256_testz_si256(bad, bad)) break;   // Locate it below
+    }
+#endif
+    for (; i < end; i++) {
+        if (arr[i] > arr[i+1]) return i;
+    }
+    return -1;
+}
+
+// Cancellable check: threads claim fixed-size blocks in ascending order and
+// poll the earliest violation found so far before each one. A block past it
+// cannot hold the first violation, so every thread stops within one block;
+// all earlier blocks were already claimed and are finished, so the minimum is exact.
+// Returns the first i with arr[i] > arr[i+1], or -1 if sorted.
+long long simd_cancel_check(const vector<int>& arr) {
+    long long pairs = (long long)arr.size() - 1;
+    if (pairs <= 0) return -1;
+    const int* data = arr.data();
+    atomic<long long> next_block(0);
+    atomic<long long> first(pairs);     // "None yet"
+
+    #pragma omp parallel
+    {
+        while (true) {
+            long long begin = next_block.fetch_add(1, memory_order_relaxed) * CHECK_BLOCK;
+            if (begin >= pairs || begin >= first.load(memory_order_relaxed)) break;
+            long long end = min(begin + CHECK_BLOCK, pairs);
+            long long found = scan_block(data, begin, end);
+            if (found >= 0) {
+                long long cur = first.load(memory_order_relaxed);
+                while (found < cur && !first.compare_exchange_weak(cur, found, memory_order_relaxed)) {}
+                break;
+            }
+        }
+    }
+    long long result = first.load();
+    return result == pairs ? -1 : result;
+}
+
+// Sorted input with one descent at n / VIOLATION_FRACTION
+void generate_unsorted_list(vector<int>& arr, int size) {
+    generate_list(arr, size);
+    int pos = size / VIOLATION_FRACTION;
+    if (size > 1) arr[pos] = arr[pos + 1] + 1;
+}
+
+struct MethodResult {
+    double time;        // Seconds per call
+    Account account;    // Whole measurement: process CPU, context switches, per-thread CPU
+    Usage caller;       // Calling thread (pool thread 0 / OpenMP master), getrusage(RUSAGE_THREAD)
+    bool pooled;        // Ran on the WorkerPool: busy / spin are known
+    double busy, spin;  // Pool CPU seconds per call, summed over its threads
+    vector<double> thread_busy, thread_spin;    // Pool CPU seconds of each pool thread, whole measurement
+};
+
+// Average seconds per call over `iterations` calls, with this process's CPU accounting
+template <typename Check>
+MethodResult time_check(Check check, const vector<int>& arr, int iterations, bool pooled) {
+    WorkerPool& pool = default_pool();
+    pool.reset_stats();
+    AccountSnapshot begin = account_begin();
+    Usage caller_begin = thread_usage();
+    for (int k = 0; k < iterations; k++) check(arr);
+    MethodResult r;
+    r.caller = usage_delta(caller_begin, thread_usage());
+    r.account = account_end(begin);
+    r.time = r.account.wall / iterations;
+    r.pooled = pooled;
+    r.busy = r.spin = 0.0;
+    for (int id = 0; id < pool.size(); id++) {
+        r.thread_busy.push_back(pool.busy_time(id));
+        r.thread_spin.push_back(pool.spin_time(id));
+        r.busy += pool.busy_time(id) / iterations;
+        r.spin += pool.spin_time(id) / iterations;
+    }
+    return r;
+}
+
+// Average microseconds to start and finish an empty parallel region on every thread
+void report_dispatch_latency() {
+    WorkerPool& pool = default_pool();
+    int num_threads = pool.size();
+    atomic<int> sink(0);
+    auto empty = [&](int id, int) { if (id < 0) sink++; };
+
+    double start_time = omp_get_wtime();
+    int thread_reps = DISPATCH_REPS / 20;
+    for (int k = 0; k < thread_reps; k++) {
+        vector<thread> threads;
+        for (int i = 0; i < num_threads; i++) threads.emplace_back(empty, i, num_threads);
+        for (thread& t : threads) t.join();
+    }
+    double create_us = (omp_get_wtime() - start_time) / thread_reps * 1e6;
+
+    start_time = omp_get_wtime();
+    for (int k = 0; k < DISPATCH_REPS; k++) {
+        #pragma omp parallel num_threads(num_threads)
+        empty(omp_get_thread_num(), num_threads);
+    }
+    double omp_us = (omp_get_wtime() - start_time) / DISPATCH_REPS * 1e6;
+
+    pool.run(empty);    // Warm-up: workers spinning
+    start_time = omp_get_wtime();
+    for (int k = 0; k < DISPATCH_REPS; k++) pool.run(empty);
+    double pool_us = (omp_get_wtime() - start_time) / DISPATCH_REPS * 1e6;
+
+    cout << "\nDispatch latency: empty parallel region on " << num_threads << " threads (fork + join)\n";
+    cout << string(60, '-') << endl;
+    cout << left << setw(40) << "std::thread create + join" << fixed << setprecision(2) << create_us << " us" << endl;
+    cout << left << setw(40) << "OpenMP parallel region" << omp_us << " us" << endl;
+    cout << left << setw(40) << "WorkerPool (spin-then-futex)" << pool_us << " us" << endl;
+    cout << string(60, '-') << endl;
+}
+
+// Per-thread CPU of one measurement: /proc/self/task, plus busy / spin for pool threads
+void report_accounting(const string& name, const MethodResult& r) {
+    WorkerPool& pool = default_pool();
+    const Account& a = r.account;
+    cout << name << ": process CPU " << fixed << setprecision(3) << a.process.cpu << " s over " << a.wall << " s wall, "
+         << a.process.vcsw << " voluntary / " << a.process.ivcsw << " involuntary context switches\n";
+    cout << "    calling thread (RUSAGE_THREAD): cpu " << setprecision(3) << r.caller.cpu << " s, "
+         << r.caller.vcsw << " voluntary / " << r.caller.ivcsw << " involuntary context switches\n";
+    for (const TaskUsage& t : a.tasks) {
+        cout << "    tid " << left << setw(8) << t.tid << " cpu " << setprecision(3) << setw(8) << t.usage.cpu << " s"
+             << "  vcsw " << setw(8) << t.usage.vcsw << " ivcsw " << setw(8) << t.usage.ivcsw;
+        for (int id = 0; r.pooled && id < pool.size(); id++) {
+            if (pool.thread_tid(id) != t.tid) continue;
+            cout << " pool thread " << id << ": busy " << setprecision(3) << r.thread_busy[id]
+                 << " s, spin " << r.thread_spin[id] << " s";
+        }
+        cout << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
     vector<int> sizes = {10000, 25000, 50000, 1000000, 10000000};
+    int current_iterations = argc > 1 ? atoi(argv[1]) : 5000;
+    const char* names[4] = {"OMP_Flag", "OMP_Red", "Manual", "SIMD"};
+    int threads_used[4] = {omp_get_max_threads(), omp_get_max_threads(), default_pool().size(), omp_get_max_threads()};
 
+    // *_CPU: this process's CPU time / (wall time x threads used), no longer the system-wide /proc/stat figure
     ofstream csv_file("prog2_values.csv");
-    csv_file << "Size,OMP_Flag_Time,OMP_Flag_CPU,OMP_Red_Time,OMP_Red_CPU,Manual_Time,Manual_CPU\n";
+    csv_file << "Size";
+    for (const char* m : names) csv_file << "," << m << "_Time," << m << "_CPU";
+    for (const char* m : names) {
+        csv_file << "," << m << "_Proc_CPU," << m << "_VCSW," << m << "_IVCSW," << m << "_Busy," << m << "_Spin";
+    }
+    csv_file << ",Unsorted_OMP_Flag_Time,Unsorted_OMP_Red_Time,Unsorted_Manual_Time,Unsorted_SIMD_Time,First_Violation\n";
 
-    cout << "Sorted Check Benchmark (Averaged over many iterations)\n";
-    cout << string(95, '-') << endl;
+    cout << "Sorted Check Benchmark (Averaged over " << current_iterations << " iterations, "
+         << omp_get_max_threads() << " threads, " << CHECK_BLOCK << "-element blocks)\n";
+    cout << "Sorted input: every method scans the whole list; CPU% = process CPU / (wall x threads)\n";
+    cout << string(120, '-') << endl;
     cout << left << setw(10) << "Size"
          << setw(15) << "OMP Flag(s)" << setw(10) << "CPU%"
          << setw(15) << "OMP Red(s)" << setw(10) << "CPU%"
-         << setw(15) << "Manual(s)" << setw(10) << "CPU%" << endl;
-    cout << string(95, '-') << endl;
+         << setw(15) << "Manual(s)" << setw(10) << "CPU%"
+         << setw(15) << "SIMD Cancel(s)" << setw(10) << "CPU%" << endl;
+    cout << string(120, '-') << endl;
 
+    // Every method must call the sorted list sorted and the unsorted one unsorted
+    bool (*const bool_checks[3])(const vector<int>&) = {omp_check_early_exit, omp_check_reduction, manual_thread_check};
+    int ok = 1;
+
+    vector<vector<double>> unsorted_rows;
+    vector<MethodResult> largest;
     for (int n : sizes) {
         vector<int> arr(n);
         generate_list(arr, n);
 
-        CpuSnapshot s1, s2;
-        double start_time, end_time;
-        
-        // 1. OMP Flag
-        s1 = get_cpu_snapshot();
-        start_time = omp_get_wtime();
-
-        int current_iterations = 5000;
-        
-        for(int k=0; k<current_iterations; k++) omp_check_early_exit(arr);
-        end_time = omp_get_wtime();
-        s2 = get_cpu_snapshot();
-        
-        double t1 = (end_time - start_time) / current_iterations;
-        double c1 = calculate_cpu_usage(s1, s2);
-
-        // 2. OMP Reduction
-        s1 = get_cpu_snapshot();
-        start_time = omp_get_wtime();
-        for(int k=0; k<current_iterations; k++) omp_check_reduction(arr);
-        end_time = omp_get_wtime();
-        s2 = get_cpu_snapshot();
-
-        double t2 = (end_time - start_time) / current_iterations;
-        double c2 = calculate_cpu_usage(s1, s2);
-
-        // 3. Manual Threads
-        s1 = get_cpu_snapshot();
-        start_time = omp_get_wtime();
-        for(int k=0; k<current_iterations; k++) manual_thread_check(arr);
-        end_time = omp_get_wtime();
-        s2 = get_cpu_snapshot();
-
-        double t3 = (end_time - start_time) / current_iterations;
-        double c3 = calculate_cpu_usage(s1, s2);
-
-        cout << left << setw(10) << n
-             << fixed << setprecision(6) << setw(15) << t1 << setprecision(1) << setw(10) << c1
-             << fixed << setprecision(6) << setw(15) << t2 << setprecision(1) << setw(10) << c2
-             << fixed << setprecision(6) << setw(15) << t3 << setprecision(1) << setw(10) << c3 << endl;
-
-        csv_file << n << "," << t1 << "," << c1 << "," << t2 << "," << c2 << "," << t3 << "," << c3 << "\n";
+        MethodResult r[4] = {
+            time_check(omp_check_early_exit, arr, current_iterations, false),  // 1. OMP Flag
+            time_check(omp_check_reduction, arr, current_iterations, false),   // 2. OMP Reduction
+            time_check(manual_thread_check, arr, current_iterations, true),    // 3. Manual Threads (pool)
+            time_check(simd_cancel_check, arr, current_iterations, false),     // 4. SIMD blocks + cancellation
+        };
+        for (int m = 0; m < 3; m++) {
+            if (!bool_checks[m](arr)) {
+                cout << "ERROR: " << names[m] << " reports a sorted list of " << n << " as unsorted\n";
+                ok = 0;
+            }
+        }
+        if (simd_cancel_check(arr) != -1) {
+            cout << "ERROR: SIMD Cancel reports a violation in a sorted list\n";
+            ok = 0;
+        }
+
+        cout << left << setw(10) << n;
+        for (int m = 0; m < 4; m++) {
+            cout << fixed << setprecision(6) << setw(15) << r[m].time
+                 << setprecision(1) << setw(10) << r[m].account.utilisation(threads_used[m]);
+        }
+        cout << endl;
+
+        // Same list with an early violation: only a real early exit gets cheaper
+        generate_unsorted_list(arr, n);
+        long long expected = is_sorted_until(arr.begin(), arr.end()) - arr.begin() - 1;
+        long long first = simd_cancel_check(arr);
+        if (first != expected) {
+            cout << "ERROR: SIMD Cancel reports first violation " << first << ", expected " << expected << "\n";
+            ok = 0;
+        }
+        for (int m = 0; m < 3; m++) {
+            if (n > 1 && bool_checks[m](arr)) {
+                cout << "ERROR: " << names[m] << " misses the violation at " << expected << "\n";
+                ok = 0;
+            }
+        }
+        unsorted_rows.push_back({(double)n,
+                                 time_check(omp_check_early_exit, arr, current_iterations, false).time,
+                                 time_check(omp_check_reduction, arr, current_iterations, false).time,
+                                 time_check(manual_thread_check, arr, current_iterations, true).time,
+                                 time_check(simd_cancel_check, arr, current_iterations, false).time,
+                                 (double)first, r[3].time});
+
+        const vector<double>& u = unsorted_rows.back();
+        csv_file << n;
+        for (int m = 0; m < 4; m++) csv_file << "," << r[m].time << "," << r[m].account.utilisation(threads_used[m]);
+        for (int m = 0; m < 4; m++) {
+            const Account& a = r[m].account;
+            csv_file << "," << a.process.cpu / current_iterations
+                     << "," << (double)a.process.vcsw / current_iterations
+                     << "," << (double)a.process.ivcsw / current_iterations << ",";
+            if (r[m].pooled) csv_file << r[m].busy;     // Busy / spin only exist for the pool
+            csv_file << ",";
+            if (r[m].pooled) csv_file << r[m].spin;
+        }
+        csv_file << "," << u[1] << "," << u[2] << "," << u[3] << "," << u[4] << "," << first << "\n";
+        if (n == sizes.back()) largest.assign(r, r + 4);
     }
+    cout << string(120, '-') << endl;
 
-    cout << string(95, '-') << endl;
+    cout << "\nUnsorted input: first violation at n / " << VIOLATION_FRACTION << "\n";
+    cout << string(120, '-') << endl;
+    cout << left << setw(10) << "Size"
+         << setw(15) << "OMP Flag(s)" << setw(15) << "OMP Red(s)" << setw(15) << "Manual(s)"
+         << setw(15) << "SIMD Cancel(s)" << setw(20) << "First violation" << setw(30) << "SIMD speedup vs sorted input" << endl;
+    cout << string(120, '-') << endl;
+    for (size_t i = 0; i < unsorted_rows.size(); i++) {
+        const vector<double>& u = unsorted_rows[i];
+        cout << left << setw(10) << (int)u[0] << fixed << setprecision(6)
+             << setw(15) << u[1] << setw(15) << u[2] << setw(15) << u[3] << setw(15) << u[4]
+             << setw(20) << (long long)u[5] << setprecision(1) << u[6] / u[4] << "x" << endl;
+    }
+    cout << string(120, '-') << endl;
     csv_file.close();
-    return 0;
-}
\ No newline at end of file
+
+    cout << "\nCPU accounting, sorted input of " << sizes.back() << " (" << current_iterations << " calls per method)\n";
+    cout << string(120, '-') << endl;
+    for (int m = 0; m < 4; m++) report_accounting(names[m], largest[m]);
+    cout << string(120, '-') << endl;
+
+    report_dispatch_latency();
+    return ok ? 0 : 1;
+}
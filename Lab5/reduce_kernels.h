@@ -0,0 +1,298 @@
+#ifndef LAB5_REDUCE_KERNELS_H
+#define LAB5_REDUCE_KERNELS_H
+
+/*
+ * Fused single-pass sum / min / max kernels.
+ *
+ * One read of the data produces all three results. With AVX2:
+ *   int32  - _mm256_min/max_epi32; sums widened to int64 (_mm256_cvtepi32_epi64)
+ *   int64  - compare + blend for min/max (AVX2 has no epi64 min/max)
+ *   float  - _mm256_min/max_ps; sums widened to double
+ *   double - _mm256_min/max_pd
+ * Each iteration consumes 128 bytes (two cache lines) into four independent
+ * sum accumulators, so the adds never serialise on one register, and
+ * prefetches REDUCE_PREFETCH bytes ahead. Inputs must not contain NaN.
+ *
+ * reduce_range() runs the kernel of a type over [begin, end); callers split the
+ * array statically, keep one PaddedResult per thread and reduce_combine() them.
+ * With OpenMP, fused_reduce() does exactly that over a whole array.
+ *
+ * reduce_fill_random() makes the test inputs from the counter-based RNG, so
+ * a (seed, type, N) triple always gives the same column, however it is
+ * produced (in memory by prog1, in chunks by stream_reduce).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <float.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "../common/counter_rng.h"
+
+#define REDUCE_PREFETCH 1024        // Bytes ahead of the loads
+
+typedef enum { RT_INT32 = 0, RT_INT64, RT_FLOAT, RT_DOUBLE, NUM_REDUCE_TYPES } ReduceType;
+static const char *reduce_type_names[NUM_REDUCE_TYPES] __attribute__((unused)) = {"int32", "int64", "float", "double"};
+static const size_t reduce_type_size[NUM_REDUCE_TYPES] __attribute__((unused)) = {4, 8, 4, 8};
+
+typedef struct {
+    int64_t isum, imin, imax;       // Integer inputs
+    double fsum, fmin, fmax;        // Floating-point inputs (sum accumulated in double)
+} ReduceResult;
+
+// One per thread: partials of neighbouring threads never share a cache line
+typedef struct {
+    ReduceResult r;
+    char pad[64 - sizeof(ReduceResult) % 64];
+} __attribute__((aligned(64))) PaddedResult;
+
+static inline void reduce_identity(ReduceResult *r) {
+    r->isum = 0;
+    r->imin = INT64_MAX;
+    r->imax = INT64_MIN;
+    r->fsum = 0.0;
+    r->fmin = DBL_MAX;
+    r->fmax = -DBL_MAX;
+}
+
+static inline void reduce_combine(ReduceResult *into, const ReduceResult *r) {
+    into->isum += r->isum;
+    if (r->imin < into->imin) into->imin = r->imin;
+    if (r->imax > into->imax) into->imax = r->imax;
+    into->fsum += r->fsum;
+    if (r->fmin < into->fmin) into->fmin = r->fmin;
+    if (r->fmax > into->fmax) into->fmax = r->fmax;
+}
+
+#if defined(__AVX2__)
+static inline int64_t hsum_epi64(__m256i v) {
+    __m128i s = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return _mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1);
+}
+
+static inline double hsum_pd(__m256d v) {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+#endif
+
+static inline void reduce_int32(const int32_t *a, size_t n, ReduceResult *r) {
+    size_t i = 0;
+    int64_t sum = 0;
+    int32_t mn = INT32_MAX, mx = INT32_MIN;
+#if defined(__AVX2__)
+    __m256i s0 = _mm256_setzero_si256(), s1 = s0, s2 = s0, s3 = s0;
+    __m256i vmin = _mm256_set1_epi32(INT32_MAX), vmax = _mm256_set1_epi32(INT32_MIN);
+    for (; i + 32 <= n; i += 32) {
+        _mm_prefetch((const char*)(a + i) + REDUCE_PREFETCH, _MM_HINT_T0);
+        _mm_prefetch((const char*)(a + i) + REDUCE_PREFETCH + 64, _MM_HINT_T0);
+        __m256i x0 = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i x1 = _mm256_loadu_si256((const __m256i*)(a + i + 8));
+        __m256i x2 = _mm256_loadu_si256((const __m256i*)(a + i + 16));
+        __m256i x3 = _mm256_loadu_si256((const __m256i*)(a + i + 24));
+        vmin = _mm256_min_epi32(vmin, _mm256_min_epi32(_mm256_min_epi32(x0, x1), _mm256_min_epi32(x2, x3)));
+        vmax = _mm256_max_epi32(vmax, _mm256_max_epi32(_mm256_max_epi32(x0, x1), _mm256_max_epi32(x2, x3)));
+        s0 = _mm256_add_epi64(s0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x0)));
+        s1 = _mm256_add_epi64(s1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x0, 1)));
+        s2 = _mm256_add_epi64(s2, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x1)));
+        s3 = _mm256_add_epi64(s3, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x1, 1)));
+        s0 = _mm256_add_epi64(s0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x2)));
+        s1 = _mm256_add_epi64(s1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x2, 1)));
+        s2 = _mm256_add_epi64(s2, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x3)));
+        s3 = _mm256_add_epi64(s3, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x3, 1)));
+    }
+    sum = hsum_epi64(_mm256_add_epi64(_mm256_add_epi64(s0, s1), _mm256_add_epi64(s2, s3)));
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, vmin);
+    for (int k = 0; k < 8; k++) mn = lanes[k] < mn ? lanes[k] : mn;
+    _mm256_storeu_si256((__m256i*)lanes, vmax);
+    for (int k = 0; k < 8; k++) mx = lanes[k] > mx ? lanes[k] : mx;
+#endif
+    for (; i < n; i++) {
+        sum += a[i];
+        mn = a[i] < mn ? a[i] : mn;
+        mx = a[i] > mx ? a[i] : mx;
+    }
+    r->isum = sum;
+    r->imin = mn;
+    r->imax = mx;
+}
+
+static inline void reduce_int64(const int64_t *a, size_t n, ReduceResult *r) {
+    size_t i = 0;
+    int64_t sum = 0, mn = INT64_MAX, mx = INT64_MIN;
+#if defined(__AVX2__)
+    __m256i s0 = _mm256_setzero_si256(), s1 = s0, s2 = s0, s3 = s0;
+    __m256i vmin = _mm256_set1_epi64x(INT64_MAX), vmax = _mm256_set1_epi64x(INT64_MIN);
+    for (; i + 16 <= n; i += 16) {
+        _mm_prefetch((const char*)(a + i) + REDUCE_PREFETCH, _MM_HINT_T0);
+        _mm_prefetch((const char*)(a + i) + REDUCE_PREFETCH + 64, _MM_HINT_T0);
+        __m256i x0 = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i x1 = _mm256_loadu_si256((const __m256i*)(a + i + 4));
+        __m256i x2 = _mm256_loadu_si256((const __m256i*)(a + i + 8));
+        __m256i x3 = _mm256_loadu_si256((const __m256i*)(a + i + 12));
+        s0 = _mm256_add_epi64(s0, x0);
+        s1 = _mm256_add_epi64(s1, x1);
+        s2 = _mm256_add_epi64(s2, x2);
+        s3 = _mm256_add_epi64(s3, x3);
+        __m256i lo01 = _mm256_blendv_epi8(x0, x1, _mm256_cmpgt_epi64(x0, x1));
+        __m256i hi01 = _mm256_blendv_epi8(x1, x0, _mm256_cmpgt_epi64(x0, x1));
+        __m256i lo23 = _mm256_blendv_epi8(x2, x3, _mm256_cmpgt_epi64(x2, x3));
+        __m256i hi23 = _mm256_blendv_epi8(x3, x2, _mm256_cmpgt_epi64(x2, x3));
+        __m256i lo = _mm256_blendv_epi8(lo01, lo23, _mm256_cmpgt_epi64(lo01, lo23));
+        __m256i hi = _mm256_blendv_epi8(hi01, hi23, _mm256_cmpgt_epi64(hi23, hi01));
+        vmin = _mm256_blendv_epi8(vmin, lo, _mm256_cmpgt_epi64(vmin, lo));
+        vmax = _mm256_blendv_epi8(vmax, hi, _mm256_cmpgt_epi64(hi, vmax));
+    }
+    sum = hsum_epi64(_mm256_add_epi64(_mm256_add_epi64(s0, s1), _mm256_add_epi64(s2, s3)));
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, vmin);
+    for (int k = 0; k < 4; k++) mn = lanes[k] < mn ? lanes[k] : mn;
+    _mm256_storeu_si256((__m256i*)lanes, vmax);
+    for (int k = 0; k < 4; k++) mx = lanes[k] > mx ? lanes[k] : mx;
+#endif
+    for (; i < n; i++) {
+        sum += a[i];
+        mn = a[i] < mn ? a[i] : mn;
+        mx = a[i] > mx ? a[i] : mx;
+    }
+    r->isum = sum;
+    r->imin = mn;
+    r->imax = mx;
+}
+
+static inline void reduce_float(const float *a, size_t n, ReduceResult *r) {
+    size_t i = 0;
+    double sum = 0.0;
+    float mn = FLT_MAX, mx = -FLT_MAX;
+#if defined(__AVX2__)
+    __m256d s0 = _mm256_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+    __m256 vmin = _mm256_set1_ps(FLT_MAX), vmax = _mm256_set1_ps(-FLT_MAX);
+    for (; i + 32 <= n; i += 32) {
+        _mm_prefetch((const char*)(a + i) + REDUCE_PREFETCH, _MM_HINT_T0);
+        _mm_prefetch((const char*)(a + i) + REDUCE_PREFETCH + 64, _MM_HINT_T0);
+        __m256 x0 = _mm256_loadu_ps(a + i);
+        __m256 x1 = _mm256_loadu_ps(a + i + 8);
+        __m256 x2 = _mm256_loadu_ps(a + i + 16);
+        __m256 x3 = _mm256_loadu_ps(a + i + 24);
+        vmin = _mm256_min_ps(vmin, _mm256_min_ps(_mm256_min_ps(x0, x1), _mm256_min_ps(x2, x3)));
+        vmax = _mm256_max_ps(vmax, _mm256_max_ps(_mm256_max_ps(x0, x1), _mm256_max_ps(x2, x3)));
+        s0 = _mm256_add_pd(s0, _mm256_cvtps_pd(_mm256_castps256_ps128(x0)));
+        s1 = _mm256_add_pd(s1, _mm256_cvtps_pd(_mm256_extractf128_ps(x0, 1)));
+        s2 = _mm256_add_pd(s2, _mm256_cvtps_pd(_mm256_castps256_ps128(x1)));
+        s3 = _mm256_add_pd(s3, _mm256_cvtps_pd(_mm256_extractf128_ps(x1, 1)));
+        s0 = _mm256_add_pd(s0, _mm256_cvtps_pd(_mm256_castps256_ps128(x2)));
+        s1 = _mm256_add_pd(s1, _mm256_cvtps_pd(_mm256_extractf128_ps(x2, 1)));
+        s2 = _mm256_add_pd(s2, _mm256_cvtps_pd(_mm256_castps256_ps128(x3)));
+        s3 = _mm256_add_pd(s3, _mm256_cvtps_pd(_mm256_extractf128_ps(x3, 1)));
+    }
+    sum = hsum_pd(_mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+    float lanes[8];
+    _mm256_storeu_ps(lanes, vmin);
+    for (int k = 0; k < 8; k++) mn = lanes[k] < mn ? lanes[k] : mn;
+    _mm256_storeu_ps(lanes, vmax);
+    for (int k = 0; k < 8; k++) mx = lanes[k] > mx ? lanes[k] : mx;
+#endif
+    for (; i < n; i++) {
+        sum += a[i];
+        mn = a[i] < mn ? a[i] : mn;
+        mx = a[i] > mx ? a[i] : mx;
+    }
+    r->fsum = sum;
+    r->fmin = mn;
+    r->fmax = mx;
+}
+
+static inline void reduce_double(const double *a, size_t n, ReduceResult *r) {
+    size_t i = 0;
+    double sum = 0.0, mn = DBL_MAX, mx = -DBL_MAX;
+#if defined(__AVX2__)
+    __m256d s0 = _mm256_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+    __m256d vmin = _mm256_set1_pd(DBL_MAX), vmax = _mm256_set1_pd(-DBL_MAX);
+    for (; i + 16 <= n; i += 16) {
+        _mm_prefetch((const char*)(a + i) + REDUCE_PREFETCH, _MM_HINT_T0);
+        _mm_prefetch((const char*)(a + i) + REDUCE_PREFETCH + 64, _MM_HINT_T0);
+        __m256d x0 = _mm256_loadu_pd(a + i);
+        __m256d x1 = _mm256_loadu_pd(a + i + 4);
+        __m256d x2 = _mm256_loadu_pd(a + i + 8);
+        __m256d x3 = _mm256_loadu_pd(a + i + 12);
+        vmin = _mm256_min_pd(vmin, _mm256_min_pd(_mm256_min_pd(x0, x1), _mm256_min_pd(x2, x3)));
+        vmax = _mm256_max_pd(vmax, _mm256_max_pd(_mm256_max_pd(x0, x1), _mm256_max_pd(x2, x3)));
+        s0 = _mm256_add_pd(s0, x0);
+        s1 = _mm256_add_pd(s1, x1);
+        s2 = _mm256_add_pd(s2, x2);
+        s3 = _mm256_add_pd(s3, x3);
+    }
+    sum = hsum_pd(_mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, vmin);
+    for (int k = 0; k < 4; k++) mn = lanes[k] < mn ? lanes[k] : mn;
+    _mm256_storeu_pd(lanes, vmax);
+    for (int k = 0; k < 4; k++) mx = lanes[k] > mx ? lanes[k] : mx;
+#endif
+    for (; i < n; i++) {
+        sum += a[i];
+        mn = a[i] < mn ? a[i] : mn;
+        mx = a[i] > mx ? a[i] : mx;
+    }
+    r->fsum = sum;
+    r->fmin = mn;
+    r->fmax = mx;
+}
+
+// Elements [begin, end) of an array of `type`; fields of the other kind are left at the identity
+static inline void reduce_range(ReduceType type, const void *data, size_t begin, size_t end, ReduceResult *r) {
+    reduce_identity(r);
+    switch (type) {
+    case RT_INT32:  reduce_int32((const int32_t*)data + begin, end - begin, r); break;
+    case RT_INT64:  reduce_int64((const int64_t*)data + begin, end - begin, r); break;
+    case RT_FLOAT:  reduce_float((const float*)data + begin, end - begin, r); break;
+    default:        reduce_double((const double*)data + begin, end - begin, r); break;
+    }
+}
+
+// Static split of n elements: thread t's share, boundaries on 64-byte multiples
+static inline void reduce_split(size_t n, size_t elem_size, int t, int threads, size_t *begin, size_t *end) {
+    size_t line = 64 / elem_size;
+    size_t lines = (n + line - 1) / line;
+    *begin = lines * t / threads * line;
+    *end = lines * (t + 1) / threads * line;
+    if (*begin > n) *begin = n;
+    if (*end > n) *end = n;
+}
+
+// Elements first .. first + n - 1 of the test column of `type` for `seed`, in
+// the ranges of the original rand() inputs: [0, 2^31) for int32, 39 bits
+// around zero for int64, [-1000, 1000) for float / double
+static inline void reduce_fill_random(ReduceType type, void *data, size_t n, uint64_t seed, uint64_t first, int threads) {
+    uint64_t key = rng_key(seed, type);
+    switch (type) {
+    case RT_INT32:  rng_fill_int32((int32_t*)data, n, key, first, 0, INT32_MAX, threads); break;
+    case RT_INT64:  rng_fill_int64((int64_t*)data, n, key, first, -((int64_t)1 << 38), ((int64_t)1 << 38) - 1, threads); break;
+    case RT_FLOAT:  rng_fill_float((float*)data, n, key, first, -1000.0, 1000.0, threads); break;
+    default:        rng_fill_double((double*)data, n, key, first, -1000.0, 1000.0, threads); break;
+    }
+}
+
+#if defined(_OPENMP)
+// Fused kernel on `threads` threads, one contiguous static share each, padded partials
+static inline void fused_reduce(ReduceType type, const void *data, size_t n, int threads, ReduceResult *out) {
+    PaddedResult partial[threads];
+    #pragma omp parallel num_threads(threads)
+    {
+        int t = omp_get_thread_num();
+        size_t begin, end;
+        reduce_split(n, reduce_type_size[type], t, threads, &begin, &end);
+        reduce_range(type, data, begin, end, &partial[t].r);
+    }
+    reduce_identity(out);
+    for (int t = 0; t < threads; t++) reduce_combine(out, &partial[t].r);
+}
+#endif
+
+#endif
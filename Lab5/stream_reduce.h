@@ -0,0 +1,278 @@
+#ifndef LAB5_STREAM_REDUCE_H
+#define LAB5_STREAM_REDUCE_H
+
+/*
+ * Streaming sum / min / max over a binary column file.
+ *
+ * A column file is raw native-endian elements of one ReduceType and may be
+ * far bigger than memory. It is processed in page-aligned chunks through two
+ * slots: while the OpenMP team runs fused_reduce() on chunk k, a loader
+ * thread brings in chunk k+1.
+ *
+ *   STREAM_PREAD - the loader pread()s each chunk into one of two aligned
+ *                  buffers (POSIX_FADV_SEQUENTIAL on the descriptor)
+ *   STREAM_MMAP  - the file is mapped once with MADV_SEQUENTIAL; the loader
+ *                  issues MADV_WILLNEED for chunk k+1 and faults it in (one
+ *                  load per page), so the compute threads never take a major
+ *                  fault. Consumed chunks are unmapped from the process with
+ *                  MADV_DONTNEED, so RSS stays at about two chunks
+ *
+ * Consumed ranges are also dropped from the page cache (POSIX_FADV_DONTNEED)
+ * so that a column larger than RAM does not evict everything else.
+ *
+ * StreamStats separates the loader's busy time (io), the kernels' time
+ * (compute) and the time compute waited for data (stall); overlap is the
+ * share of the shorter of io and compute that was hidden behind the other.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "reduce_kernels.h"
+
+#define STREAM_CHUNK (64L << 20)      // Default chunk: 64 MiB
+#define STREAM_ALIGN 4096
+
+typedef enum { STREAM_PREAD = 0, STREAM_MMAP } StreamMode;
+static const char *stream_mode_names[] __attribute__((unused)) = {"pread", "mmap"};
+
+typedef struct {
+    long long bytes;        // Reduced (whole elements only)
+    long chunks;
+    double wall;            // End to end, open to result
+    double io;              // Loader busy: pread / page faulting
+    double compute;         // fused_reduce() time
+    double stall;           // Compute waiting for the loader
+} StreamStats;
+
+static inline double stream_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline double stream_gbps(const StreamStats *s) {
+    return s->wall > 0 ? s->bytes / s->wall / 1e9 : 0.0;
+}
+
+// Share of min(io, compute) that ran concurrently with the other, in percent
+static inline double stream_overlap(const StreamStats *s) {
+    double shorter = s->io < s->compute ? s->io : s->compute;
+    double hidden = s->io + s->compute - s->wall;
+    if (shorter <= 0 || hidden <= 0) return 0.0;
+    return hidden >= shorter ? 100.0 : 100.0 * hidden / shorter;
+}
+
+typedef struct {
+    const char *data;       // Chunk start (buffer or mapping)
+    size_t bytes;
+    int full;
+} StreamSlot;
+
+typedef struct {
+    int fd;
+    StreamMode mode;
+    long long file_bytes;
+    size_t chunk;
+    long n_chunks;
+    char *buf[2];           // STREAM_PREAD
+    const char *map;        // STREAM_MMAP
+    StreamSlot slot[2];
+    int error;
+    double io;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} StreamPipe;
+
+static inline int stream_load_chunk(StreamPipe *p, long k, StreamSlot *s) {
+    long long off = (long long)k * p->chunk;
+    size_t bytes = off + (long long)p->chunk <= p->file_bytes ? p->chunk : (size_t)(p->file_bytes - off);
+    if (p->mode == STREAM_PREAD) {
+        char *dst = p->buf[k % 2];
+        size_t done = 0;
+        while (done < bytes) {
+            ssize_t got = pread(p->fd, dst + done, bytes - done, off + done);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return -1;
+            done += got;
+        }
+        s->data = dst;
+    } else {
+        const char *src = p->map + off;
+        madvise((void*)src, bytes, MADV_WILLNEED);
+        volatile char sink = 0;
+        for (size_t b = 0; b < bytes; b += STREAM_ALIGN) sink += src[b];
+        (void)sink;
+        s->data = src;
+    }
+    s->bytes = bytes;
+    return 0;
+}
+
+static inline void *stream_loader(void *arg) {
+    StreamPipe *p = (StreamPipe*)arg;
+    for (long k = 0; k < p->n_chunks; k++) {
+        StreamSlot *s = &p->slot[k % 2];
+        pthread_mutex_lock(&p->lock);
+        while (s->full && !p->error) pthread_cond_wait(&p->changed, &p->lock);
+        int stop = p->error;
+        pthread_mutex_unlock(&p->lock);
+        if (stop) break;
+
+        double t0 = stream_now();
+        int rc = stream_load_chunk(p, k, s);
+        p->io += stream_now() - t0;
+
+        pthread_mutex_lock(&p->lock);
+        if (rc != 0) p->error = 1;
+        s->full = 1;
+        pthread_cond_broadcast(&p->changed);
+        pthread_mutex_unlock(&p->lock);
+        if (rc != 0) break;
+    }
+    return NULL;
+}
+
+// Bytes of the column that hold whole elements, or -1 (message printed)
+static inline long long stream_column_bytes(int fd, ReduceType type, const char *path) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror(path);
+        return -1;
+    }
+    long long bytes = st.st_size / reduce_type_size[type] * reduce_type_size[type];
+    if (bytes != st.st_size) {
+        fprintf(stderr, "%s: %lld trailing bytes are not a whole %s and are ignored\n",
+                path, (long long)(st.st_size - bytes), reduce_type_names[type]);
+    }
+    return bytes;
+}
+
+// Drops the whole file from the page cache, so the next pass reads from the device
+static inline void stream_drop_cache(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+/*
+ * Reduces the column at `path` in chunks of `chunk` bytes (rounded up to a
+ * page) with `threads` OpenMP threads. Returns 0, or -1 with a message.
+ */
+static inline int stream_reduce(const char *path, ReduceType type, StreamMode mode, size_t chunk, int threads,
+                                ReduceResult *out, StreamStats *stats) {
+    double start = stream_now();
+    memset(stats, 0, sizeof(*stats));
+    reduce_identity(out);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    long long file_bytes = stream_column_bytes(fd, type, path);
+    if (file_bytes < 0) {
+        close(fd);
+        return -1;
+    }
+
+    StreamPipe p;
+    memset(&p, 0, sizeof(p));
+    p.fd = fd;
+    p.mode = mode;
+    p.file_bytes = file_bytes;
+    p.chunk = (chunk + STREAM_ALIGN - 1) / STREAM_ALIGN * STREAM_ALIGN;
+    if (p.chunk == 0) p.chunk = STREAM_CHUNK;
+    p.n_chunks = (long)((file_bytes + (long long)p.chunk - 1) / (long long)p.chunk);
+    pthread_mutex_init(&p.lock, NULL);
+    pthread_cond_init(&p.changed, NULL);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    int rc = 0;
+    if (mode == STREAM_PREAD) {
+        p.buf[0] = (char*)aligned_alloc(STREAM_ALIGN, p.chunk);
+        p.buf[1] = (char*)aligned_alloc(STREAM_ALIGN, p.chunk);
+        if (p.buf[0] == NULL || p.buf[1] == NULL) {
+            fprintf(stderr, "Cannot allocate two %zu-byte stream buffers\n", p.chunk);
+            rc = -1;
+        }
+    } else if (file_bytes > 0) {
+        void *map = mmap(NULL, file_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            perror("mmap");
+            rc = -1;
+        } else {
+            p.map = (const char*)map;
+            madvise(map, file_bytes, MADV_SEQUENTIAL);
+        }
+    }
+
+    pthread_t loader;
+    int started = rc == 0 && pthread_create(&loader, NULL, stream_loader, &p) == 0;
+    if (rc == 0 && !started) {
+        fprintf(stderr, "Cannot start the stream loader thread\n");
+        rc = -1;
+    }
+
+    for (long k = 0; started && k < p.n_chunks; k++) {
+        StreamSlot *s = &p.slot[k % 2];
+        double t0 = stream_now();
+        pthread_mutex_lock(&p.lock);
+        while (!s->full) pthread_cond_wait(&p.changed, &p.lock);
+        int failed = p.error;
+        pthread_mutex_unlock(&p.lock);
+        double t1 = stream_now();
+        stats->stall += t1 - t0;
+        if (failed) {
+            fprintf(stderr, "%s: read error in chunk %ld\n", path, k);
+            rc = -1;
+            break;
+        }
+
+        ReduceResult part;
+        fused_reduce(type, s->data, s->bytes / reduce_type_size[type], threads, &part);
+        reduce_combine(out, &part);
+        stats->compute += stream_now() - t1;
+        stats->bytes += s->bytes;
+        stats->chunks++;
+
+        long long off = (long long)k * p.chunk;
+        if (mode == STREAM_MMAP) madvise((void*)s->data, s->bytes, MADV_DONTNEED);
+        posix_fadvise(fd, off, s->bytes, POSIX_FADV_DONTNEED);
+
+        pthread_mutex_lock(&p.lock);
+        s->full = 0;
+        pthread_cond_broadcast(&p.changed);
+        pthread_mutex_unlock(&p.lock);
+    }
+
+    if (started) {
+        pthread_mutex_lock(&p.lock);
+        if (rc != 0) p.error = 1;       // Unblock a loader waiting for a free slot
+        pthread_cond_broadcast(&p.changed);
+        pthread_mutex_unlock(&p.lock);
+        pthread_join(loader, NULL);
+    }
+    stats->io = p.io;
+
+    free(p.buf[0]);
+    free(p.buf[1]);
+    if (p.map != NULL) munmap((void*)p.map, file_bytes);
+    pthread_mutex_destroy(&p.lock);
+    pthread_cond_destroy(&p.changed);
+    close(fd);
+    stats->wall = stream_now() - start;
+    return rc;
+}
+
+#endif
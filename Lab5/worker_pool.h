@@ -0,0 +1,196 @@
+#ifndef LAB5_WORKER_POOL_H
+#define LAB5_WORKER_POOL_H
+
+/*
+ * Persistent fork-join worker pool.
+ *
+ * The threads are created once and parked between parallel regions, so a
+ * region costs a wake-up and a barrier instead of a thread create + join.
+ *
+ *   dispatch   - the caller publishes the job and bumps `epoch`; workers
+ *                spin on it for POOL_SPIN_ITERS pauses, then sleep on a futex
+ *                (no spinning when the pool has more threads than the machine)
+ *   completion - sense-reversing barrier: every thread flips its local sense,
+ *                the last one to arrive resets the count and publishes the
+ *                new sense, the others spin-then-futex on it
+ *
+ * The caller is thread 0 and runs its share of the job itself. Futex wakes
+ * are only issued when some thread has actually gone to sleep, so
+ * back-to-back regions never enter the kernel.
+ *
+ * Every thread splits its CPU time (CLOCK_THREAD_CPUTIME_ID) into busy (in
+ * the job) and spin (waiting for work or at the barrier, sleep excluded);
+ * see busy_time() / spin_time(). Workers record a region's stats before they
+ * arrive at its barrier, so once run() returns nothing is still writing them;
+ * the time a worker then waits at the barrier is counted as spin with the
+ * wait for its next region.
+ */
+
+#include <atomic>
+#include <climits>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "cpu_accounting.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define POOL_PAUSE() _mm_pause()
+#else
+#define POOL_PAUSE() ((void)0)
+#endif
+
+#define POOL_SPIN_ITERS 4000        // ~10-40 us of pause before a waiter sleeps
+
+inline void futex_wait(std::atomic<int>* word, int expected) {
+    syscall(SYS_futex, (int*)word, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+inline void futex_wake_all(std::atomic<int>* word) {
+    syscall(SYS_futex, (int*)word, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// Wait until word != old: spin first, then sleep. Returns the new value.
+inline int wait_for_change(std::atomic<int>& word, int old, std::atomic<int>& sleepers, int spin_iters) {
+    for (int i = 0; i < spin_iters; i++) {
+        int v = word.load(std::memory_order_acquire);
+        if (v != old) return v;
+        POOL_PAUSE();
+    }
+    while (true) {
+        // Announce the sleep before the final check; pairs with publish()
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        if (word.load(std::memory_order_seq_cst) == old) futex_wait(&word, old);
+        sleepers.fetch_sub(1, std::memory_order_seq_cst);
+        int v = word.load(std::memory_order_acquire);
+        if (v != old) return v;
+    }
+}
+
+inline void publish(std::atomic<int>& word, int value, std::atomic<int>& sleepers) {
+    word.store(value, std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_seq_cst) > 0) futex_wake_all(&word);
+}
+
+class WorkerPool {
+public:
+    explicit WorkerPool(int n_threads) : n(n_threads < 1 ? 1 : n_threads), stats(new ThreadStats[n]) {
+        // Spinning only pays when every thread has a core; oversubscribed, it steals the waker's time slice
+        spin_iters = n <= (int)std::thread::hardware_concurrency() ? POOL_SPIN_ITERS : 0;
+        stats[0].tid.store((int)syscall(SYS_gettid));
+        for (int id = 1; id < n; id++) threads.emplace_back(&WorkerPool::worker, this, id);
+    }
+
+    ~WorkerPool() {
+        stop = true;
+        publish(epoch, epoch.load() + 1, epoch_sleepers);
+        for (thread_t& t : threads) t.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int size() const { return n; }
+
+    // CPU seconds of pool thread id in jobs / spinning, since the last reset_stats()
+    double busy_time(int id) const { return stats[id].busy.load(std::memory_order_relaxed); }
+    double spin_time(int id) const { return stats[id].spin.load(std::memory_order_relaxed); }
+    int thread_tid(int id) const { return stats[id].tid.load(std::memory_order_relaxed); }
+
+    void reset_stats() {
+        for (int id = 0; id < n; id++) {
+            stats[id].busy.store(0.0, std::memory_order_relaxed);
+            stats[id].spin.store(0.0, std::memory_order_relaxed);
+        }
+    }
+
+    // Calls f(thread_id, n_threads) on every pool thread (the caller is thread 0)
+    // and returns once all of them have finished
+    template <typename F>
+    void run(F& f) {
+        double t0 = thread_cpu_now();
+        if (n == 1) {
+            f(0, 1);
+            stats[0].add(thread_cpu_now() - t0, 0.0);
+            return;
+        }
+        job = [](void* arg, int id, int count) { (*(F*)arg)(id, count); };
+        job_arg = &f;
+        publish(epoch, epoch.load(std::memory_order_relaxed) + 1, epoch_sleepers);
+        f(0, n);
+        double t1 = thread_cpu_now();
+        barrier(caller_sense);
+        stats[0].add(t1 - t0, thread_cpu_now() - t1);
+    }
+
+private:
+    typedef std::thread thread_t;
+
+    // Written by its own thread only; padded so neighbours don't share a line
+    struct alignas(64) ThreadStats {
+        std::atomic<double> busy{0.0};
+        std::atomic<double> spin{0.0};
+        std::atomic<int> tid{0};
+
+        void add(double busy_sec, double spin_sec) {
+            busy.store(busy.load(std::memory_order_relaxed) + busy_sec, std::memory_order_relaxed);
+            spin.store(spin.load(std::memory_order_relaxed) + spin_sec, std::memory_order_relaxed);
+        }
+    };
+
+    void worker(int id) {
+        int seen = 0, local_sense = 0;
+        stats[id].tid.store((int)syscall(SYS_gettid));
+        double t0 = thread_cpu_now();
+        while (true) {
+            seen = wait_for_change(epoch, seen, epoch_sleepers, spin_iters);
+            if (stop) break;
+            double t1 = thread_cpu_now();
+            job(job_arg, id, n);
+            double t2 = thread_cpu_now();
+            // Before arriving: the caller may read or reset the stats as soon as the barrier opens
+            stats[id].add(t2 - t1, t1 - t0);
+            t0 = t2;
+            barrier(local_sense);
+        }
+    }
+
+    void barrier(int& local_sense) {
+        local_sense = 1 - local_sense;
+        if (arrived.fetch_add(1, std::memory_order_acq_rel) == n - 1) {
+            arrived.store(0, std::memory_order_relaxed);
+            publish(sense, local_sense, sense_sleepers);
+        } else {
+            while (sense.load(std::memory_order_acquire) != local_sense) {
+                wait_for_change(sense, 1 - local_sense, sense_sleepers, spin_iters);
+            }
+        }
+    }
+
+    int n;
+    int spin_iters;
+    std::unique_ptr<ThreadStats[]> stats;
+    std::vector<thread_t> threads;
+    void (*job)(void*, int, int) = nullptr;
+    void* job_arg = nullptr;
+    int caller_sense = 0;
+    std::atomic<bool> stop{false};
+
+    // Dispatch and barrier words on their own cache lines
+    alignas(64) std::atomic<int> epoch{0};
+    alignas(64) std::atomic<int> epoch_sleepers{0};
+    alignas(64) std::atomic<int> arrived{0};
+    alignas(64) std::atomic<int> sense{0};
+    alignas(64) std::atomic<int> sense_sleepers{0};
+};
+
+// Process-wide pool with one thread per hardware thread
+inline WorkerPool& default_pool() {
+    static WorkerPool pool((int)std::thread::hardware_concurrency());
+    return pool;
+}
+
+#endif
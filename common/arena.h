@@ -0,0 +1,168 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+/*
+ * Pre-faulted buffer arena for benchmark sweeps.
+ *
+ * The largest working set of the sweep is reserved once. Each size then
+ * takes page-aligned slices, and every slice is faulted in as it is handed
+ * out: pinned threads first-touch it over the same per-thread byte ranges
+ * the kernels will use (arena_alloc_split()), so on a NUMA machine each
+ * thread's share lands on its own node. Pages an earlier size already
+ * touched are dropped with MADV_DONTNEED first, otherwise they would keep
+ * the old size's placement. arena_reset() hands every slice back; the
+ * mapping itself stays, so no size pays for the previous one's munmap and
+ * no timed kernel ever pays for a page fault.
+ *
+ * fault_snapshot() / fault_delta() wrap getrusage() so benchmarks can report
+ * page faults next to, but never inside, their kernel timings.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     // pthread_setaffinity_np; must also come before the first system header
+#endif
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "huge_alloc.h"
+
+typedef struct {
+    long minflt;
+    long majflt;
+} FaultCount;
+
+static inline FaultCount fault_snapshot() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    FaultCount f = {ru.ru_minflt, ru.ru_majflt};
+    return f;
+}
+
+static inline FaultCount fault_delta(FaultCount before, FaultCount after) {
+    FaultCount f = {after.minflt - before.minflt, after.majflt - before.majflt};
+    return f;
+}
+
+typedef struct {
+    HugeAlloc mem;
+    size_t used;
+    size_t faulted;          // Bytes from the start that have been touched at least once
+    int threads;             // Placement: thread t runs on CPU t % ncpu
+    FaultCount prefault;     // Faults taken while pre-faulting, over every slice so far
+    double prefault_sec;
+} Arena;
+
+typedef struct {
+    char *base;
+    size_t begin, end;
+    int cpu;
+} ArenaToucher;
+
+static inline void* arena_touch_worker(void *arg) {
+    ArenaToucher *t = (ArenaToucher*)arg;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(t->cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    huge_touch(t->base + t->begin, t->end - t->begin);
+    return NULL;
+}
+
+static inline size_t arena_round_up(size_t x, size_t page) {
+    return (x + page - 1) / page * page;
+}
+
+/*
+ * Reserves room for `slices` slices of up to `slice_bytes` each, placed by
+ * `threads` pinned threads. Only one page is touched here, to learn which
+ * page size the kernel grants; it is dropped again before the first slice.
+ */
+static inline int arena_init(Arena *a, size_t slice_bytes, int slices, int threads, int want_huge) {
+    memset(a, 0, sizeof(*a));
+    // Slices start on a page boundary of whatever size is granted
+    size_t page = want_huge ? hugetlb_page_size() : (size_t)sysconf(_SC_PAGESIZE);
+    if (want_huge && page < HUGE_PAGE_2MB) page = HUGE_PAGE_2MB;
+    if (huge_reserve(&a->mem, (size_t)slices * arena_round_up(slice_bytes, page), want_huge) != 0) return -1;
+    a->threads = threads < 1 ? 1 : threads;
+
+    size_t probe = a->mem.kind == PAGES_THP ? HUGE_PAGE_2MB : a->mem.page_size;
+    ((volatile char*)a->mem.ptr)[0] = 0;
+    huge_finish(&a->mem);
+    madvise(a->mem.ptr, probe, MADV_DONTNEED);
+    return 0;
+}
+
+/*
+ * Next slice of `bytes`, page aligned, or NULL if the arena is full. Thread t
+ * first-touches bytes [split[t], split[t + 1]) of it (split has threads + 1
+ * entries, split[0] = 0 and split[threads] = bytes); a page goes to the
+ * thread whose range holds its first byte.
+ */
+static inline void* arena_alloc_split(Arena *a, size_t bytes, const size_t *split) {
+    size_t page = a->mem.page_size;
+    size_t start = arena_round_up(a->used, page);
+    if (start + bytes > a->mem.bytes) return NULL;
+    a->used = start + bytes;
+    char *base = (char*)a->mem.ptr + start;
+    size_t len = arena_round_up(bytes, page);
+
+    struct timespec t0, t1;
+    FaultCount before = fault_snapshot();
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    if (start < a->faulted) {
+        size_t stale = a->faulted - start < len ? a->faulted - start : len;
+        madvise(base, stale, MADV_DONTNEED);
+    }
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu < 1) ncpu = 1;
+    pthread_t th[a->threads];
+    ArenaToucher td[a->threads];
+    for (int t = 0; t < a->threads; t++) {
+        td[t].base = base;
+        td[t].begin = t == 0 ? 0 : arena_round_up(split[t], page);
+        td[t].end = t == a->threads - 1 ? len : arena_round_up(split[t + 1], page);
+        if (td[t].end > len) td[t].end = len;
+        if (td[t].begin > td[t].end) td[t].begin = td[t].end;
+        td[t].cpu = (int)(t % ncpu);
+        pthread_create(&th[t], NULL, arena_touch_worker, &td[t]);
+    }
+    for (int t = 0; t < a->threads; t++) pthread_join(th[t], NULL);
+    if (start + len > a->faulted) a->faulted = start + len;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    FaultCount f = fault_delta(before, fault_snapshot());
+    a->prefault.minflt += f.minflt;
+    a->prefault.majflt += f.majflt;
+    a->prefault_sec += (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    return base;
+}
+
+// Rows [rows * t / threads, rows * (t + 1) / threads) to thread t, as a byte split
+static inline void arena_row_split(size_t *split, int rows, size_t row_bytes, int threads) {
+    for (int t = 0; t <= threads; t++) split[t] = (size_t)((long long)rows * t / threads) * row_bytes;
+}
+
+// A slice split evenly by rows across the arena's threads
+static inline void* arena_alloc(Arena *a, int rows, size_t row_bytes) {
+    size_t split[a->threads + 1];
+    arena_row_split(split, rows, row_bytes, a->threads);
+    return arena_alloc_split(a, (size_t)rows * row_bytes, split);
+}
+
+// Returns every slice; the memory stays mapped, and the next slices are placed afresh
+static inline void arena_reset(Arena *a) {
+    a->used = 0;
+}
+
+static inline void arena_destroy(Arena *a) {
+    huge_free(&a->mem);
+    a->used = 0;
+}
+
+#endif
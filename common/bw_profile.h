@@ -0,0 +1,145 @@
+#ifndef BW_PROFILE_H
+#define BW_PROFILE_H
+
+/*
+ * Per-machine memory bandwidth profile.
+ *
+ * Written by Assignment1/Bandwidth/stream.c, loaded by the other benchmarks so
+ * they can report their throughput as a percentage of what the machine can
+ * actually sustain for the same working-set size and thread count.
+ *
+ * File format (CSV, one measurement per line):
+ *   # host=<hostname>
+ *   Level,Bytes,Kernel,Threads,GBps
+ *   L1,32768,triad,1,95.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BW_PROFILE_FILE "bandwidth_profile.csv"
+#define BW_PROFILE_MAX_ROWS 2048
+
+typedef struct {
+    char level[8];      // L1 / L2 / L3 / DRAM
+    char kernel[16];    // copy, scale, add, triad, read, write
+    long long bytes;    // Aggregate working set of the kernel
+    int threads;
+    double gbps;
+} BwEntry;
+
+typedef struct {
+    char host[64];
+    int count;
+    BwEntry rows[BW_PROFILE_MAX_ROWS];
+} BwProfile;
+
+static inline void bw_profile_init(BwProfile *p) {
+    memset(p, 0, sizeof(*p));
+    gethostname(p->host, sizeof(p->host) - 1);
+}
+
+static inline void bw_profile_add(BwProfile *p, const char *level, const char *kernel,
+                                  long long bytes, int threads, double gbps) {
+    if (p->count >= BW_PROFILE_MAX_ROWS) return;
+    BwEntry *e = &p->rows[p->count++];
+    snprintf(e->level, sizeof(e->level), "%s", level);
+    snprintf(e->kernel, sizeof(e->kernel), "%s", kernel);
+    e->bytes = bytes;
+    e->threads = threads;
+    e->gbps = gbps;
+}
+
+static inline int bw_profile_save(const char *path, const BwProfile *p) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) return -1;
+    fprintf(fp, "# host=%s\n", p->host);
+    fprintf(fp, "Level,Bytes,Kernel,Threads,GBps\n");
+    for (int i = 0; i < p->count; i++) {
+        const BwEntry *e = &p->rows[i];
+        fprintf(fp, "%s,%lld,%s,%d,%.3f\n", e->level, e->bytes, e->kernel, e->threads, e->gbps);
+    }
+    fclose(fp);
+    return 0;
+}
+
+// Returns 0 on success, -1 if the file is missing or empty
+static inline int bw_profile_load(const char *path, BwProfile *p) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    memset(p, 0, sizeof(*p));
+
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, "# host=", 7) == 0) {
+            sscanf(line + 7, "%63s", p->host);
+            continue;
+        }
+        if (line[0] == '#' || strncmp(line, "Level,", 6) == 0) continue;
+
+        BwEntry e;
+        if (sscanf(line, "%7[^,],%lld,%15[^,],%d,%lf",
+                   e.level, &e.bytes, e.kernel, &e.threads, &e.gbps) == 5 &&
+            p->count < BW_PROFILE_MAX_ROWS) {
+            p->rows[p->count++] = e;
+        }
+    }
+    fclose(fp);
+    return p->count > 0 ? 0 : -1;
+}
+
+// Looks in $BW_PROFILE first, then the usual places relative to a benchmark directory
+static inline int bw_profile_load_default(BwProfile *p) {
+    const char *candidates[] = {
+        getenv("BW_PROFILE"),
+        BW_PROFILE_FILE,
+        "../Bandwidth/" BW_PROFILE_FILE,
+        "../Assignment1/Bandwidth/" BW_PROFILE_FILE,
+    };
+    for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
+        if (candidates[i] && bw_profile_load(candidates[i], p) == 0) {
+            char host[64] = {0};
+            gethostname(host, sizeof(host) - 1);
+            if (strcmp(host, p->host) != 0)
+                fprintf(stderr, "Warning: bandwidth profile '%s' was measured on '%s', not '%s'\n",
+                        candidates[i], p->host, host);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Achievable GB/s for a kernel over `bytes` of working set with `threads`
+ * threads: the smallest measured working set that is >= bytes (or the largest
+ * one), at the largest measured thread count <= threads. Returns 0.0 if the
+ * profile has nothing for this kernel.
+ */
+static inline double bw_profile_peak(const BwProfile *p, const char *kernel,
+                                     long long bytes, int threads) {
+    long long best_bytes = -1, max_bytes = -1;
+    for (int i = 0; i < p->count; i++) {
+        const BwEntry *e = &p->rows[i];
+        if (strcmp(e->kernel, kernel) != 0) continue;
+        if (e->bytes > max_bytes) max_bytes = e->bytes;
+        if (e->bytes >= bytes && (best_bytes < 0 || e->bytes < best_bytes)) best_bytes = e->bytes;
+    }
+    if (best_bytes < 0) best_bytes = max_bytes;
+    if (best_bytes < 0) return 0.0;
+
+    int best_threads = 0;
+    double gbps = 0.0;
+    for (int i = 0; i < p->count; i++) {
+        const BwEntry *e = &p->rows[i];
+        if (strcmp(e->kernel, kernel) != 0 || e->bytes != best_bytes) continue;
+        if (e->threads <= threads && e->threads >= best_threads) {
+            best_threads = e->threads;
+            gbps = e->gbps;
+        }
+    }
+    return gbps;
+}
+
+#endif
@@ -0,0 +1,322 @@
+#ifndef COUNTER_RNG_H
+#define COUNTER_RNG_H
+
+/*
+ * Counter-based random numbers for benchmark inputs.
+ *
+ * Draw number i of a stream is rng_hash(key, i), a splitmix64 finalizer of
+ * key + i * golden ratio: a pure function with no state, so any thread can
+ * produce any element and an array comes out identical for every thread
+ * count and split. Independent streams of one seed use different keys,
+ * rng_key(seed, stream).
+ *
+ * The fill routines write out[i] from draw first + i:
+ *   rng_fill_int32()  - uniform integers in [lo, hi] (multiply-shift, no modulo)
+ *   rng_fill_int64()  - same for 64-bit ranges
+ *   rng_fill_double() / rng_fill_float() - uniform in [lo, hi) (a float may
+ *                       round up to hi)
+ *   rng_fill_normal() - Box-Muller: elements 2p and 2p+1 are the cos / sin
+ *                       pair of draws 2p and 2p+1
+ * They split [0, n) into contiguous pieces over `threads` pthreads (the
+ * writer of a page is also its first toucher). With AVX2, four 64-bit
+ * counters are hashed per step, the 64-bit multiplies assembled from
+ * _mm256_mul_epu32; a ragged end goes through the same vector code into a
+ * scratch register, so no element's value depends on where a split falls.
+ *
+ * Uniform floating point values take the top 52 bits of a draw as the
+ * mantissa of a double in [1, 2), which needs no 64-bit int -> double
+ * conversion (AVX2 has none).
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#define RNG_GOLDEN 0x9E3779B97F4A7C15ULL
+#define RNG_MUL1   0xBF58476D1CE4E5B9ULL
+#define RNG_MUL2   0x94D049BB133111EBULL
+#define RNG_MAX_THREADS 256
+
+static inline uint64_t rng_hash(uint64_t key, uint64_t counter) {
+    uint64_t z = key + counter * RNG_GOLDEN;
+    z = (z ^ (z >> 30)) * RNG_MUL1;
+    z = (z ^ (z >> 27)) * RNG_MUL2;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rng_key(uint64_t seed, uint64_t stream) {
+    return rng_hash(seed, stream);
+}
+
+// [0, 1) with 53 random bits, for single draws
+static inline double rng_uniform(uint64_t key, uint64_t counter) {
+    return (rng_hash(key, counter) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// [0, 1) with 52 random bits: the fill routines' mapping
+static inline double rng_unit(uint64_t h) {
+    union { uint64_t u; double d; } bits;
+    bits.u = (h >> 12) | 0x3FF0000000000000ULL;
+    return bits.d - 1.0;
+}
+
+// lo + floor(u * span) for the high 32 bits u of a draw; span = 2^32 is the full range
+static inline int32_t rng_int32_of(uint64_t h, int32_t lo, uint64_t span) {
+    uint64_t hi32 = h >> 32;
+    return (int32_t)(uint32_t)((uint32_t)lo + (span > 0xFFFFFFFFULL ? hi32 : (hi32 * span) >> 32));
+}
+
+#if defined(__AVX2__)
+// Low 64 bits of a * b per lane: lo*lo + ((hi*lo + lo*hi) << 32)
+static inline __m256i rng_mul64_avx2(__m256i a, __m256i b) {
+    __m256i lo = _mm256_mul_epu32(a, b);
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                     _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+// rng_hash() of four lanes whose z = key + counter * RNG_GOLDEN is already formed
+static inline __m256i rng_mix_avx2(__m256i z) {
+    const __m256i m1 = _mm256_set1_epi64x((long long)RNG_MUL1), m2 = _mm256_set1_epi64x((long long)RNG_MUL2);
+    z = rng_mul64_avx2(_mm256_xor_si256(z, _mm256_srli_epi64(z, 30)), m1);
+    z = rng_mul64_avx2(_mm256_xor_si256(z, _mm256_srli_epi64(z, 27)), m2);
+    return _mm256_xor_si256(z, _mm256_srli_epi64(z, 31));
+}
+
+// z of counters c, c + stride, c + 2 * stride, c + 3 * stride
+static inline __m256i rng_start_avx2(uint64_t key, uint64_t c, uint64_t stride) {
+    return _mm256_set_epi64x((long long)(key + (c + 3 * stride) * RNG_GOLDEN), (long long)(key + (c + 2 * stride) * RNG_GOLDEN),
+                             (long long)(key + (c + stride) * RNG_GOLDEN), (long long)(key + c * RNG_GOLDEN));
+}
+
+static inline __m256d rng_unit_avx2(__m256i h) {
+    __m256i bits = _mm256_or_si256(_mm256_srli_epi64(h, 12), _mm256_set1_epi64x(0x3FF0000000000000LL));
+    return _mm256_sub_pd(_mm256_castsi256_pd(bits), _mm256_set1_pd(1.0));
+}
+#endif
+
+static inline void rng_int32_range(int32_t *out, size_t begin, size_t end, uint64_t key, uint64_t first,
+                                   int32_t lo, uint64_t span) {
+    size_t i = begin;
+#if defined(__AVX2__)
+    if (span <= 0xFFFFFFFFULL) {
+        // Even counters in the low halves of the lanes, odd ones shifted into the high halves
+        __m256i z_even = rng_start_avx2(key, first + i, 2), z_odd = rng_start_avx2(key, first + i + 1, 2);
+        const __m256i step = _mm256_set1_epi64x((long long)(8 * RNG_GOLDEN));
+        const __m256i vspan = _mm256_set1_epi64x((long long)span), vlo = _mm256_set1_epi32(lo);
+        for (; i < end; i += 8) {
+            __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(rng_mix_avx2(z_even), 32), vspan), 32);
+            __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(rng_mix_avx2(z_odd), 32), vspan);
+            __m256i v = _mm256_add_epi32(_mm256_blend_epi32(even, odd, 0xAA), vlo);
+            if (i + 8 <= end) {
+                _mm256_storeu_si256((__m256i*)(out + i), v);
+            } else {
+                int32_t tail[8];
+                _mm256_storeu_si256((__m256i*)tail, v);
+                memcpy(out + i, tail, (end - i) * sizeof(int32_t));
+            }
+            z_even = _mm256_add_epi64(z_even, step);
+            z_odd = _mm256_add_epi64(z_odd, step);
+        }
+        return;
+    }
+#endif
+    for (; i < end; i++) out[i] = rng_int32_of(rng_hash(key, first + i), lo, span);
+}
+
+static inline void rng_int64_range(int64_t *out, size_t begin, size_t end, uint64_t key, uint64_t first,
+                                   int64_t lo, uint64_t span) {
+    for (size_t i = begin; i < end; i++) {
+        uint64_t h = rng_hash(key, first + i);
+        uint64_t off = span == 0 ? h : (uint64_t)(((unsigned __int128)h * span) >> 64);    // span 0: full range
+        out[i] = (int64_t)((uint64_t)lo + off);
+    }
+}
+
+static inline void rng_double_range(double *out, size_t begin, size_t end, uint64_t key, uint64_t first,
+                                    double lo, double width) {
+    size_t i = begin;
+#if defined(__AVX2__)
+    __m256i z = rng_start_avx2(key, first + i, 1);
+    const __m256i step = _mm256_set1_epi64x((long long)(4 * RNG_GOLDEN));
+    const __m256d vlo = _mm256_set1_pd(lo), vwidth = _mm256_set1_pd(width);
+    for (; i < end; i += 4) {
+        __m256d v = _mm256_add_pd(vlo, _mm256_mul_pd(rng_unit_avx2(rng_mix_avx2(z)), vwidth));
+        if (i + 4 <= end) {
+            _mm256_storeu_pd(out + i, v);
+        } else {
+            double tail[4];
+            _mm256_storeu_pd(tail, v);
+            memcpy(out + i, tail, (end - i) * sizeof(double));
+        }
+        z = _mm256_add_epi64(z, step);
+    }
+#else
+    for (; i < end; i++) out[i] = lo + rng_unit(rng_hash(key, first + i)) * width;
+#endif
+}
+
+static inline void rng_float_range(float *out, size_t begin, size_t end, uint64_t key, uint64_t first,
+                                   double lo, double width) {
+    size_t i = begin;
+#if defined(__AVX2__)
+    __m256i z = rng_start_avx2(key, first + i, 1);
+    const __m256i step = _mm256_set1_epi64x((long long)(4 * RNG_GOLDEN));
+    const __m256d vlo = _mm256_set1_pd(lo), vwidth = _mm256_set1_pd(width);
+    for (; i < end; i += 4) {
+        __m128 v = _mm256_cvtpd_ps(_mm256_add_pd(vlo, _mm256_mul_pd(rng_unit_avx2(rng_mix_avx2(z)), vwidth)));
+        if (i + 4 <= end) {
+            _mm_storeu_ps(out + i, v);
+        } else {
+            float tail[4];
+            _mm_storeu_ps(tail, v);
+            memcpy(out + i, tail, (end - i) * sizeof(float));
+        }
+        z = _mm256_add_epi64(z, step);
+    }
+#else
+    for (; i < end; i++) out[i] = (float)(lo + rng_unit(rng_hash(key, first + i)) * width);
+#endif
+}
+
+// Element e of the stream is the cos (e even) or sin (e odd) half of Box-Muller
+// pair e / 2; a piece starting or ending mid-pair computes that pair alone.
+// log / sincos stay in libm, so this is the one fill that is not vectorised
+static inline void rng_normal_pair(uint64_t key, uint64_t pair, double *z0, double *z1) {
+    double u1 = 1.0 - rng_unit(rng_hash(key, 2 * pair));      // (0, 1]: log(u1) is finite
+    double u2 = rng_unit(rng_hash(key, 2 * pair + 1));
+    double r = sqrt(-2.0 * log(u1));
+    *z0 = r * cos(2.0 * M_PI * u2);
+    *z1 = r * sin(2.0 * M_PI * u2);
+}
+
+static inline void rng_normal_range(double *out, size_t begin, size_t end, uint64_t key, uint64_t first,
+                                    double mean, double stddev) {
+    double z0, z1;
+    size_t i = begin;
+    if (i < end && (first + i) % 2 == 1) {
+        rng_normal_pair(key, (first + i) / 2, &z0, &z1);
+        out[i++] = mean + stddev * z1;
+    }
+    for (; i + 2 <= end; i += 2) {
+        rng_normal_pair(key, (first + i) / 2, &z0, &z1);
+        out[i] = mean + stddev * z0;
+        out[i + 1] = mean + stddev * z1;
+    }
+    if (i < end) {
+        rng_normal_pair(key, (first + i) / 2, &z0, &z1);
+        out[i] = mean + stddev * z0;
+    }
+}
+
+// --- Threaded fills ---
+
+typedef enum { RNG_INT32 = 0, RNG_INT64, RNG_DOUBLE, RNG_FLOAT, RNG_NORMAL } RngKind;
+
+typedef struct {
+    RngKind kind;
+    void *out;
+    size_t n;
+    uint64_t key, first;
+    int64_t ilo;            // RNG_INT32 / RNG_INT64: lo and span
+    uint64_t span;
+    double a, b;            // RNG_DOUBLE / RNG_FLOAT: lo, width; RNG_NORMAL: mean, stddev
+    int thread_id, num_threads;
+} RngJob;
+
+static inline void rng_run(const RngJob *j) {
+    size_t begin = j->n / j->num_threads * j->thread_id, end = j->n / j->num_threads * (j->thread_id + 1);
+    if (j->thread_id == j->num_threads - 1) end = j->n;
+    switch (j->kind) {
+    case RNG_INT32:  rng_int32_range((int32_t*)j->out, begin, end, j->key, j->first, (int32_t)j->ilo, j->span); break;
+    case RNG_INT64:  rng_int64_range((int64_t*)j->out, begin, end, j->key, j->first, j->ilo, j->span); break;
+    case RNG_DOUBLE: rng_double_range((double*)j->out, begin, end, j->key, j->first, j->a, j->b); break;
+    case RNG_FLOAT:  rng_float_range((float*)j->out, begin, end, j->key, j->first, j->a, j->b); break;
+    default:         rng_normal_range((double*)j->out, begin, end, j->key, j->first, j->a, j->b); break;
+    }
+}
+
+static inline void* rng_worker(void *arg) {
+    rng_run((const RngJob*)arg);
+    return NULL;
+}
+
+// Runs `proto` on `threads` threads (the caller is thread 0); below 64K elements one thread does it all
+static inline void rng_parallel(const RngJob *proto, int threads) {
+    if (threads < 1 || proto->n < (1 << 16)) threads = 1;
+    if (threads > RNG_MAX_THREADS) threads = RNG_MAX_THREADS;
+    RngJob jobs[RNG_MAX_THREADS];
+    pthread_t handles[RNG_MAX_THREADS];
+    int started[RNG_MAX_THREADS];
+    for (int t = 0; t < threads; t++) {
+        jobs[t] = *proto;
+        jobs[t].thread_id = t;
+        jobs[t].num_threads = threads;
+        started[t] = t > 0 && pthread_create(&handles[t], NULL, rng_worker, &jobs[t]) == 0;
+    }
+    for (int t = 0; t < threads; t++) {
+        if (!started[t]) rng_run(&jobs[t]);     // Thread 0, or a failed create
+    }
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) pthread_join(handles[t], NULL);
+    }
+}
+
+static inline RngJob rng_job(RngKind kind, void *out, size_t n, uint64_t key, uint64_t first) {
+    RngJob j;
+    j.kind = kind;
+    j.out = out;
+    j.n = n;
+    j.key = key;
+    j.first = first;
+    j.ilo = 0;
+    j.span = 0;
+    j.a = j.b = 0.0;
+    j.thread_id = 0;
+    j.num_threads = 1;
+    return j;
+}
+
+// out[i] uniform in [lo, hi] from draw first + i
+static inline void rng_fill_int32(int32_t *out, size_t n, uint64_t key, uint64_t first, int32_t lo, int32_t hi, int threads) {
+    RngJob j = rng_job(RNG_INT32, out, n, key, first);
+    j.ilo = lo;
+    j.span = (uint64_t)((int64_t)hi - lo) + 1;
+    rng_parallel(&j, threads);
+}
+
+static inline void rng_fill_int64(int64_t *out, size_t n, uint64_t key, uint64_t first, int64_t lo, int64_t hi, int threads) {
+    RngJob j = rng_job(RNG_INT64, out, n, key, first);
+    j.ilo = lo;
+    j.span = (uint64_t)hi - (uint64_t)lo + 1;   // Wraps to 0 for the full 64-bit range
+    rng_parallel(&j, threads);
+}
+
+// out[i] uniform in [lo, hi)
+static inline void rng_fill_double(double *out, size_t n, uint64_t key, uint64_t first, double lo, double hi, int threads) {
+    RngJob j = rng_job(RNG_DOUBLE, out, n, key, first);
+    j.a = lo;
+    j.b = hi - lo;
+    rng_parallel(&j, threads);
+}
+
+static inline void rng_fill_float(float *out, size_t n, uint64_t key, uint64_t first, double lo, double hi, int threads) {
+    RngJob j = rng_job(RNG_FLOAT, out, n, key, first);
+    j.a = lo;
+    j.b = hi - lo;
+    rng_parallel(&j, threads);
+}
+
+static inline void rng_fill_normal(double *out, size_t n, uint64_t key, uint64_t first, double mean, double stddev, int threads) {
+    RngJob j = rng_job(RNG_NORMAL, out, n, key, first);
+    j.a = mean;
+    j.b = stddev;
+    rng_parallel(&j, threads);
+}
+
+#endif
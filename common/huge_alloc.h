@@ -0,0 +1,165 @@
+#ifndef HUGE_ALLOC_H
+#define HUGE_ALLOC_H
+
+/*
+ * Matrix allocation on huge pages, with a clean fallback.
+ *
+ *   1. mmap(MAP_HUGETLB)             - explicit hugetlbfs pages (needs vm.nr_hugepages)
+ *   2. mmap + madvise(MADV_HUGEPAGE) - transparent huge pages, 2 MB aligned
+ *   3. plain 4 KB pages
+ *
+ * With want_huge == 0 the buffer is marked MADV_NOHUGEPAGE, so the baseline
+ * really is on 4 KB pages even when THP is set to "always".
+ *
+ * THP is only granted at fault time, so huge_alloc() touches the buffer and
+ * then reads /proc/self/smaps to report the page size actually obtained.
+ * huge_reserve() / huge_finish() split that up for callers that fault the
+ * pages in themselves.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define HUGE_PAGE_2MB (2UL << 20)
+
+typedef enum {
+    PAGES_DEFAULT = 0,   // 4 KB pages
+    PAGES_THP,           // Transparent huge pages (madvise)
+    PAGES_HUGETLB        // Explicit MAP_HUGETLB
+} PageKind;
+
+typedef struct {
+    void *ptr;           // Aligned start handed to the caller
+    size_t bytes;        // Requested size
+    void *map;           // What has to be munmap()ed
+    size_t map_bytes;
+    size_t page_size;    // Page size actually obtained
+    PageKind kind;
+} HugeAlloc;
+
+static inline const char* page_kind_name(PageKind kind) {
+    switch (kind) {
+    case PAGES_HUGETLB: return "hugetlb";
+    case PAGES_THP:     return "thp";
+    default:            return "4k";
+    }
+}
+
+static inline size_t hugetlb_page_size() {
+    FILE *fp = fopen("/proc/meminfo", "r");
+    size_t kb = 0;
+    char line[128];
+    while (fp && fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "Hugepagesize: %zu kB", &kb) == 1) break;
+    }
+    if (fp) fclose(fp);
+    return kb ? kb * 1024 : HUGE_PAGE_2MB;
+}
+
+// kB of the mapping containing `addr` that is backed by transparent huge pages
+static inline size_t smaps_anon_huge_kb(void *addr) {
+    FILE *fp = fopen("/proc/self/smaps", "r");
+    if (!fp) return 0;
+    char line[256];
+    int in_region = 0;
+    size_t kb = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned long start, end;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            in_region = ((uintptr_t)addr >= start && (uintptr_t)addr < end);
+            continue;
+        }
+        size_t v;
+        if (in_region && sscanf(line, "AnonHugePages: %zu kB", &v) == 1) {
+            kb = v;
+            break;
+        }
+    }
+    fclose(fp);
+    return kb;
+}
+
+static inline void huge_touch(void *ptr, size_t bytes) {
+    long page = sysconf(_SC_PAGESIZE);
+    for (size_t off = 0; off < bytes; off += (size_t)page) ((volatile char*)ptr)[off] = 0;
+}
+
+/*
+ * Maps the buffer without touching it. The page kind is provisional until
+ * huge_finish() has looked at what the kernel actually handed out, so
+ * callers that want to control first touch (see arena.h) fault the pages in
+ * between. Returns 0 on success, -1 if not even 4 KB pages could be mapped.
+ */
+static inline int huge_reserve(HugeAlloc *h, size_t bytes, int want_huge) {
+    memset(h, 0, sizeof(*h));
+    h->bytes = bytes;
+    h->page_size = (size_t)sysconf(_SC_PAGESIZE);
+    h->kind = PAGES_DEFAULT;
+
+    if (want_huge) {
+        // 1. Explicit huge pages
+        size_t hp = hugetlb_page_size();
+        size_t len = (bytes + hp - 1) / hp * hp;
+        void *p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            h->ptr = h->map = p;
+            h->map_bytes = len;
+            h->page_size = hp;
+            h->kind = PAGES_HUGETLB;
+            return 0;
+        }
+
+        // 2. THP: over-map by 2 MB so the start can be 2 MB aligned
+        len = (bytes + HUGE_PAGE_2MB - 1) / HUGE_PAGE_2MB * HUGE_PAGE_2MB + HUGE_PAGE_2MB;
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p != MAP_FAILED) {
+            uintptr_t aligned = ((uintptr_t)p + HUGE_PAGE_2MB - 1) & ~(uintptr_t)(HUGE_PAGE_2MB - 1);
+            h->map = p;
+            h->map_bytes = len;
+            h->ptr = (void*)aligned;
+            if (madvise(h->ptr, bytes, MADV_HUGEPAGE) == 0) h->kind = PAGES_THP;
+            return 0;
+        }
+    }
+
+    // 3. Plain 4 KB pages
+    size_t len = (bytes + h->page_size - 1) / h->page_size * h->page_size;
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return -1;
+#ifdef MADV_NOHUGEPAGE
+    madvise(p, len, MADV_NOHUGEPAGE);
+#endif
+    h->ptr = h->map = p;
+    h->map_bytes = len;
+    return 0;
+}
+
+// After the pages have been touched: downgrade a THP request that was not honoured
+static inline void huge_finish(HugeAlloc *h) {
+    if (h->kind == PAGES_THP) {
+        if (smaps_anon_huge_kb(h->ptr) > 0) {
+            h->page_size = HUGE_PAGE_2MB;
+        } else {
+            h->kind = PAGES_DEFAULT;
+        }
+    }
+}
+
+// Reserve, fault in from the calling thread, and report the page size obtained
+static inline int huge_alloc(HugeAlloc *h, size_t bytes, int want_huge) {
+    if (huge_reserve(h, bytes, want_huge) != 0) return -1;
+    huge_touch(h->ptr, bytes);
+    huge_finish(h);
+    return 0;
+}
+
+static inline void huge_free(HugeAlloc *h) {
+    if (h->map) munmap(h->map, h->map_bytes);
+    memset(h, 0, sizeof(*h));
+}
+
+#endif
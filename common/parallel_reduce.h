@@ -0,0 +1,391 @@
+#ifndef PARALLEL_REDUCE_H
+#define PARALLEL_REDUCE_H
+
+/*
+ * Generic pthread reduction: parallel_reduce<T, Op>(data, n, threads).
+ *
+ * The range is split into `threads` contiguous, balanced chunks; each thread
+ * folds its chunk into a private accumulator and publishes it once, to its
+ * own 64-byte slot, so no two threads ever write the same cache line.
+ *
+ * Combining (ReduceCombine):
+ *   REDUCE_TREE   - join tree: in round k, thread id (with bit k clear) joins
+ *                   thread id + 2^k and folds its slot into its own, so the
+ *                   caller ends up with the result after log2(threads) levels
+ *                   instead of joining and combining every thread itself
+ *   REDUCE_LOCKED - every thread folds into one shared result under a mutex
+ *                   (the classic "global sum" baseline), in whatever order
+ *                   the threads take the lock
+ *
+ * An Op is a type with
+ *   typedef ... result_type;
+ *   static result_type identity();
+ *   static void accumulate(result_type&, T);          // one element
+ *   static void combine(result_type&, const result_type&);   // left <- right
+ * REDUCE_TREE combines chunks in index order, so there Op need only be
+ * associative; REDUCE_LOCKED requires a commutative Op as well.
+ *
+ * Fused<Op1, Op2, ...> runs several Ops in the same pass over the data
+ * (e.g. Fused<MinOp<int>, MaxOp<int>, SumOp<long long>>); its result is a
+ * std::tuple, and everything is resolved at compile time.
+ *
+ * parallel_reduce_chunks<Op>(n, threads, chunk) is the lower level: chunk(begin,
+ * end) returns the Op result of [begin, end), for loops the element-wise
+ * version can't express. The calling thread is thread 0.
+ *
+ * Adaptive team size: creating and joining threads costs tens of
+ * microseconds, so small inputs are faster on one thread. ReduceCrossover
+ * holds, per team size, the input size (bytes) from which that team beats
+ * every smaller one on this machine, and parallel_reduce_adaptive() picks the
+ * sequential (vectorised) fold, a small team or all max_threads. The crossover
+ * is measured once per host and max_threads, on a min+max pass over ints, and
+ * kept in reduce_crossover.csv:
+ *   # host=<hostname>
+ *   MaxThreads,Threads,Bytes
+ *   8,1,0
+ *   8,2,524288
+ */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#define REDUCE_CROSSOVER_FILE "reduce_crossover.csv"
+#define REDUCE_CROSSOVER_MAX_BYTES (64 << 20)   // Largest calibration input
+#define REDUCE_CROSSOVER_MARGIN 0.95            // A bigger team must be 5% faster to take over
+
+enum ReduceCombine { REDUCE_TREE, REDUCE_LOCKED };
+
+template <typename Acc>
+struct SumOp {
+    typedef Acc result_type;
+    static Acc identity() { return Acc(); }
+    template <typename T> static void accumulate(Acc& acc, T x) { acc += x; }
+    static void combine(Acc& acc, const Acc& other) { acc += other; }
+};
+
+template <typename T>
+struct MinOp {
+    typedef T result_type;
+    static T identity() { return std::numeric_limits<T>::max(); }
+    static void accumulate(T& acc, T x) { acc = x < acc ? x : acc; }
+    static void combine(T& acc, const T& other) { accumulate(acc, other); }
+};
+
+template <typename T>
+struct MaxOp {
+    typedef T result_type;
+    static T identity() { return std::numeric_limits<T>::lowest(); }
+    static void accumulate(T& acc, T x) { acc = x > acc ? x : acc; }
+    static void combine(T& acc, const T& other) { accumulate(acc, other); }
+};
+
+template <typename... Ops>
+struct Fused {
+    typedef std::tuple<typename Ops::result_type...> result_type;
+
+    static result_type identity() { return result_type(Ops::identity()...); }
+
+    template <typename T>
+    static void accumulate(result_type& acc, T x) { accumulate_each(acc, x, std::index_sequence_for<Ops...>()); }
+
+    static void combine(result_type& acc, const result_type& other) { combine_each(acc, other, std::index_sequence_for<Ops...>()); }
+
+private:
+    template <typename T, size_t... I>
+    static void accumulate_each(result_type& acc, T x, std::index_sequence<I...>) {
+        (Ops::accumulate(std::get<I>(acc), x), ...);
+    }
+
+    template <size_t... I>
+    static void combine_each(result_type& acc, const result_type& other, std::index_sequence<I...>) {
+        (Ops::combine(std::get<I>(acc), std::get<I>(other)), ...);
+    }
+};
+
+// Balanced split: chunk sizes differ by at most one element
+inline void reduce_chunk_bounds(size_t n, int id, int threads, size_t* begin, size_t* end) {
+    *begin = n / threads * id + (id < (int)(n % threads) ? id : n % threads);
+    *end = *begin + n / threads + (id < (int)(n % threads) ? 1 : 0);
+}
+
+template <typename Op, typename ChunkFn>
+struct ReduceJob {
+    // One result per thread, each on its own cache line(s)
+    struct alignas(64) Slot {
+        typename Op::result_type value;
+    };
+    struct Arg {
+        ReduceJob* job;
+        int id;
+    };
+
+    size_t n;
+    int threads;
+    const ChunkFn* chunk;
+    ReduceCombine combine;
+    std::vector<pthread_t> handles;
+    std::vector<char> started;
+    std::vector<Slot> slots;
+    std::vector<Arg> args;
+    pthread_mutex_t lock;
+    typename Op::result_type shared;
+
+    void body(int id) {
+        size_t begin, end;
+        reduce_chunk_bounds(n, id, threads, &begin, &end);
+        typename Op::result_type local = (*chunk)(begin, end);
+        if (combine == REDUCE_LOCKED) {
+            pthread_mutex_lock(&lock);
+            Op::combine(shared, local);
+            pthread_mutex_unlock(&lock);
+            return;
+        }
+        // Partners are id + 1, id + 2, id + 4, ... up to the lowest set bit of id
+        for (int stride = 1; stride < threads && !(id & stride); stride <<= 1) {
+            int partner = id + stride;
+            if (partner >= threads) break;
+            if (started[partner]) pthread_join(handles[partner], NULL);
+            else body(partner);     // pthread_create failed: run that subtree here
+            Op::combine(local, slots[partner].value);
+        }
+        slots[id].value = local;
+    }
+
+    static void* thread_main(void* arg) {
+        Arg* a = (Arg*)arg;
+        a->job->body(a->id);
+        return NULL;
+    }
+};
+
+template <typename Op, typename ChunkFn>
+typename Op::result_type parallel_reduce_chunks(size_t n, int threads, const ChunkFn& chunk,
+                                                ReduceCombine combine = REDUCE_TREE) {
+    if (threads < 1) threads = 1;
+    ReduceJob<Op, ChunkFn> job;
+    job.n = n;
+    job.threads = threads;
+    job.chunk = &chunk;
+    job.combine = combine;
+    job.handles.resize(threads);
+    job.started.assign(threads, 0);
+    job.slots.resize(threads);
+    job.args.resize(threads);
+    job.shared = Op::identity();
+    pthread_mutex_init(&job.lock, NULL);
+
+    // Highest id first, so a thread's tree partners exist before it starts
+    for (int id = threads - 1; id >= 1; id--) {
+        job.args[id].job = &job;
+        job.args[id].id = id;
+        job.started[id] = pthread_create(&job.handles[id], NULL, ReduceJob<Op, ChunkFn>::thread_main, &job.args[id]) == 0;
+    }
+    job.body(0);
+
+    typename Op::result_type result;
+    if (combine == REDUCE_LOCKED) {
+        for (int id = 1; id < threads; id++) {
+            if (job.started[id]) pthread_join(job.handles[id], NULL);
+            else job.body(id);
+        }
+        result = job.shared;
+    } else {
+        result = job.slots[0].value;
+    }
+    pthread_mutex_destroy(&job.lock);
+    return result;
+}
+
+// Folds data[begin, end) on the calling thread. The accumulator is a local that
+// is stored once at the end: folding straight into a returned value keeps it
+// in memory and stops the loop from being vectorised
+template <typename T, typename Op>
+void reduce_fold(const T* data, size_t begin, size_t end, typename Op::result_type* out) {
+    typename Op::result_type acc = Op::identity();
+    for (size_t i = begin; i < end; i++) Op::accumulate(acc, data[i]);
+    *out = acc;
+}
+
+template <typename T, typename Op>
+typename Op::result_type reduce_sequential(const T* data, size_t n) {
+    typename Op::result_type result;
+    reduce_fold<T, Op>(data, 0, n, &result);
+    return result;
+}
+
+template <typename T, typename Op>
+typename Op::result_type parallel_reduce(const T* data, size_t n, int threads, ReduceCombine combine = REDUCE_TREE) {
+    auto chunk = [data](size_t begin, size_t end) {
+        typename Op::result_type result;
+        reduce_fold<T, Op>(data, begin, end, &result);
+        return result;
+    };
+    return parallel_reduce_chunks<Op>(n, threads, chunk, combine);
+}
+
+// --- Adaptive team size ---
+
+struct ReduceCrossover {
+    int max_threads = 1;
+    std::vector<int> teams;         // Ascending; teams[0] == 1
+    std::vector<size_t> from_bytes; // teams[k] is used from this input size on
+
+    int team_for(size_t bytes) const {
+        int team = 1;
+        for (size_t k = 0; k < teams.size(); k++) {
+            if (bytes >= from_bytes[k] && teams[k] > team) team = teams[k];
+        }
+        return team;
+    }
+};
+
+inline double reduce_now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Best of at least 3 runs and 2 ms of samples
+template <typename F>
+double reduce_best_time(F f) {
+    double best = 1e30, total = 0.0;
+    for (int run = 0; run < 3 || (total < 2e-3 && run < 10000); run++) {
+        double t0 = reduce_now();
+        f();
+        double dt = reduce_now() - t0;
+        if (dt < best) best = dt;
+        total += dt;
+    }
+    return best;
+}
+
+// Times the sequential fold and teams 2, 4, ... max_threads on 1 KB .. 64 MB of ints
+inline ReduceCrossover reduce_crossover_calibrate(int max_threads) {
+    typedef Fused<MinOp<int>, MaxOp<int>> MinMax;
+    ReduceCrossover c;
+    c.max_threads = max_threads < 1 ? 1 : max_threads;
+    std::vector<int> candidates(1, 1);
+    for (int t = 2; t < c.max_threads; t *= 2) candidates.push_back(t);
+    if (c.max_threads > 1) candidates.push_back(c.max_threads);
+
+    size_t max_n = REDUCE_CROSSOVER_MAX_BYTES / sizeof(int);
+    std::vector<int> data(max_n);
+    for (size_t i = 0; i < max_n; i++) data[i] = (int)(uint32_t)(i * 2654435761u);
+    std::vector<size_t> sizes;
+    for (size_t n = 1024 / sizeof(int); n <= max_n; n *= 2) sizes.push_back(n);
+
+    // Fastest candidate per size; a bigger team has to win by the margin
+    std::vector<int> winner(sizes.size());
+    volatile int sink = 0;
+    for (size_t s = 0; s < sizes.size(); s++) {
+        size_t n = sizes[s];
+        double best = reduce_best_time([&] { sink = std::get<0>(reduce_sequential<int, MinMax>(data.data(), n)); });
+        winner[s] = 1;
+        for (size_t k = 1; k < candidates.size(); k++) {
+            int team = candidates[k];
+            double t = reduce_best_time([&] { sink = std::get<0>(parallel_reduce<int, MinMax>(data.data(), n, team)); });
+            if (t < best * REDUCE_CROSSOVER_MARGIN) {
+                best = t;
+                winner[s] = team;
+            }
+        }
+    }
+    (void)sink;
+
+    // A team takes over from the smallest size after which it (or a bigger one) always won
+    c.teams.push_back(1);
+    c.from_bytes.push_back(0);
+    for (size_t k = 1; k < candidates.size(); k++) {
+        size_t from = 0;
+        for (size_t s = sizes.size(); s-- > 0 && winner[s] >= candidates[k];) from = sizes[s] * sizeof(int);
+        if (from > 0) {
+            c.teams.push_back(candidates[k]);
+            c.from_bytes.push_back(from);
+        }
+    }
+    return c;
+}
+
+// Rows of every max_threads in the file, this host's only; returns false if missing
+inline bool reduce_crossover_read(const char* path, std::vector<ReduceCrossover>& all) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return false;
+    char host[64] = {0}, file_host[64] = {0};
+    gethostname(host, sizeof(host) - 1);
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, "# host=", 7) == 0) {
+            sscanf(line + 7, "%63s", file_host);
+            continue;
+        }
+        int max_threads, team;
+        long long bytes;
+        if (sscanf(line, "%d,%d,%lld", &max_threads, &team, &bytes) != 3) continue;
+        size_t k = 0;
+        while (k < all.size() && all[k].max_threads != max_threads) k++;
+        if (k == all.size()) {
+            all.push_back(ReduceCrossover());
+            all[k].max_threads = max_threads;
+        }
+        all[k].teams.push_back(team);
+        all[k].from_bytes.push_back((size_t)bytes);
+    }
+    fclose(fp);
+    if (strcmp(host, file_host) != 0) {
+        if (!all.empty()) fprintf(stderr, "Ignoring %s: measured on '%s', not '%s'\n", path, file_host, host);
+        all.clear();
+    }
+    return true;
+}
+
+inline int reduce_crossover_save(const char* path, const std::vector<ReduceCrossover>& all) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) return -1;
+    char host[64] = {0};
+    gethostname(host, sizeof(host) - 1);
+    fprintf(fp, "# host=%s\n", host);
+    fprintf(fp, "MaxThreads,Threads,Bytes\n");
+    for (const ReduceCrossover& c : all) {
+        for (size_t k = 0; k < c.teams.size(); k++) fprintf(fp, "%d,%d,%zu\n", c.max_threads, c.teams[k], c.from_bytes[k]);
+    }
+    fclose(fp);
+    return 0;
+}
+
+// The stored crossover for max_threads ($REDUCE_CROSSOVER or ./reduce_crossover.csv),
+// calibrated and added to the file on first use
+inline ReduceCrossover reduce_crossover_default(int max_threads) {
+    const char* path = getenv("REDUCE_CROSSOVER") ? getenv("REDUCE_CROSSOVER") : REDUCE_CROSSOVER_FILE;
+    if (max_threads < 1) max_threads = 1;
+    std::vector<ReduceCrossover> all;
+    reduce_crossover_read(path, all);
+    for (const ReduceCrossover& c : all) {
+        if (c.max_threads == max_threads) return c;
+    }
+    fprintf(stderr, "Calibrating the sequential/parallel crossover for up to %d threads...\n", max_threads);
+    all.push_back(reduce_crossover_calibrate(max_threads));
+    if (reduce_crossover_save(path, all) != 0) fprintf(stderr, "Could not write %s\n", path);
+    return all.back();
+}
+
+// Sequential fold, a small team or max_threads, whichever the crossover says is fastest for n
+template <typename T, typename Op>
+typename Op::result_type parallel_reduce_adaptive(const T* data, size_t n, const ReduceCrossover& crossover,
+                                                  int* team_used = NULL) {
+    int team = crossover.team_for(n * sizeof(T));
+    if (team_used) *team_used = team;
+    if (team == 1) return reduce_sequential<T, Op>(data, n);
+    return parallel_reduce<T, Op>(data, n, team);
+}
+
+#endif
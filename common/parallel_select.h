@@ -0,0 +1,362 @@
+#ifndef PARALLEL_SELECT_H
+#define PARALLEL_SELECT_H
+
+/*
+ * Parallel selection: top-k, order statistics and quantiles without sorting.
+ * Everything runs on parallel_reduce_chunks() (same chunking, same join tree
+ * as the min/max reduction) and never modifies the input.
+ *
+ * parallel_top_k<T>(data, n, k, threads) - the k largest, largest first.
+ *   Each thread keeps a k-element min-heap of its chunk, so once the heap is
+ *   full an element costs one compare against the smallest kept; the heaps
+ *   are merged along the join tree. Meant for small k (up to ~1e4).
+ *
+ * parallel_select<T>(data, n, ranks, threads) - the elements that would sit at
+ *   positions ranks[] of the sorted array (parallel_nth_element for one).
+ *   SELECT_SAMPLE random elements are sorted and, around each rank's position
+ *   in the sample, two splitters lo <= hi are taken SELECT_SPREAD binomial
+ *   standard deviations apart. One parallel pass counts the elements below lo
+ *   and equal to lo or hi, and copies only those strictly between (a few
+ *   percent of n); std::nth_element then finishes on the copy. Duplicates of
+ *   the splitters are counted, never copied, so low-cardinality data (where a
+ *   bracket often collapses to lo == hi) costs no memory. A rank that falls outside its bracket (~1e-4 per
+ *   rank) is retried with the bracket opened on the side it missed, so the
+ *   result is always exact.
+ *
+ * parallel_quantiles<T>(data, n, qs, threads) - exact quantiles at the lower
+ *   nearest rank floor(q * (n - 1)), all from the same pass.
+ *
+ * QuantileSketch<T> - opt-in, approximate. A mergeable compactor sketch (KLL
+ *   with equal level capacities): a level holds up to `capacity` items of
+ *   weight 2^h; a full level is sorted and every other item, from a random
+ *   offset, moves up a level. Memory is capacity * log2(n / capacity) items
+ *   and the rank error is about n / (2 * capacity). Sketches of separate
+ *   chunks or arrays merge(), so parallel_sketch() builds one per thread.
+ *   Sorting every element into level 0 would cost as much as the exact
+ *   select, so parallel_sketch() feeds it a stratified sample instead: one
+ *   random element of each block of 2^h enters level h directly, with h
+ *   chosen to keep about SKETCH_SAMPLE of them (another ~1 / (2 sqrt(sample))
+ *   of rank error). sample = 0 inserts every element.
+ */
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "counter_rng.h"
+#include "parallel_reduce.h"
+
+#define SELECT_SAMPLE 65536     // Splitter sample; below this n, select on a copy directly
+#define SELECT_SPREAD 4.0       // Bracket half-width, in binomial standard deviations
+#define SELECT_BLOCK 4096       // Elements per block in the bracket pass (stays in L1)
+#define SELECT_SEED 0x5e1ec7ULL
+#define SKETCH_CAPACITY 1024
+#define SKETCH_SAMPLE (1 << 20)  // Elements parallel_sketch() actually inserts
+
+// --- Top-k ---
+
+template <typename T, typename Compare = std::less<T>>
+struct TopKOp {
+    struct result_type {
+        size_t k = 0;
+        std::vector<T> heap;    // Heap with the smallest kept element at the front
+    };
+
+    static result_type identity() { return result_type(); }
+
+    static bool later(const T& a, const T& b) { return Compare()(b, a); }
+
+    static void accumulate(result_type& acc, const T& x) {
+        if (acc.heap.size() < acc.k) {
+            acc.heap.push_back(x);
+            std::push_heap(acc.heap.begin(), acc.heap.end(), later);
+        } else if (acc.k > 0 && Compare()(acc.heap.front(), x)) {
+            std::pop_heap(acc.heap.begin(), acc.heap.end(), later);
+            acc.heap.back() = x;
+            std::push_heap(acc.heap.begin(), acc.heap.end(), later);
+        }
+    }
+
+    static void combine(result_type& acc, const result_type& other) {
+        if (other.k > acc.k) acc.k = other.k;
+        for (const T& x : other.heap) accumulate(acc, x);
+    }
+};
+
+// The k greatest elements under Compare (std::greater<T> gives the k smallest), best first
+template <typename T, typename Compare = std::less<T>>
+std::vector<T> parallel_top_k(const T* data, size_t n, size_t k, int threads) {
+    typedef TopKOp<T, Compare> Op;
+    if (k > n) k = n;
+    auto chunk = [data, k](size_t begin, size_t end) {
+        typename Op::result_type acc;
+        acc.k = k;
+        acc.heap.reserve(k);
+        for (size_t i = begin; i < end; i++) Op::accumulate(acc, data[i]);
+        return acc;
+    };
+    std::vector<T> top = parallel_reduce_chunks<Op>(n, threads, chunk).heap;
+    std::sort_heap(top.begin(), top.end(), Op::later);
+    return top;
+}
+
+// --- Exact selection ---
+
+// Per rank: elements below lo, equal to lo and to hi, and a copy of those strictly between
+template <typename T>
+struct BracketOp {
+    struct result_type {
+        std::vector<size_t> below, at_lo, at_hi;
+        std::vector<std::vector<T>> inside;
+    };
+
+    static result_type identity() { return result_type(); }
+
+    // Chunks are joined in index order; the copies are simply concatenated
+    static void combine(result_type& acc, const result_type& other) {
+        if (acc.below.empty()) {
+            acc = other;
+            return;
+        }
+        for (size_t j = 0; j < other.below.size(); j++) {
+            acc.below[j] += other.below[j];
+            acc.at_lo[j] += other.at_lo[j];
+            acc.at_hi[j] += other.at_hi[j];
+            acc.inside[j].insert(acc.inside[j].end(), other.inside[j].begin(), other.inside[j].end());
+        }
+    }
+};
+
+template <typename T>
+typename BracketOp<T>::result_type select_bracket_pass(const T* data, size_t n, const std::vector<T>& lo,
+                                                       const std::vector<T>& hi, int threads) {
+    typedef BracketOp<T> Op;
+    size_t m = lo.size();
+    auto chunk = [&](size_t begin, size_t end) {
+        typename Op::result_type acc;
+        acc.below.assign(m, 0);
+        acc.at_lo.assign(m, 0);
+        acc.at_hi.assign(m, 0);
+        acc.inside.resize(m);
+        for (size_t b = begin; b < end; b += SELECT_BLOCK) {
+            size_t e = b + SELECT_BLOCK < end ? b + SELECT_BLOCK : end;
+            for (size_t j = 0; j < m; j++) {
+                const T l = lo[j], h = hi[j];
+                size_t below = 0, at_lo = 0, at_hi = 0;
+                for (size_t i = b; i < e; i++) {
+                    below += data[i] < l;
+                    at_lo += !(data[i] < l) && !(l < data[i]);
+                }
+                acc.below[j] += below;
+                acc.at_lo[j] += at_lo;
+                if (!(l < h)) continue;     // Collapsed bracket: lo == hi, nothing in between
+                for (size_t i = b; i < e; i++) {
+                    at_hi += !(data[i] < h) && !(h < data[i]);
+                    if (l < data[i] && data[i] < h) acc.inside[j].push_back(data[i]);
+                }
+                acc.at_hi[j] += at_hi;
+            }
+        }
+        return acc;
+    };
+    return parallel_reduce_chunks<Op>(n, threads, chunk);
+}
+
+// Elements at positions ranks[j] (each < n) of the sorted data
+template <typename T>
+std::vector<T> parallel_select(const T* data, size_t n, const std::vector<size_t>& ranks, int threads) {
+    std::vector<T> result(ranks.size());
+    if (ranks.empty()) return result;
+
+    if (n <= SELECT_SAMPLE) {
+        std::vector<T> copy(data, data + n);
+        for (size_t j = 0; j < ranks.size(); j++) {
+            std::nth_element(copy.begin(), copy.begin() + ranks[j], copy.end());
+            result[j] = copy[ranks[j]];
+        }
+        return result;
+    }
+
+    std::vector<T> sample(SELECT_SAMPLE);
+    uint64_t key = rng_key(SELECT_SEED, n);
+    for (size_t i = 0; i < SELECT_SAMPLE; i++) sample[i] = data[rng_hash(key, i) % n];
+    std::sort(sample.begin(), sample.end());
+
+    // Bracket around where rank r's value sits in the sample
+    std::vector<size_t> pending;
+    std::vector<T> lo, hi;
+    for (size_t j = 0; j < ranks.size(); j++) {
+        double p = (double)ranks[j] / (n - 1);
+        double centre = p * (SELECT_SAMPLE - 1);
+        double spread = SELECT_SPREAD * sqrt(SELECT_SAMPLE * p * (1.0 - p)) + 1.0;
+        long l = (long)floor(centre - spread), h = (long)ceil(centre + spread);
+        lo.push_back(sample[l < 0 ? 0 : l]);
+        hi.push_back(sample[h >= SELECT_SAMPLE ? SELECT_SAMPLE - 1 : h]);
+        pending.push_back(j);
+    }
+
+    while (!pending.empty()) {
+        typename BracketOp<T>::result_type pass = select_bracket_pass(data, n, lo, hi, threads);
+        std::vector<size_t> missed;
+        std::vector<T> missed_lo, missed_hi;
+        for (size_t q = 0; q < pending.size(); q++) {
+            size_t r = ranks[pending[q]], below = pass.below[q];
+            std::vector<T>& inside = pass.inside[q];
+            if (r >= below) {
+                // Sorted, the bracket is at_lo copies of lo, then inside, then at_hi copies of hi
+                size_t off = r - below;
+                if (off < pass.at_lo[q]) {
+                    result[pending[q]] = lo[q];
+                    continue;
+                }
+                off -= pass.at_lo[q];
+                if (off < inside.size()) {
+                    std::nth_element(inside.begin(), inside.begin() + off, inside.end());
+                    result[pending[q]] = inside[off];
+                    continue;
+                }
+                off -= inside.size();
+                if (off < pass.at_hi[q]) {
+                    result[pending[q]] = hi[q];
+                    continue;
+                }
+            }
+            // The sample misled us: open the bracket on the side the rank fell
+            missed.push_back(pending[q]);
+            missed_lo.push_back(r < below ? std::numeric_limits<T>::lowest() : hi[q]);
+            missed_hi.push_back(r < below ? lo[q] : std::numeric_limits<T>::max());
+        }
+        pending.swap(missed);
+        lo.swap(missed_lo);
+        hi.swap(missed_hi);
+    }
+    return result;
+}
+
+template <typename T>
+T parallel_nth_element(const T* data, size_t n, size_t rank, int threads) {
+    return parallel_select(data, n, std::vector<size_t>(1, rank), threads)[0];
+}
+
+inline size_t quantile_rank(double q, size_t n) {
+    if (n == 0) return 0;
+    if (q <= 0.0) return 0;
+    if (q >= 1.0) return n - 1;
+    return (size_t)(q * (n - 1));
+}
+
+template <typename T>
+std::vector<T> parallel_quantiles(const T* data, size_t n, const std::vector<double>& qs, int threads) {
+    std::vector<size_t> ranks;
+    for (double q : qs) ranks.push_back(quantile_rank(q, n));
+    return parallel_select(data, n, ranks, threads);
+}
+
+// --- Approximate quantiles ---
+
+template <typename T>
+struct QuantileSketch {
+    size_t capacity = 0;
+    uint64_t key = 0;
+    uint64_t compactions = 0;           // Counter for the offset coin flips
+    size_t count = 0;
+    std::vector<std::vector<T>> levels; // Items of levels[h] weigh 2^h
+
+    QuantileSketch() {}
+    QuantileSketch(size_t capacity, uint64_t key) : capacity(capacity < 2 ? 2 : capacity), key(key), levels(1) {}
+
+    void insert(const T& x) {
+        levels[0].push_back(x);
+        count++;
+        if (levels[0].size() >= capacity) compact(0);
+    }
+
+    // Adds data[begin, end) as one random element per block of 2^h, at level h;
+    // a short last block is inserted element by element
+    void insert_sampled(const T* data, size_t begin, size_t end, unsigned h) {
+        size_t block = (size_t)1 << h;
+        uint64_t pick = rng_key(key, UINT64_MAX);
+        while (levels.size() <= h) levels.emplace_back();
+        size_t i = begin;
+        for (; block > 1 && i + block <= end; i += block) {
+            levels[h].push_back(data[i + (rng_hash(pick, i) & (block - 1))]);
+            count += block;
+            if (levels[h].size() >= capacity) compact(h);
+        }
+        for (; i < end; i++) insert(data[i]);
+    }
+
+    // Sorts level h and promotes one of each pair; an odd item out stays
+    void compact(size_t h) {
+        if (levels.size() == h + 1) levels.emplace_back();
+        std::vector<T>& v = levels[h];
+        std::vector<T>& up = levels[h + 1];
+        std::sort(v.begin(), v.end());
+        size_t offset = rng_hash(key, compactions++) & 1;
+        size_t pairs = v.size() / 2;
+        for (size_t i = 0; i < pairs; i++) up.push_back(v[2 * i + offset]);
+        if (v.size() & 1) v[0] = v.back();
+        v.resize(v.size() & 1);
+        if (up.size() >= capacity) compact(h + 1);
+    }
+
+    void merge(const QuantileSketch& other) {
+        if (other.capacity == 0) return;
+        if (capacity == 0) {
+            *this = other;
+            return;
+        }
+        if (levels.size() < other.levels.size()) levels.resize(other.levels.size());
+        for (size_t h = 0; h < other.levels.size(); h++) {
+            levels[h].insert(levels[h].end(), other.levels[h].begin(), other.levels[h].end());
+        }
+        count += other.count;
+        key = rng_hash(key, other.key);
+        for (size_t h = 0; h < levels.size(); h++) {
+            if (levels[h].size() >= capacity) compact(h);
+        }
+    }
+
+    // Estimate of the element at the lower nearest rank floor(q * (count - 1))
+    T quantile(double q) const {
+        std::vector<std::pair<T, uint64_t>> items;
+        for (size_t h = 0; h < levels.size(); h++) {
+            for (const T& x : levels[h]) items.push_back(std::make_pair(x, (uint64_t)1 << h));
+        }
+        if (items.empty()) return T();
+        std::sort(items.begin(), items.end());
+        uint64_t target = quantile_rank(q, count), seen = 0;
+        for (const std::pair<T, uint64_t>& item : items) {
+            seen += item.second;
+            if (seen > target) return item.first;
+        }
+        return items.back().first;
+    }
+};
+
+template <typename T>
+struct SketchOp {
+    typedef QuantileSketch<T> result_type;
+    static result_type identity() { return result_type(); }
+    static void combine(result_type& acc, const result_type& other) { acc.merge(other); }
+};
+
+// One sketch per chunk, merged along the join tree
+template <typename T>
+QuantileSketch<T> parallel_sketch(const T* data, size_t n, int threads, size_t capacity = SKETCH_CAPACITY,
+                                  size_t sample = SKETCH_SAMPLE) {
+    unsigned h = 0;
+    while (sample > 0 && (n >> (h + 1)) >= sample) h++;
+    auto chunk = [data, capacity, h](size_t begin, size_t end) {
+        QuantileSketch<T> sketch(capacity, rng_key(SELECT_SEED, begin));
+        sketch.insert_sampled(data, begin, end, h);
+        return sketch;
+    };
+    return parallel_reduce_chunks<SketchOp<T>>(n, threads, chunk);
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+/*
+ * Minimal hardware counter wrapper over perf_event_open(2).
+ *
+ * Counters are opened for the calling process with `inherit` set, so threads
+ * created after perf_counter_start() are included once they have been joined.
+ * When counters are unavailable (no PMU in a VM, perf_event_paranoid too
+ * high) every call degrades to a no-op and perf_counter_stop() returns -1, so
+ * benchmarks keep running and just report the count as missing.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define PERF_CACHE_CONFIG(cache, op, result) \
+    ((uint64_t)(cache) | ((uint64_t)(op) << 8) | ((uint64_t)(result) << 16))
+
+// Last-level cache read misses
+#define PERF_LLC_MISSES \
+    PERF_TYPE_HW_CACHE, PERF_CACHE_CONFIG(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)
+
+// Data TLB load misses
+#define PERF_DTLB_MISSES \
+    PERF_TYPE_HW_CACHE, PERF_CACHE_CONFIG(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)
+
+typedef struct {
+    int fd;
+} PerfCounter;
+
+static inline int perf_counter_open(PerfCounter *pc, uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    pc->fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    return pc->fd >= 0 ? 0 : -1;
+}
+
+static inline void perf_counter_start(PerfCounter *pc) {
+    if (pc->fd < 0) return;
+    ioctl(pc->fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(pc->fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+// Count since the last start, or -1 if the counter could not be opened
+static inline long long perf_counter_stop(PerfCounter *pc) {
+    if (pc->fd < 0) return -1;
+    ioctl(pc->fd, PERF_EVENT_IOC_DISABLE, 0);
+    long long value = 0;
+    if (read(pc->fd, &value, sizeof(value)) != (ssize_t)sizeof(value)) return -1;
+    return value;
+}
+
+static inline void perf_counter_close(PerfCounter *pc) {
+    if (pc->fd >= 0) close(pc->fd);
+    pc->fd = -1;
+}
+
+#endif
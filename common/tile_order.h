@@ -0,0 +1,93 @@
+#ifndef TILE_ORDER_H
+#define TILE_ORDER_H
+
+/*
+ * Tile traversal orders for tiled kernels.
+ *
+ * Row-major tile order jumps back to column 0 at the end of every tile row,
+ * so the tiles visited just before and after the jump share nothing. A
+ * Hilbert curve always steps to an adjacent tile, and a Morton (Z) curve
+ * mostly does, so consecutive tiles (and neighbouring threads) keep touching
+ * the same rows/columns of the operands.
+ *
+ * tile_order_build() lists the tiles of a tiles_y x tiles_x grid in curve
+ * order as flat indices (ty * tiles_x + tx). tile_order_segment() then gives
+ * each thread one contiguous piece of that list.
+ */
+
+typedef enum {
+    TILE_ROW_MAJOR = 0,
+    TILE_MORTON,
+    TILE_HILBERT
+} TileOrderKind;
+
+static inline const char* tile_order_name(TileOrderKind kind) {
+    switch (kind) {
+    case TILE_MORTON:  return "Morton";
+    case TILE_HILBERT: return "Hilbert";
+    default:           return "RowMajor";
+    }
+}
+
+// Position d on the Hilbert curve of an n x n grid (n a power of 2) -> (x, y)
+static inline void hilbert_d2xy(int n, long long d, int *x, int *y) {
+    long long t = d;
+    *x = *y = 0;
+    for (int s = 1; s < n; s *= 2) {
+        int rx = (int)(1 & (t / 2));
+        int ry = (int)(1 & (t ^ rx));
+        if (ry == 0) {
+            if (rx == 1) {
+                *x = s - 1 - *x;
+                *y = s - 1 - *y;
+            }
+            int tmp = *x; *x = *y; *y = tmp;
+        }
+        *x += s * rx;
+        *y += s * ry;
+        t /= 4;
+    }
+}
+
+// Position d on the Morton curve -> (x, y): x from the even bits, y from the odd bits
+static inline void morton_d2xy(long long d, int *x, int *y) {
+    *x = *y = 0;
+    for (int bit = 0; bit < 31; bit++) {
+        *x |= (int)((d >> (2 * bit)) & 1) << bit;
+        *y |= (int)((d >> (2 * bit + 1)) & 1) << bit;
+    }
+}
+
+/*
+ * Fills order[0 .. tiles_y*tiles_x) with tile indices in the given order and
+ * returns the count. Grids that are not a power-of-two square are walked on
+ * the enclosing power-of-two curve, skipping tiles that fall outside.
+ */
+static inline int tile_order_build(TileOrderKind kind, int tiles_y, int tiles_x, int *order) {
+    int count = 0;
+    if (kind == TILE_ROW_MAJOR) {
+        for (int ty = 0; ty < tiles_y; ty++)
+            for (int tx = 0; tx < tiles_x; tx++)
+                order[count++] = ty * tiles_x + tx;
+        return count;
+    }
+
+    int side = 1;
+    while (side < tiles_x || side < tiles_y) side *= 2;
+
+    for (long long d = 0; d < (long long)side * side; d++) {
+        int tx, ty;
+        if (kind == TILE_HILBERT) hilbert_d2xy(side, d, &tx, &ty);
+        else morton_d2xy(d, &tx, &ty);
+        if (tx < tiles_x && ty < tiles_y) order[count++] = ty * tiles_x + tx;
+    }
+    return count;
+}
+
+// Contiguous [begin, end) slice of a `count`-long tile order for thread `tid`
+static inline void tile_order_segment(int count, int tid, int threads, int *begin, int *end) {
+    *begin = (int)((long long)count * tid / threads);
+    *end = (int)((long long)count * (tid + 1) / threads);
+}
+
+#endif